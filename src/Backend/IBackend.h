@@ -55,7 +55,12 @@ class IBackend
         virtual IInfo*                                        filterInfo( const std::string& id ) const = 0;
         virtual IInfo*                                        transitionInfo( const std::string& id ) const = 0;
 
+        /// An empty handler drops the backend's messages from then on
         virtual void                        setLogHandler( LogHandler logHandler ) = 0;
+        /**
+         *  \brief Messages below this level are discarded before being formatted.
+         */
+        virtual void                        setLogLevel( LogLevel logLevel ) = 0;
 };
 
 extern IBackend* instance();
@@ -24,11 +24,13 @@
 #define IINPUT_H
 
 #include <cstdint>
+#include <functional>
 #include <memory>
 
 namespace Backend
 {
     class IFilter;
+    class KeyframeIndex;
     class IInputEventCb
     {
     public:
@@ -87,6 +89,25 @@ namespace Backend
 
         // Generates an 32-bit RGBA image at the current position
         virtual uint8_t*        image( uint32_t width, uint32_t height ) const = 0;
+        // Copies a 32-bit RGBA image at the current position into buffer, which must hold
+        // width * height * 4 bytes. Returns false if no image of this size could be made.
+        virtual bool            image( uint8_t* buffer, uint32_t width, uint32_t height ) const = 0;
+
+        // Decodes the first frames at the given size, so that playing the input doesn't
+        // wait for its source to be opened & seeked. Can be called from any thread: each
+        // frame is decoded while holding graph, the input this one's source is played
+        // through, like its outputs do. Stops once cancelled() returns true, which is
+        // called while holding it too.
+        virtual void            prefetch( int64_t nbFrames, int width, int height, IInput& graph,
+                                          const std::function<bool()>& cancelled ) = 0;
+
+        // Shares the keyframe index of the source with this input and all its cuts
+        virtual void            setKeyframeIndex( std::shared_ptr<const KeyframeIndex> index ) = 0;
+        virtual std::shared_ptr<const KeyframeIndex>    keyframeIndex() const = 0;
+        // The position of the keyframe at or before position, or -1 if it isn't known
+        virtual int64_t         keyframeBefore( int64_t position ) const = 0;
+        // The position of the first keyframe after position, or -1 if it isn't known
+        virtual int64_t         keyframeAfter( int64_t position ) const = 0;
 
         virtual double          fps() const = 0;
         virtual double          aspectRatio() const = 0;
@@ -100,6 +121,9 @@ namespace Backend
         virtual void            playPause() = 0;
         virtual void            setPause( bool isPaused ) = 0;
         virtual bool            isPaused() const = 0;
+        // Negative speeds play backward. 0 pauses, as setPause( true ) does.
+        virtual void            setSpeed( double speed ) = 0;
+        virtual double          speed() const = 0;
         virtual void            nextFrame() = 0;
         virtual void            previousFrame() = 0;
 
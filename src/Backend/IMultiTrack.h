@@ -46,6 +46,14 @@ namespace Backend
         virtual void        addFilter( IFilter& filter, int track = 0 ) = 0;
         virtual bool        connect( IInput& input ) = 0;
         virtual void        hide( HideType hideType, int index ) = 0;
+
+        /**
+         * The outputs see the changes made to the graph between beginEdit() and endEdit()
+         * all at once: they produce their frames either before or after the edit.
+         * Calls can be nested, only the outermost endEdit() publishes the changes.
+         */
+        virtual void        beginEdit() = 0;
+        virtual void        endEdit() = 0;
     };
 }
 
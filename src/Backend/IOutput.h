@@ -26,11 +26,57 @@
 #include <string>
 #include <cstdint>
 #include <cstddef>
+#include <vector>
+
+#include "Tools/FrameMailbox.h"
+#include "Tools/PerfCounters.h"
 
 namespace Backend
 {
     class IInput;
 
+    /**
+     * @brief A copy of a frame produced by an output
+     */
+    struct VideoFrame
+    {
+        int                     width;
+        int                     height;
+        int64_t                 position;
+        /// When the output produced the frame, in µs of std::chrono::steady_clock
+        int64_t                 time;
+        /// RGBA, 8 bits per component
+        std::vector<uint8_t, PerfCounters::Allocator<uint8_t, PerfCounters::FrameMemory>>  pixels;
+    };
+
+    /**
+     * @brief Receives the audio of an output instead of an audio device
+     */
+    class IAudioSink
+    {
+    public:
+        virtual ~IAudioSink() = default;
+        /**
+         * Called from the output thread with the audio of each frame.
+         * @param samples   Interleaved, signed 16 bits
+         */
+        virtual void    onAudio( const int16_t* samples, int nbSamples, int channels, int frequency ) = 0;
+    };
+
+    /**
+     * @brief Notified when an output delivering its frames in process has a new one
+     */
+    class IFrameSink
+    {
+    public:
+        virtual ~IFrameSink() = default;
+        /**
+         * Called from the output thread. The frame is to be fetched from the output,
+         * from any single thread.
+         */
+        virtual void    onFrameReady() = 0;
+    };
+
     class IOutputEventCb
     {
     public:
@@ -39,6 +85,15 @@ namespace Backend
         virtual void    onStopped() = 0;
         virtual void    onVolumeChanged() = 0;
         virtual void    onErrorEncountered() = 0;
+        /**
+         * @brief onPlaybackStats   Reports how well a realtime output keeps up
+         *
+         * Called from the output thread when the counters change, at most a few times
+         * per second. Both counters are reset when the output starts.
+         * @param droppedFrames The frames skipped to stay in sync with the audio
+         * @param lateFrames    The frames displayed after their presentation time
+         */
+        virtual void    onPlaybackStats( int64_t droppedFrames, int64_t lateFrames ) = 0;
     };
 
     class IOutput
@@ -60,6 +115,40 @@ namespace Backend
 
         virtual bool    connect( IInput& input ) = 0;
         virtual bool    isConnected() const = 0;
+
+        /**
+         * @brief frameWidth, frameHeight   The size of the frames this output asks its
+         *                                  input for, which can be below the profile's.
+         */
+        virtual int     frameWidth() const = 0;
+        virtual int     frameHeight() const = 0;
+
+        /**
+         * @brief setFrameTap   Publish a downscaled copy of the produced frames
+         *
+         * The frames are copied from the output thread once they have been produced,
+         * so the tap doesn't pull anything from the input. A frame is only published
+         * once the previous one was taken, and at most every \p interval milliseconds.
+         * @param mailbox   Where to publish the frames. nullptr disables the tap.
+         *                  It must outlive the output, or be removed before: this
+         *                  waits for a frame being published to the previous mailbox.
+         * @param width     The maximum size of the published frames. The aspect ratio
+         * @param height    of the produced frames is kept.
+         */
+        virtual void    setFrameTap( FrameMailbox<VideoFrame>* mailbox, int width, int height,
+                                     int interval ) = 0;
+
+        /**
+         * @brief setScrubbing  Play a short audio snippet with each frame shown while paused
+         *
+         * The snippet comes with the frame, so it costs no decoding of its own.
+         */
+        virtual void    setScrubbing( bool scrubbing ) = 0;
+        /**
+         * @brief purge Drop the frames produced ahead of the current position, so that
+         *              the next one shown follows the last seek.
+         */
+        virtual void    purge() = 0;
     };
 }
 
@@ -0,0 +1,230 @@
+/*****************************************************************************
+ * KeyframeIndex.cpp: Positions of the keyframes of a media
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "KeyframeIndex.h"
+
+#ifdef HAVE_LIBAVFORMAT
+extern "C"
+{
+# include <libavformat/avformat.h>
+}
+#endif
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+
+using namespace Backend;
+
+namespace
+{
+
+const char          Magic[4] = { 'V', 'K', 'F', 'I' };
+const uint32_t      Version = 1;
+
+struct Header
+{
+    char        magic[4];
+    uint32_t    version;
+    int64_t     sourceSize;
+    int64_t     sourceMtime;
+    uint64_t    count;
+};
+
+inline int64_t
+toFrame( int64_t time, double fps )
+{
+    return std::llround( time * fps / 1000000.0 );
+}
+
+inline int64_t
+toTime( int64_t frame, double fps )
+{
+    return std::llround( frame * 1000000.0 / fps );
+}
+
+}
+
+bool
+KeyframeIndex::build( const std::string& path, const std::atomic_bool* abort )
+{
+    m_keyframes.clear();
+#ifdef HAVE_LIBAVFORMAT
+    AVFormatContext* ctx = nullptr;
+    if ( avformat_open_input( &ctx, path.c_str(), nullptr, nullptr ) < 0 )
+        return false;
+    if ( avformat_find_stream_info( ctx, nullptr ) < 0 )
+    {
+        avformat_close_input( &ctx );
+        return false;
+    }
+    const int stream = av_find_best_stream( ctx, AVMEDIA_TYPE_VIDEO, -1, -1, nullptr, 0 );
+    if ( stream < 0 )
+    {
+        avformat_close_input( &ctx );
+        return false;
+    }
+    // Only the video packets are read, and nothing gets decoded
+    for ( unsigned int i = 0; i < ctx->nb_streams; ++i )
+    {
+        if ( static_cast<int>( i ) != stream )
+            ctx->streams[i]->discard = AVDISCARD_ALL;
+    }
+    const auto st = ctx->streams[stream];
+    const int64_t start = st->start_time != AV_NOPTS_VALUE ? st->start_time : 0;
+    const AVRational microseconds = { 1, 1000000 };
+
+    bool res = true;
+    auto packet = av_packet_alloc();
+    while ( av_read_frame( ctx, packet ) >= 0 )
+    {
+        if ( packet->stream_index == stream && ( packet->flags & AV_PKT_FLAG_KEY ) != 0 )
+        {
+            const auto ts = packet->pts != AV_NOPTS_VALUE ? packet->pts : packet->dts;
+            if ( ts != AV_NOPTS_VALUE )
+                m_keyframes.push_back( { av_rescale_q( ts - start, st->time_base, microseconds ),
+                                         ts, packet->pos } );
+        }
+        av_packet_unref( packet );
+        if ( abort != nullptr && *abort == true )
+        {
+            res = false;
+            break;
+        }
+    }
+    av_packet_free( &packet );
+    avformat_close_input( &ctx );
+
+    std::sort( begin( m_keyframes ), end( m_keyframes ), []( const Keyframe& a, const Keyframe& b ) {
+        return a.time < b.time;
+    });
+    if ( res == false )
+        m_keyframes.clear();
+    return res;
+#else
+    (void)path;
+    (void)abort;
+    return false;
+#endif
+}
+
+bool
+KeyframeIndex::load( const std::string& path, int64_t sourceSize, int64_t sourceMtime )
+{
+    std::ifstream file( path, std::ios::binary );
+    Header header;
+    if ( file.read( reinterpret_cast<char*>( &header ), sizeof( header ) ).good() == false )
+        return false;
+    if ( memcmp( header.magic, Magic, sizeof( Magic ) ) != 0 || header.version != Version ||
+         header.sourceSize != sourceSize || header.sourceMtime != sourceMtime )
+        return false;
+    // Don't trust the count of a truncated or corrupted cache to size the buffer
+    const auto dataStart = file.tellg();
+    if ( file.seekg( 0, std::ios::end ).good() == false )
+        return false;
+    const auto dataSize = static_cast<uint64_t>( file.tellg() - dataStart );
+    if ( header.count != dataSize / sizeof( Keyframe ) || dataSize % sizeof( Keyframe ) != 0 ||
+         file.seekg( dataStart ).good() == false )
+        return false;
+    Keyframes keyframes( header.count );
+    if ( file.read( reinterpret_cast<char*>( keyframes.data() ),
+                    keyframes.size() * sizeof( Keyframe ) ).good() == false )
+        return false;
+    m_keyframes = std::move( keyframes );
+    return true;
+}
+
+bool
+KeyframeIndex::save( const std::string& path, int64_t sourceSize, int64_t sourceMtime ) const
+{
+    // This is a local cache, so the native byte order is used
+    Header header;
+    memcpy( header.magic, Magic, sizeof( Magic ) );
+    header.version = Version;
+    header.sourceSize = sourceSize;
+    header.sourceMtime = sourceMtime;
+    header.count = m_keyframes.size();
+    std::ofstream file( path, std::ios::binary | std::ios::trunc );
+    file.write( reinterpret_cast<const char*>( &header ), sizeof( header ) );
+    file.write( reinterpret_cast<const char*>( m_keyframes.data() ),
+                m_keyframes.size() * sizeof( Keyframe ) );
+    return file.good();
+}
+
+bool
+KeyframeIndex::isEmpty() const
+{
+    return m_keyframes.empty();
+}
+
+size_t
+KeyframeIndex::size() const
+{
+    return m_keyframes.size();
+}
+
+const KeyframeIndex::Keyframes&
+KeyframeIndex::keyframes() const
+{
+    return m_keyframes;
+}
+
+int64_t
+KeyframeIndex::keyframeBefore( int64_t frame, double fps ) const
+{
+    if ( m_keyframes.empty() == true || fps <= 0 )
+        return -1;
+    // Allow half a frame of rounding between the stream & the requested frame rate
+    const auto time = toTime( frame, fps ) + toTime( 1, fps ) / 2;
+    auto it = std::upper_bound( begin( m_keyframes ), end( m_keyframes ), time,
+                                []( int64_t t, const Keyframe& k ) { return t < k.time; } );
+    if ( it == begin( m_keyframes ) )
+        return 0;
+    return toFrame( ( it - 1 )->time, fps );
+}
+
+int64_t
+KeyframeIndex::keyframeAfter( int64_t frame, double fps ) const
+{
+    if ( fps <= 0 )
+        return -1;
+    const auto time = toTime( frame, fps ) + toTime( 1, fps ) / 2;
+    auto it = std::upper_bound( begin( m_keyframes ), end( m_keyframes ), time,
+                                []( int64_t t, const Keyframe& k ) { return t < k.time; } );
+    if ( it == end( m_keyframes ) )
+        return -1;
+    return toFrame( it->time, fps );
+}
+
+int64_t
+KeyframeIndex::maxGopLength( double fps ) const
+{
+    int64_t res = 0;
+    for ( size_t i = 1; i < m_keyframes.size(); ++i )
+        res = std::max( res, toFrame( m_keyframes[i].time, fps ) - toFrame( m_keyframes[i - 1].time, fps ) );
+    return res;
+}
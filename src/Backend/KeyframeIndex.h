@@ -0,0 +1,99 @@
+/*****************************************************************************
+ * KeyframeIndex.h: Positions of the keyframes of a media
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef KEYFRAMEINDEX_H
+#define KEYFRAMEINDEX_H
+
+#include "Tools/PerfCounters.h"
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace Backend
+{
+
+/**
+ * \brief  The keyframes of the first video stream of a file.
+ *
+ * Seeking always starts decoding from the previous keyframe, so knowing where keyframes
+ * are tells how much needs to be decoded to reach a frame, and allows to target whole
+ * GOPs. The index is built by demuxing the file, without decoding anything, and can be
+ * saved to avoid scanning the file again.
+ * Frame numbers are expressed at the frame rate given to the queries, so that they match
+ * the positions of the inputs playing the file.
+ */
+class KeyframeIndex
+{
+    public:
+        struct Keyframe
+        {
+            /// The presentation time, relative to the start of the stream, in microseconds
+            int64_t     time;
+            /// The presentation timestamp, in the stream timebase
+            int64_t     pts;
+            /// The offset of the packet in the file, or -1 if unknown
+            int64_t     offset;
+        };
+        typedef std::vector<Keyframe, PerfCounters::Allocator<Keyframe, PerfCounters::CacheMemory>>   Keyframes;
+
+        /**
+         * \brief  Scan the file to find its keyframes
+         * \param  abort   Checked between each packet to interrupt the scan
+         * \return false if the file can't be read, or if keyframe indexing isn't supported
+         *         by this build.
+         */
+        bool            build( const std::string& path, const std::atomic_bool* abort = nullptr );
+
+        /**
+         * \brief  Load an index saved for a source of the given size & modification time
+         * \return false if there's no such index, or if the source changed since then
+         */
+        bool            load( const std::string& path, int64_t sourceSize, int64_t sourceMtime );
+        bool            save( const std::string& path, int64_t sourceSize, int64_t sourceMtime ) const;
+
+        bool            isEmpty() const;
+        size_t          size() const;
+        const Keyframes&    keyframes() const;
+
+        /**
+         * \return The keyframe at or before \p frame, or -1 if the index is empty
+         */
+        int64_t         keyframeBefore( int64_t frame, double fps ) const;
+        /**
+         * \return The first keyframe after \p frame, or -1 if there is none
+         */
+        int64_t         keyframeAfter( int64_t frame, double fps ) const;
+        /**
+         * \return The length of the longest GOP, in frames. Reaching any frame never
+         *         requires decoding more than this.
+         */
+        int64_t         maxGopLength( double fps ) const;
+
+    private:
+        Keyframes               m_keyframes;
+};
+
+}
+
+#endif // KEYFRAMEINDEX_H
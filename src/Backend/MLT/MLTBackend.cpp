@@ -33,11 +33,11 @@
 #include <mlt++/MltService.h>
 
 #include <mlt/framework/mlt_log.h>
+#include <mlt/framework/mlt_service.h>
 
 #include "MLTFilter.h"
 
-#include <mutex>
-#include <sstream>
+#include <cstdio>
 
 #include "Tools/VlmcDebug.h"
 #include "vlmc.h"
@@ -47,7 +47,9 @@ using namespace Backend::MLT;
 
 
 static Backend::IBackend::LogHandler    staticLogHandler;
-static std::mutex                       logMutex;
+// Longer messages are truncated
+static const int                        LogMessageSize = 1024;
+static const int                        OpenSourcesCacheSize = 16;
 
 IBackend*
 Backend::instance()
@@ -59,6 +61,10 @@ MLTBackend::MLTBackend()
 {
     m_mltRepo = Mlt::Factory::init();
     m_profile.setFrameRate( 2997, 100 );
+    // MLT only keeps a few avformat producers open, and closes the least recently used
+    // ones. Keep enough of them so that sources which were prefetched, or which the
+    // timeline alternates between, don't get reopened & seeked again.
+    mlt_service_cache_set_size( nullptr, "producer_avformat", OpenSourcesCacheSize );
 
     for ( int i = 0; i < m_mltRepo->filters()->count(); ++i )
     {
@@ -134,29 +140,33 @@ MLTBackend::transitionInfo( const std::string& id ) const
 void
 MLTBackend::setLogHandler( IBackend::LogHandler logHandler )
 {
+    if ( !logHandler )
+    {
+        // Replace the callback first, so that MLT stops calling the handler going away
+        mlt_log_set_callback( []( void*, int, const char*, va_list ) {} );
+        staticLogHandler = nullptr;
+        return;
+    }
     staticLogHandler = logHandler;
+    // Called concurrently from the MLT threads: format on the stack, without locking
     mlt_log_set_callback( []( void* ptr, int level, const char* format, va_list vl )
     {
-        std::string msg_str;
+        char buffer[LogMessageSize];
+        int len = 0;
 
         if ( ptr != nullptr )
         {
             auto mltType = mlt_properties_get( MLT_SERVICE_PROPERTIES( ( mlt_service )ptr ), "mlt_type" );
             auto mltService = mlt_properties_get( MLT_SERVICE_PROPERTIES( ( mlt_service )ptr ), "mlt_service" );
-            std::ostringstream os;
 
             if ( mltService && mltType )
-                os << "[" << mltType << " " << mltService << "] ";
+                len = snprintf( buffer, sizeof( buffer ), "[%s %s] ", mltType, mltService );
             else if ( mltType )
-            {
-                os << "[" << mltType << " " << ptr << "] ";
-            }
-
-            msg_str = os.str();
+                len = snprintf( buffer, sizeof( buffer ), "[%s %p] ", mltType, ptr );
+            if ( len < 0 || len >= LogMessageSize )
+                len = 0;
         }
 
-        char* buffer = nullptr;
-
         auto lvl = IBackend::None;
         if ( MLT_LOG_INFO <= level )
             lvl = IBackend::Debug;
@@ -165,17 +175,33 @@ MLTBackend::setLogHandler( IBackend::LogHandler logHandler )
         else
             lvl = IBackend::Error;
 
-        std::lock_guard<std::mutex> lock( logMutex );
-
-        if ( vasprintf( &buffer, format, vl ) < 0 )
+        if ( vsnprintf( buffer + len, sizeof( buffer ) - len, format, vl ) < 0 )
             return;
 
-        if ( buffer )
-            msg_str += buffer;
-
-        if ( !msg_str.empty() )
-            staticLogHandler( lvl, msg_str.c_str() );
-
-        free( buffer );
+        if ( buffer[0] != 0 )
+            staticLogHandler( lvl, buffer );
     } );
 }
+
+void
+MLTBackend::setLogLevel( IBackend::LogLevel logLevel )
+{
+    // MLT compares the level before calling the callback, so nothing gets formatted
+    int level;
+    switch ( logLevel )
+    {
+    case Debug:
+        level = MLT_LOG_DEBUG;
+        break;
+    case Warning:
+        level = MLT_LOG_WARNING;
+        break;
+    case Error:
+        level = MLT_LOG_ERROR;
+        break;
+    default:
+        level = MLT_LOG_QUIET;
+        break;
+    }
+    mlt_log_set_level( level );
+}
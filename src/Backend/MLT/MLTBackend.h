@@ -59,6 +59,7 @@ class MLTBackend : public IBackend, public Singleton<MLTBackend>
         virtual IInfo*                                       transitionInfo( const std::string& id ) const override;
 
         virtual void            setLogHandler( LogHandler logHandler ) override;
+        virtual void            setLogLevel( LogLevel logLevel ) override;
 
     private:
         MLTBackend();
@@ -33,6 +33,7 @@
 #include "Backend/IBackend.h"
 #include "MLTProfile.h"
 #include "MLTInput.h"
+#include "MLTPipelineProbe.h"
 
 using namespace Backend::MLT;
 
@@ -42,6 +43,7 @@ MLTFilter::MLTFilter( Backend::IProfile& profile, const char* id )
     m_filter = new Mlt::Filter( *mltProfile.m_profile, id );
     if ( isValid() == false )
         throw InvalidServiceException();
+    MLTPipelineProbe::instrument( *m_filter );
 }
 
 MLTFilter::MLTFilter( const char *id )
@@ -28,12 +28,18 @@
 #include "MLTProfile.h"
 #include "MLTBackend.h"
 #include "MLTFilter.h"
+#include "MLTPipelineProbe.h"
+#include "MLTReverseBuffer.h"
+#include "Backend/KeyframeIndex.h"
+#include "Tools/PerfCounters.h"
 
 #include <mlt++/MltFrame.h>
 #include <mlt++/MltFilter.h>
 #include <mlt++/MltProducer.h>
-#include <cstring>
+#include <algorithm>
 #include <cassert>
+#include <cstring>
+#include <memory>
 
 using namespace Backend::MLT;
 
@@ -44,7 +50,7 @@ MLTInput::MLTInput()
     , m_nbVideoTracks( 0 )
     , m_nbAudioTracks( 0 )
 {
-
+    PerfCounters::add( PerfCounters::Producers );
 }
 
 void
@@ -87,6 +93,28 @@ MLTInput::MLTInput( IProfile& profile, const char* path, IInputEventCb* callback
     calcTracks();
     if ( isValid() == false )
         throw InvalidServiceException();
+    MLTPipelineProbe::instrument( *m_producer );
+}
+
+MLTInput::MLTInput( IProfile& profile, const char* service, const char* argument, int64_t length,
+                    IInputEventCb* callback )
+    : MLTInput()
+{
+    if ( length <= 0 )
+        throw InvalidServiceException();
+    MLTProfile& mltProfile = static_cast<MLTProfile&>( profile );
+    m_producer = new Mlt::Producer( *mltProfile.m_profile, service, argument );
+    if ( isValid() == false )
+        throw InvalidServiceException();
+    m_producer->set( "length", (int)length );
+    m_producer->set_in_and_out( 0, (int)length - 1 );
+    setCallback( callback );
+    // Generators don't describe their streams
+    if ( strcmp( service, "tone" ) != 0 )
+        m_nbVideoTracks = 1;
+    if ( strcmp( service, "tone" ) == 0 || strcmp( service, "noise" ) == 0 )
+        m_nbAudioTracks = 1;
+    MLTPipelineProbe::instrument( *m_producer );
 }
 
 MLTInput::MLTInput( const char* path, IInputEventCb* callback )
@@ -97,6 +125,8 @@ MLTInput::MLTInput( const char* path, IInputEventCb* callback )
 
 MLTInput::~MLTInput()
 {
+    PerfCounters::add( PerfCounters::Producers, -1 );
+    m_reverseBuffer.reset();
     delete m_producer;
 }
 
@@ -132,8 +162,10 @@ MLTInput::onPropertyChanged( void*, MLTInput* self, const char* id )
 
     if ( strcmp( id, "_position" ) == 0 )
     {
-        self->m_callback->onPositionChanged( self->position() );
-        if ( self->position() >= self->playableLength() - 1 )
+        // Runs for every frame, the callback is expected to coalesce the positions
+        const auto position = self->position();
+        self->m_callback->onPositionChanged( position );
+        if ( position >= self->playableLength() - 1 )
             self->m_callback->onEndReached();
     }
     else if ( strcmp( id, "length" ) == 0 )
@@ -247,6 +279,8 @@ MLTInput::position() const
 void
 MLTInput::setPosition( int64_t position )
 {
+    // Only the frames reached backward are served by the buffer
+    m_reverseBuffer.reset();
     producer()->seek( position );
 }
 
@@ -270,6 +304,101 @@ MLTInput::image( uint32_t width, uint32_t height ) const
     return imageFrame->fetch_image( mlt_image_rgb24a, (int)width, (int)height );
 }
 
+bool
+MLTInput::image( uint8_t* buffer, uint32_t width, uint32_t height ) const
+{
+    // The image belongs to the frame, copy it before the frame goes
+    std::unique_ptr<Mlt::Frame> imageFrame( producer()->get_frame() );
+    if ( imageFrame == nullptr || imageFrame->is_valid() == false )
+        return false;
+    mlt_image_format format = mlt_image_rgb24a;
+    int w = (int)width;
+    int h = (int)height;
+    auto image = imageFrame->get_image( format, w, h );
+    if ( image == nullptr || format != mlt_image_rgb24a || w != (int)width || h != (int)height )
+        return false;
+    memcpy( buffer, image, (size_t)width * height * 4 );
+    return true;
+}
+
+void
+MLTInput::prefetch( int64_t nbFrames, int width, int height, IInput& graph,
+                    const std::function<bool()>& cancelled )
+{
+    // The source is shared with the cuts the graph plays. Its outputs hold the graph
+    // while they get a frame, so only use the source between two of their frames.
+    auto mltGraph = dynamic_cast<MLTInput*>( &graph );
+    assert( mltGraph != nullptr );
+    nbFrames = std::min( nbFrames, playableLength() );
+    for ( int64_t i = 0; i < nbFrames; ++i )
+    {
+        mltGraph->producer()->lock();
+        bool decoded = false;
+        if ( cancelled() == false )
+        {
+            producer()->seek( i );
+            std::unique_ptr<Mlt::Frame> frame( producer()->get_frame() );
+            if ( frame != nullptr && frame->is_valid() == true )
+            {
+                // Requesting the picture is what decodes it, and leaves it in the
+                // producer's cache: it must be the size the outputs will ask for.
+                mlt_image_format format = mlt_image_yuv422;
+                int w = width;
+                int h = height;
+                decoded = frame->get_image( format, w, h ) != nullptr;
+            }
+        }
+        mltGraph->producer()->unlock();
+        if ( decoded == false )
+            return;
+    }
+}
+
+// Stored on the parent producer, so that all the cuts of a source share it
+static const char* const    KeyframeIndexProperty = "_vlmc_keyframes";
+
+void
+MLTInput::setKeyframeIndex( std::shared_ptr<const KeyframeIndex> index )
+{
+    auto holder = new std::shared_ptr<const KeyframeIndex>( std::move( index ) );
+    mlt_properties_set_data( producer()->parent().get_properties(), KeyframeIndexProperty, holder, 0,
+                             []( void* h ) { delete static_cast<std::shared_ptr<const KeyframeIndex>*>( h ); },
+                             nullptr );
+}
+
+std::shared_ptr<const KeyframeIndex>
+MLTInput::keyframeIndex() const
+{
+    auto holder = static_cast<std::shared_ptr<const KeyframeIndex>*>(
+                mlt_properties_get_data( producer()->parent().get_properties(), KeyframeIndexProperty, nullptr ) );
+    if ( holder == nullptr )
+        return {};
+    return *holder;
+}
+
+int64_t
+MLTInput::keyframeBefore( int64_t position ) const
+{
+    auto index = keyframeIndex();
+    if ( index == nullptr || index->isEmpty() == true )
+        return -1;
+    // The index works with positions in the source, not in this cut
+    auto res = index->keyframeBefore( position + begin(), fps() );
+    return std::max<int64_t>( 0, res - begin() );
+}
+
+int64_t
+MLTInput::keyframeAfter( int64_t position ) const
+{
+    auto index = keyframeIndex();
+    if ( index == nullptr || index->isEmpty() == true )
+        return -1;
+    auto res = index->keyframeAfter( position + begin(), fps() );
+    if ( res < 0 || res - begin() >= playableLength() )
+        return -1;
+    return res - begin();
+}
+
 double
 MLTInput::fps() const
 {
@@ -325,7 +454,10 @@ void
 MLTInput::playPause()
 {
     if ( m_paused )
+    {
+        m_reverseBuffer.reset();
         producer()->set_speed( 1.0 );
+    }
     else
         producer()->set_speed( 0.0 );
     m_paused = !m_paused;
@@ -353,6 +485,34 @@ MLTInput::setPause( bool isPaused )
     playPause();
 }
 
+void
+MLTInput::setSpeed( double speed )
+{
+    if ( speed < 0 )
+        startReverse();
+    else if ( speed > 0 )
+        m_reverseBuffer.reset();
+    producer()->set_speed( speed );
+
+    bool paused = speed == 0;
+    if ( paused == m_paused )
+        return;
+    m_paused = paused;
+    if ( m_callback )
+    {
+        if ( m_paused == true )
+            m_callback->onPaused();
+        else
+            m_callback->onPlaying();
+    }
+}
+
+double
+MLTInput::speed() const
+{
+    return producer()->get_speed();
+}
+
 void
 MLTInput::nextFrame()
 {
@@ -360,6 +520,7 @@ MLTInput::nextFrame()
     {
         if ( isPaused() == false )
             playPause();
+        m_reverseBuffer.reset();
         producer()->seek( producer()->position() + 1 );
     }
 }
@@ -371,10 +532,30 @@ MLTInput::previousFrame()
     {
         if ( isPaused() == false )
             playPause();
+        // Stepping back re-decodes the GOP of the previous frame otherwise
+        startReverse();
         producer()->seek( producer()->position() - 1 );
     }
 }
 
+void
+MLTInput::startReverse()
+{
+    if ( m_reverseBuffer != nullptr )
+        return;
+    // Copying the source is what's expensive, the buffers made until the next edit share it
+    if ( m_reverseSource == nullptr )
+        m_reverseSource = MLTReverseBuffer::copySource( *this );
+    m_reverseBuffer.reset( new MLTReverseBuffer( *this, m_reverseSource ) );
+}
+
+void
+MLTInput::dropReverseSource()
+{
+    m_reverseBuffer.reset();
+    m_reverseSource.reset();
+}
+
 bool
 MLTInput::isBlank() const
 {
@@ -387,6 +568,7 @@ MLTInput::attach( Backend::IFilter& filter )
 {
     MLTFilter* mltFilter = dynamic_cast<MLTFilter*>( &filter );
     assert( mltFilter );
+    dropReverseSource();
     auto ret = producer()->attach( *mltFilter->filter() );
     mltFilter->connect( *this );
     return !ret;
@@ -397,12 +579,14 @@ MLTInput::detach( Backend::IFilter& filter )
 {
     MLTFilter* mltFilter = dynamic_cast<MLTFilter*>( &filter );
     assert( mltFilter );
+    dropReverseSource();
     return !producer()->detach( *mltFilter->filter() );
 }
 
 bool
 MLTInput::detach( int index )
 {
+    dropReverseSource();
     auto filter = producer()->filter( index );
     auto ret = producer()->detach( *filter );
     delete filter;
@@ -418,6 +602,7 @@ MLTInput::filterCount() const
 bool
 MLTInput::moveFilter( int from, int to )
 {
+    dropReverseSource();
     return !producer()->move_filter( from, to );
 }
 
@@ -27,6 +27,8 @@
 #include "Backend/IProfile.h"
 #include "MLTService.h"
 
+#include <memory>
+
 namespace Mlt
 {
 class Producer;
@@ -37,6 +39,9 @@ namespace Backend
 namespace MLT
 {
 
+class MLTReverseBuffer;
+class MLTReverseSource;
+
 class MLTInput : virtual public IInput, public MLTService
 {
     public:
@@ -44,6 +49,13 @@ class MLTInput : virtual public IInput, public MLTService
         MLTInput( Mlt::Producer* input, IInputEventCb* callback = nullptr );
         MLTInput( const char* path, IInputEventCb* callback = nullptr );
         MLTInput( IProfile& profile, const char* path, IInputEventCb* callback = nullptr );
+        /**
+         *  \brief Creates an input generated by an MLT producer, ie. "color", "noise" or "tone"
+         *  \param argument    The argument of the producer, can be nullptr
+         *  \param length      The length of the generated input, in frames
+         */
+        MLTInput( IProfile& profile, const char* service, const char* argument, int64_t length,
+                  IInputEventCb* callback = nullptr );
         ~MLTInput();
 
         virtual Mlt::Producer*  producer();
@@ -88,6 +100,15 @@ class MLTInput : virtual public IInput, public MLTService
 
         // Generates an 32-bit RGBA image at the current position
         virtual uint8_t*        image( uint32_t width, uint32_t height ) const override;
+        virtual bool            image( uint8_t* buffer, uint32_t width, uint32_t height ) const override;
+
+        virtual void            prefetch( int64_t nbFrames, int width, int height, IInput& graph,
+                                          const std::function<bool()>& cancelled ) override;
+
+        virtual void            setKeyframeIndex( std::shared_ptr<const KeyframeIndex> index ) override;
+        virtual std::shared_ptr<const KeyframeIndex>    keyframeIndex() const override;
+        virtual int64_t         keyframeBefore( int64_t position ) const override;
+        virtual int64_t         keyframeAfter( int64_t position ) const override;
 
         virtual double          fps() const override;
         virtual double          aspectRatio() const override;
@@ -101,6 +122,8 @@ class MLTInput : virtual public IInput, public MLTService
         virtual void            playPause() override;
         virtual bool            isPaused() const override;
         virtual void            setPause( bool isPaused ) override;
+        virtual void            setSpeed( double speed ) override;
+        virtual double          speed() const override;
         virtual void            nextFrame() override;
         virtual void            previousFrame() override;
 
@@ -116,11 +139,22 @@ class MLTInput : virtual public IInput, public MLTService
         MLTInput();
 
         void                    calcTracks();
+        /**
+         *  \brief  Drops the copy the reverse buffers decode from, the graph was edited.
+         */
+        void                    dropReverseSource();
+
+    private:
+        void                    startReverse();
 
     private:
         Mlt::Producer*          m_producer;
         IInputEventCb*          m_callback;
         bool                    m_paused;
+        // Kept across the reverse buffers until the graph is edited
+        std::shared_ptr<MLTReverseSource>   m_reverseSource;
+        // Only exists while playing or stepping backward
+        std::unique_ptr<MLTReverseBuffer>   m_reverseBuffer;
 
         int                     m_nbVideoTracks;
         int                     m_nbAudioTracks;
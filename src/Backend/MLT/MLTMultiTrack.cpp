@@ -43,6 +43,7 @@ MLTMultiTrack::MLTMultiTrack()
 
 MLTMultiTrack::MLTMultiTrack( Backend::IProfile& profile )
     : MLTInput()
+    , m_editDepth( 0 )
 {
     MLTProfile& mltProfile = static_cast<MLTProfile&>( profile );
     m_tractor  = new Mlt::Tractor( *mltProfile.m_profile );
@@ -50,6 +51,7 @@ MLTMultiTrack::MLTMultiTrack( Backend::IProfile& profile )
 
 MLTMultiTrack::~MLTMultiTrack()
 {
+    assert( m_editDepth == 0 );
     delete m_tractor;
 }
 
@@ -146,3 +148,24 @@ MLTMultiTrack::hide( Backend::HideType hydeType, int index )
     if ( prod )
         prod->set( "hide", static_cast<int>( hydeType ) );
 }
+
+void
+MLTMultiTrack::beginEdit()
+{
+    // Consumers hold the lock of the service they pull from while they get a frame, so
+    // holding it makes the edit land between two frames. It isn't recursive.
+    if ( m_editDepth++ == 0 )
+        tractor()->lock();
+}
+
+void
+MLTMultiTrack::endEdit()
+{
+    assert( m_editDepth > 0 );
+    if ( --m_editDepth == 0 )
+    {
+        // The copy played backward would show the graph as it was before the edit
+        dropReverseSource();
+        tractor()->unlock();
+    }
+}
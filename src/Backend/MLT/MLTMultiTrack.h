@@ -59,9 +59,12 @@ namespace MLT
         virtual void        addFilter( IFilter& filter, int track ) override;
         virtual bool        connect( IInput& input ) override;
         virtual void        hide( HideType hideType, int index ) override;
+        virtual void        beginEdit() override;
+        virtual void        endEdit() override;
 
     private:
         Mlt::Tractor*      m_tractor;
+        int                m_editDepth;
     };
 }
 }
@@ -28,12 +28,17 @@
 #include "MLTInput.h"
 #include "MLTProfile.h"
 #include "MLTBackend.h"
+#include "MLTPipelineProbe.h"
+#include "Tools/PerfCounters.h"
 
 #include <mlt++/MltProducer.h>
 #include <mlt++/MltConsumer.h>
 #include <mlt++/MltProfile.h>
 
+#include <algorithm>
 #include <cassert>
+#include <chrono>
+#include <cstring>
 
 using namespace Backend::MLT;
 
@@ -46,6 +51,13 @@ MLTOutput::MLTOutput()
 MLTOutput::MLTOutput( Backend::IProfile& profile, const char *id, Backend::IOutputEventCb* callback )
     : m_callback( callback )
     , m_input( nullptr )
+    , m_tap( nullptr )
+    , m_tapWidth( 0 )
+    , m_tapHeight( 0 )
+    , m_tapInterval( 0 )
+    , m_lastTap( 0 )
+    , m_tapListening( false )
+    , m_restarting( false )
 {
     MLTProfile& mltProfile = static_cast<MLTProfile&>( profile );
     m_consumer = new Mlt::Consumer( *mltProfile.m_profile, id );
@@ -86,7 +98,7 @@ MLTOutput::service() const
 void
 MLTOutput::onOutputStarted( void*, MLTOutput* self )
 {
-    if ( self->m_callback == nullptr )
+    if ( self->m_restarting.exchange( false ) == true || self->m_callback == nullptr )
         return;
     self->m_callback->onPlaying();
 }
@@ -94,11 +106,131 @@ MLTOutput::onOutputStarted( void*, MLTOutput* self )
 void
 MLTOutput::onOutputStopped( void*, MLTOutput* self )
 {
-    if ( self->m_callback == nullptr )
+    if ( self->m_restarting == true || self->m_callback == nullptr )
         return;
     self->m_callback->onStopped();
 }
 
+void
+MLTOutput::onFrameShown( void*, MLTOutput* self, mlt_frame_s* frame )
+{
+    if ( self->m_tap.load( std::memory_order_relaxed ) == nullptr || frame == nullptr )
+        return;
+    self->tapFrame( frame );
+}
+
+static inline uint8_t
+clamp( int v )
+{
+    return static_cast<uint8_t>( std::min( 255, std::max( 0, v ) ) );
+}
+
+static inline void
+yuvToRgba( int y, int u, int v, uint8_t* out )
+{
+    // BT.601, limited range
+    const int c = 298 * ( y - 16 );
+    const int d = u - 128;
+    const int e = v - 128;
+    out[0] = clamp( ( c + 409 * e + 128 ) >> 8 );
+    out[1] = clamp( ( c - 100 * d - 208 * e + 128 ) >> 8 );
+    out[2] = clamp( ( c + 516 * d + 128 ) >> 8 );
+    out[3] = 255;
+}
+
+void
+MLTOutput::tapFrame( mlt_frame_s* frame )
+{
+    std::lock_guard<std::mutex> lock( m_tapLock );
+    auto tap = m_tap.load( std::memory_order_relaxed );
+    if ( tap == nullptr )
+        return;
+    // Only copy a frame once the previous one was consumed, and not too often
+    auto now = std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::steady_clock::now().time_since_epoch() ).count();
+    if ( tap->isEmpty() == false || now - m_lastTap < m_tapInterval )
+        return;
+
+    // Use the picture as the consumer left it, rather than asking for a conversion.
+    auto properties = MLT_FRAME_PROPERTIES( frame );
+    auto image = static_cast<const uint8_t*>( mlt_properties_get_data( properties, "image", nullptr ) );
+    auto format = static_cast<mlt_image_format>( mlt_properties_get_int( properties, "format" ) );
+    int width = mlt_properties_get_int( properties, "width" );
+    int height = mlt_properties_get_int( properties, "height" );
+    if ( image == nullptr || width <= 0 || height <= 0 )
+        return;
+    if ( format != mlt_image_rgb24 && format != mlt_image_rgb24a &&
+         format != mlt_image_yuv422 && format != mlt_image_yuv420p )
+        return;
+
+    auto scale = std::min( { 1.0, static_cast<double>( m_tapWidth ) / width,
+                             static_cast<double>( m_tapHeight ) / height } );
+    std::unique_ptr<VideoFrame> res( new VideoFrame );
+    res->width = std::max( 1, static_cast<int>( width * scale ) );
+    res->height = std::max( 1, static_cast<int>( height * scale ) );
+    res->position = mlt_frame_get_position( frame );
+    res->time = std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now().time_since_epoch() ).count();
+    res->pixels.resize( res->width * res->height * 4 );
+
+    // Nearest neighbour is plenty for a preview
+    auto out = res->pixels.data();
+    const auto chromaSize = ( width / 2 ) * ( height / 2 );
+    for ( int y = 0; y < res->height; ++y )
+    {
+        const int sy = y * height / res->height;
+        for ( int x = 0; x < res->width; ++x, out += 4 )
+        {
+            const int sx = x * width / res->width;
+            switch ( format )
+            {
+            case mlt_image_rgb24:
+            {
+                auto p = image + ( sy * width + sx ) * 3;
+                out[0] = p[0]; out[1] = p[1]; out[2] = p[2]; out[3] = 255;
+                break;
+            }
+            case mlt_image_rgb24a:
+                memcpy( out, image + ( sy * width + sx ) * 4, 4 );
+                break;
+            case mlt_image_yuv422:
+            {
+                auto p = image + sy * width * 2 + ( sx / 2 ) * 4;
+                yuvToRgba( p[( sx & 1 ) * 2], p[1], p[3], out );
+                break;
+            }
+            default:
+            {
+                auto chroma = ( sy / 2 ) * ( width / 2 ) + sx / 2;
+                auto u = image + width * height;
+                yuvToRgba( image[sy * width + sx], u[chroma], u[chromaSize + chroma], out );
+                break;
+            }
+            }
+        }
+    }
+    m_lastTap = now;
+    tap->publish( std::move( res ) );
+}
+
+void
+MLTOutput::setFrameTap( FrameMailbox<VideoFrame>* mailbox, int width, int height, int interval )
+{
+    {
+        // Waits for a frame being copied to the previous mailbox
+        std::lock_guard<std::mutex> lock( m_tapLock );
+        m_tapWidth = width;
+        m_tapHeight = height;
+        m_tapInterval = interval;
+        m_tap.store( mailbox, std::memory_order_relaxed );
+    }
+    if ( mailbox != nullptr && m_tapListening == false )
+    {
+        consumer()->listen( "consumer-frame-show", this, (mlt_listener)MLTOutput::onFrameShown );
+        m_tapListening = true;
+    }
+}
+
 void
 MLTOutput::setName( const char* name )
 {
@@ -127,6 +259,21 @@ MLTOutput::stop()
     consumer()->stop();
 }
 
+void
+MLTOutput::restart()
+{
+    // Cleared by the "consumer-thread-started" event of the new run
+    m_restarting = true;
+    consumer()->stop();
+    consumer()->start();
+}
+
+Backend::IOutputEventCb*
+MLTOutput::callback() const
+{
+    return m_callback;
+}
+
 bool
 MLTOutput::isStopped() const
 {
@@ -145,6 +292,32 @@ MLTOutput::setVolume( int volume )
     consumer()->set( "volume", volume / 100.f );
 }
 
+int
+MLTOutput::frameWidth() const
+{
+    auto width = consumer()->get_int( "width" );
+    return width > 0 ? width : Backend::instance()->profile().width();
+}
+
+int
+MLTOutput::frameHeight() const
+{
+    auto height = consumer()->get_int( "height" );
+    return height > 0 ? height : Backend::instance()->profile().height();
+}
+
+void
+MLTOutput::setScrubbing( bool scrubbing )
+{
+    consumer()->set( "scrub_audio", scrubbing == true ? 1 : 0 );
+}
+
+void
+MLTOutput::purge()
+{
+    consumer()->purge();
+}
+
 bool
 MLTOutput::connect( Backend::IInput& input )
 {
@@ -160,12 +333,243 @@ MLTOutput::isConnected() const
     return m_input != nullptr;
 }
 
+// Consecutive video frames the preview can skip before showing one anyway
+static const int        MaxConsecutiveDrops = 5;
+// Minimum interval between two playback stats reports, in microseconds
+static const int64_t    ReportInterval = 250000;
+
+MLTSdlOutput::MLTSdlOutput()
+    : MLTSdlOutput( "sdl" )
+{
+}
+
+MLTSdlOutput::MLTSdlOutput( const char* id )
+    : MLTOutput( Backend::instance()->profile(), id )
+    , m_scale( 1 )
+    , m_framesShown( 0 )
+    , m_droppedFrames( 0 )
+    , m_lateFrames( 0 )
+    , m_resetClock( true )
+    , m_fps( 0 )
+    , m_clockStart( 0 )
+    , m_clockPosition( 0 )
+    , m_lastPosition( 0 )
+    , m_lastReport( 0 )
+    , m_reportPending( false )
+{
+    // Let the consumer skip late frames: their pictures are then never requested, which
+    // also skips their decoding & compositing. Still show one now and then, so the
+    // preview doesn't freeze when it can't keep up at all.
+    consumer()->set( "real_time", 1 );
+    consumer()->set( "drop_max", MaxConsecutiveDrops );
+    consumer()->listen( "consumer-frame-show", this, (mlt_listener)MLTSdlOutput::onFrameDisplayed );
+    MLTPipelineProbe::instrument( *consumer(), false );
+}
+
+void
+MLTSdlOutput::start()
+{
+    m_framesShown = 0;
+    m_droppedFrames = 0;
+    m_lateFrames = 0;
+    m_resetClock = true;
+    m_fps = Backend::instance()->profile().fps();
+    if ( callback() != nullptr )
+        callback()->onPlaybackStats( 0, 0 );
+    MLTOutput::start();
+}
+
+void
+MLTSdlOutput::onFrameDisplayed( void*, MLTSdlOutput* self, mlt_frame_s* frame )
+{
+    if ( frame == nullptr )
+        return;
+    self->updateClock( frame );
+}
+
+void
+MLTSdlOutput::updateClock( mlt_frame_s* frame )
+{
+    auto properties = MLT_FRAME_PROPERTIES( frame );
+    const auto position = mlt_frame_get_position( frame );
+    const auto now = std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now().time_since_epoch() ).count();
+    // The consumer flags the frames it decided to skip as not rendered
+    const bool rendered = mlt_properties_get_int( properties, "rendered" ) != 0;
+    if ( rendered == true )
+        m_framesShown.fetch_add( 1, std::memory_order_relaxed );
+
+    // The clock only runs while playing forward at normal speed. Seeking, pausing or
+    // restarting the output starts it over.
+    if ( m_resetClock.exchange( false ) == true ||
+         mlt_properties_get_double( properties, "_speed" ) != 1.0 ||
+         position <= m_lastPosition || position - m_lastPosition > m_fps || m_fps <= 0 )
+    {
+        m_clockStart = now;
+        m_clockPosition = position;
+        m_lastPosition = position;
+        return;
+    }
+
+    // Frames the consumer didn't even hand over leave a hole in the positions
+    auto dropped = position - m_lastPosition - 1;
+    if ( rendered == false )
+        ++dropped;
+    m_lastPosition = position;
+    if ( dropped > 0 )
+    {
+        m_droppedFrames.fetch_add( dropped, std::memory_order_relaxed );
+        PerfCounters::add( PerfCounters::DroppedFrames, dropped );
+        m_reportPending = true;
+    }
+    const auto expected = m_clockPosition + ( now - m_clockStart ) * m_fps / 1000000.0;
+    if ( rendered == true && expected - position > 1.0 )
+    {
+        m_lateFrames.fetch_add( 1, std::memory_order_relaxed );
+        m_reportPending = true;
+    }
+
+    if ( m_reportPending == false || now - m_lastReport < ReportInterval || callback() == nullptr )
+        return;
+    m_reportPending = false;
+    m_lastReport = now;
+    callback()->onPlaybackStats( droppedFrames(), lateFrames() );
+}
+
 void
 MLTSdlOutput::setWindowId( intptr_t id )
 {
     consumer()->set( "window_id", std::to_string( id ).c_str() );
 }
 
+void
+MLTSdlOutput::setScale( int divisor )
+{
+    m_scale = std::max( 1, divisor );
+    // The export profile is left untouched, only this consumer asks for smaller frames.
+    // Keep the size even, as the consumer works in YUV 4:2:2
+    const auto& profile = Backend::instance()->profile();
+    const int width = std::max( 2, ( profile.width() / m_scale ) & ~1 );
+    const int height = std::max( 2, ( profile.height() / m_scale ) & ~1 );
+    if ( consumer()->get_int( "width" ) == width && consumer()->get_int( "height" ) == height )
+        return;
+    consumer()->set( "width", width );
+    consumer()->set( "height", height );
+    if ( isStopped() == false )
+    {
+        m_resetClock = true;
+        restart();
+    }
+}
+
+int
+MLTSdlOutput::scale() const
+{
+    return m_scale;
+}
+
+int64_t
+MLTSdlOutput::framesShown() const
+{
+    return m_framesShown.load( std::memory_order_relaxed );
+}
+
+int64_t
+MLTSdlOutput::droppedFrames() const
+{
+    return m_droppedFrames.load( std::memory_order_relaxed );
+}
+
+int64_t
+MLTSdlOutput::lateFrames() const
+{
+    return m_lateFrames.load( std::memory_order_relaxed );
+}
+
+MLTFrameSinkOutput::MLTFrameSinkOutput( IAudioSink* audioSink )
+    : MLTSdlOutput( audioSink == nullptr ? "sdl_audio" : "null" )
+    , m_audioSink( audioSink )
+    , m_frameSink( nullptr )
+{
+    // Have the rendering threads produce RGBA, so that the frames can be painted as is
+    consumer()->set( "mlt_image_format", "rgb24a" );
+    consumer()->listen( "consumer-frame-show", this, (mlt_listener)MLTFrameSinkOutput::onFrameShow );
+}
+
+void
+MLTFrameSinkOutput::setFrameSink( IFrameSink* sink )
+{
+    std::lock_guard<std::mutex> lock( m_frameSinkLock );
+    m_frameSink = sink;
+}
+
+TripleBuffer<Backend::VideoFrame>&
+MLTFrameSinkOutput::frames()
+{
+    return m_frames;
+}
+
+void
+MLTFrameSinkOutput::onFrameShow( void*, MLTFrameSinkOutput* self, mlt_frame_s* frame )
+{
+    if ( frame == nullptr )
+        return;
+    self->deliver( frame );
+}
+
+void
+MLTFrameSinkOutput::deliver( mlt_frame_s* frame )
+{
+    auto properties = MLT_FRAME_PROPERTIES( frame );
+    if ( m_audioSink != nullptr )
+    {
+        mlt_audio_format format = mlt_audio_s16;
+        int frequency = consumer()->get_int( "frequency" );
+        int channels = consumer()->get_int( "channels" );
+        if ( frequency <= 0 )
+            frequency = 48000;
+        if ( channels <= 0 )
+            channels = 2;
+        int samples = mlt_sample_calculator( Backend::instance()->profile().fps(), frequency,
+                                             mlt_frame_get_position( frame ) );
+        void* buffer = nullptr;
+        if ( mlt_frame_get_audio( frame, &buffer, &format, &frequency, &channels, &samples ) == 0 &&
+             buffer != nullptr && format == mlt_audio_s16 )
+            m_audioSink->onAudio( static_cast<const int16_t*>( buffer ), samples, channels, frequency );
+    }
+
+    // The consumer flags the frames it skipped to keep up, don't render them now
+    if ( mlt_properties_get_int( properties, "rendered" ) == 0 )
+        return;
+    mlt_image_format format = mlt_image_rgb24a;
+    int width = 0;
+    int height = 0;
+    uint8_t* image = nullptr;
+    if ( mlt_frame_get_image( frame, &image, &format, &width, &height, 0 ) != 0 ||
+         image == nullptr || format != mlt_image_rgb24a || width <= 0 || height <= 0 )
+        return;
+
+    auto& res = m_frames.writeBuffer();
+    res.width = width;
+    res.height = height;
+    res.position = mlt_frame_get_position( frame );
+    res.time = std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now().time_since_epoch() ).count();
+    // Keeps the capacity of the buffer, nothing is allocated once the size is stable
+    res.pixels.assign( image, image + width * height * 4 );
+    m_frames.publish();
+
+    std::lock_guard<std::mutex> lock( m_frameSinkLock );
+    if ( m_frameSink != nullptr )
+        m_frameSink->onFrameReady();
+}
+
+MLTFFmpegOutput::MLTFFmpegOutput()
+    : MLTOutput( Backend::instance()->profile(), "avformat" )
+{
+    MLTPipelineProbe::instrument( *consumer() );
+}
+
 void
 MLTFFmpegOutput::setTarget( const char* path )
 {
@@ -223,3 +627,41 @@ MLTFFmpegOutput::setAudioSampleRate( int rate )
 {
     consumer()->set( "frequency", rate );
 }
+
+MLTMultiOutput::MLTMultiOutput()
+    : MLTOutput( Backend::instance()->profile(), "multi" )
+    , m_nbOutputs( 0 )
+{
+    // Stop once the input has been consumed, as the avformat consumer does.
+    consumer()->set( "terminate_on_pause", 1 );
+    MLTPipelineProbe::instrument( *consumer() );
+}
+
+int
+MLTMultiOutput::addOutput( const MLTFFmpegOutput& output )
+{
+    const auto index = std::to_string( m_nbOutputs );
+    const auto prefix = index + '.';
+    auto props = output.consumer();
+    // The multi consumer only creates the nested consumers whose service is named
+    consumer()->set( index.c_str(), props->get( "mlt_service" ) != nullptr ?
+                                        props->get( "mlt_service" ) : "avformat" );
+    for ( int i = 0; i < props->count(); ++i )
+    {
+        const char* name = props->get_name( i );
+        // Private and type properties are recreated by MLT for the nested consumer
+        if ( name == nullptr || name[0] == '_' || strcmp( name, "mlt_type" ) == 0 )
+            continue;
+        const char* value = props->get( i );
+        if ( value == nullptr )
+            continue;
+        consumer()->set( ( prefix + name ).c_str(), value );
+    }
+    return m_nbOutputs++;
+}
+
+int
+MLTMultiOutput::nbOutputs() const
+{
+    return m_nbOutputs;
+}
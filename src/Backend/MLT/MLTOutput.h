@@ -27,7 +27,10 @@
 #include "Backend/IOutput.h"
 #include "Backend/IBackend.h"
 #include "Backend/IProfile.h"
+#include "Tools/TripleBuffer.h"
 
+#include <atomic>
+#include <mutex>
 #include <string>
 
 namespace Mlt
@@ -35,6 +38,8 @@ namespace Mlt
 class Consumer;
 }
 
+struct mlt_frame_s;
+
 namespace Backend
 {
 namespace MLT
@@ -56,6 +61,7 @@ class MLTOutput : public IOutput, public MLTService
 
         static void     onOutputStarted( void* owner, MLTOutput* self );
         static void     onOutputStopped( void* owner, MLTOutput* self );
+        static void     onFrameShown( void* owner, MLTOutput* self, mlt_frame_s* frame );
 
         virtual void    setName( const char* name ) override;
         virtual void    setCallback( IOutputEventCb* callback ) override;
@@ -70,27 +76,151 @@ class MLTOutput : public IOutput, public MLTService
         virtual bool    connect( IInput& input ) override;
         virtual bool    isConnected() const override;
 
+        virtual int     frameWidth() const override;
+        virtual int     frameHeight() const override;
+
+        virtual void    setFrameTap( FrameMailbox<VideoFrame>* mailbox, int width, int height,
+                                     int interval ) override;
+        virtual void    setScrubbing( bool scrubbing ) override;
+        virtual void    purge() override;
+
+    protected:
+        /**
+         * \brief  Stop & start the output again, without notifying the callback
+         */
+        void            restart();
+        IOutputEventCb* callback() const;
+
+    private:
+        void            tapFrame( mlt_frame_s* frame );
+
     private:
         Mlt::Consumer*      m_consumer;
         IOutputEventCb*     m_callback;
         MLTInput*           m_input;
         std::string         m_name;
+
+        // Only checked without the lock, so that a disabled tap costs nothing
+        std::atomic<FrameMailbox<VideoFrame>*>  m_tap;
+        // Held while copying a frame, so that the mailbox can't be removed meanwhile.
+        // Protects all the tap fields below.
+        std::mutex                              m_tapLock;
+        int                                     m_tapWidth;
+        int                                     m_tapHeight;
+        int                                     m_tapInterval;
+        int64_t                                 m_lastTap;
+        bool                                    m_tapListening;
+        std::atomic_bool                        m_restarting;
 };
 
+/**
+ * \brief  The realtime preview output
+ *
+ * The audio drives the playback: when the graph can't keep up, video frames are dropped
+ * instead of slowing down. The output keeps a clock running from the first frame played
+ * at normal speed to count the dropped frames and the ones displayed late, which are
+ * reported through IOutputEventCb::onPlaybackStats().
+ */
 class MLTSdlOutput : public MLTOutput
 {
     public:
-        MLTSdlOutput()
-            : MLTOutput( Backend::instance()->profile(), "sdl" ) { }
+        MLTSdlOutput();
 
         void setWindowId( intptr_t id );
+
+        virtual void    start() override;
+
+        /**
+         * \brief  Render at 1/\p divisor of the profile size
+         *
+         * Producers scale their pictures down right after decoding, and the tracks are
+         * then composited at the reduced size, which is where most of the time goes.
+         * The SDL consumer only reads its size when it starts, so a running output is
+         * restarted when the size changes.
+         */
+        void    setScale( int divisor );
+        int     scale() const;
+
+        /**
+         * \return The number of frames displayed so far. Can be called from any thread.
+         */
+        int64_t framesShown() const;
+        int64_t droppedFrames() const;
+        int64_t lateFrames() const;
+
+    protected:
+        explicit MLTSdlOutput( const char* id );
+
+    private:
+        static void     onFrameDisplayed( void* owner, MLTSdlOutput* self, mlt_frame_s* frame );
+        void            updateClock( mlt_frame_s* frame );
+
+    private:
+        int                     m_scale;
+        std::atomic<int64_t>    m_framesShown;
+        std::atomic<int64_t>    m_droppedFrames;
+        std::atomic<int64_t>    m_lateFrames;
+        /// Set to restart the clock from the next frame
+        std::atomic_bool        m_resetClock;
+
+        // Only used from the consumer thread
+        double                  m_fps;
+        int64_t                 m_clockStart;
+        int64_t                 m_clockPosition;
+        int64_t                 m_lastPosition;
+        int64_t                 m_lastReport;
+        bool                    m_reportPending;
+};
+
+/**
+ * \brief  The realtime preview output, delivering its frames in process
+ *
+ * Rather than displaying the frames in a window of its own, the output converts them
+ * to RGBA in its rendering threads and publishes them through a triple buffer, from
+ * which the GUI paints them. The buffers are recycled from frame to frame.
+ *
+ * Without an audio sink, the audio goes to the default device and paces the playback,
+ * as with MLTSdlOutput. With one, nothing paces the output: frames are produced as fast
+ * as the graph allows, which is how to benchmark the preview without a display.
+ */
+class MLTFrameSinkOutput : public MLTSdlOutput
+{
+    public:
+        /**
+         * \param  audioSink   Receives the audio instead of the audio device. It must
+         *                     outlive the output.
+         */
+        explicit MLTFrameSinkOutput( IAudioSink* audioSink = nullptr );
+
+        /**
+         * \brief  Set the sink notified of the new frames, nullptr to stop notifying.
+         *
+         * Waits for the notification in flight, so the previous sink may be destroyed
+         * once this returns.
+         */
+        void    setFrameSink( IFrameSink* sink );
+
+        /**
+         * \return The frames produced by the output. Only one thread may read them.
+         */
+        TripleBuffer<VideoFrame>&   frames();
+
+    private:
+        static void     onFrameShow( void* owner, MLTFrameSinkOutput* self, mlt_frame_s* frame );
+        void            deliver( mlt_frame_s* frame );
+
+    private:
+        TripleBuffer<VideoFrame>    m_frames;
+        IAudioSink*                 m_audioSink;
+        // Held while notifying the sink, so that it can't be replaced meanwhile
+        std::mutex                  m_frameSinkLock;
+        IFrameSink*                 m_frameSink;
 };
 
 class MLTFFmpegOutput : public MLTOutput
 {
     public:
-        MLTFFmpegOutput()
-            : MLTOutput( Backend::instance()->profile(), "avformat" ) { }
+        MLTFFmpegOutput();
 
         void    setTarget( const char* path );
         void    setWidth( int width );
@@ -104,6 +234,31 @@ class MLTFFmpegOutput : public MLTOutput
 
 };
 
+/**
+ * \brief  Feeds several FFmpeg outputs from a single pass over the input
+ *
+ * Each frame is pulled and composited once, then handed to every nested encoder,
+ * which runs in its own thread and scales the frame to its own size.
+ */
+class MLTMultiOutput : public MLTOutput
+{
+    public:
+        MLTMultiOutput();
+
+        /**
+         * \brief  Add a nested output configured like \p output
+         *
+         * Only the properties are copied, the nested consumer is instantiated when this
+         * output starts. \p output can therefore be destroyed right away.
+         * \return The index of the nested output
+         */
+        int     addOutput( const MLTFFmpegOutput& output );
+        int     nbOutputs() const;
+
+    private:
+        int     m_nbOutputs;
+};
+
 }
 }
 
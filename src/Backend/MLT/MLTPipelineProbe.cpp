@@ -0,0 +1,369 @@
+/*****************************************************************************
+ * MLTPipelineProbe.cpp: Measures the time spent in each stage of the MLT pipeline
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "MLTPipelineProbe.h"
+#include "Tools/PerfCounters.h"
+#include "Tools/Tracer.h"
+
+#include <mlt++/MltConsumer.h>
+#include <mlt++/MltFilter.h>
+#include <mlt++/MltProducer.h>
+#include <mlt++/MltTransition.h>
+
+#include <atomic>
+#include <ctime>
+#include <string>
+
+using namespace Backend::MLT;
+
+namespace
+{
+
+const char* const                   OriginalProperty = "_vlmc_probe";
+const char* const                   TraceNameProperty = "_vlmc_trace_name";
+
+std::atomic_bool                    s_enabled( false );
+std::atomic<int64_t>                s_time[MLTPipelineProbe::NbStages];
+std::atomic<int64_t>                s_nbFrames( 0 );
+std::atomic<int>                    s_generation( 0 );
+
+// Time spent in nested stages by the callback currently running on this thread
+thread_local int64_t                t_nested = 0;
+// Time spent in any stage by this thread, used to isolate the encoding time
+thread_local int64_t                t_stagesTotal = 0;
+thread_local int64_t                t_lastCpuTime = -1;
+thread_local int64_t                t_lastStagesTotal = 0;
+thread_local int                    t_generation = -1;
+// Last frame shown by this consumer thread, for the tracer
+thread_local int64_t                t_lastShow = -1;
+
+inline int64_t
+now()
+{
+    return Tracer::now();
+}
+
+inline int64_t
+threadCpuTime()
+{
+#ifdef CLOCK_THREAD_CPUTIME_ID
+    struct timespec ts;
+    if ( clock_gettime( CLOCK_THREAD_CPUTIME_ID, &ts ) == 0 )
+        return static_cast<int64_t>( ts.tv_sec ) * 1000000000 + ts.tv_nsec;
+#endif
+    return now();
+}
+
+// Whether anything reads the timings; the shims are only installed on the frames meanwhile
+inline bool
+isTiming()
+{
+    return s_enabled == true || Tracer::isEnabled() == true || PerfCounters::isTimingEnabled() == true;
+}
+
+inline void
+record( MLTPipelineProbe::Stage stage, const char* name, int64_t start )
+{
+    auto end = now();
+    auto elapsed = end - start;
+    if ( Tracer::isEnabled() == true )
+        Tracer::record( name, MLTPipelineProbe::stageName( stage ), start, end );
+    if ( stage == MLTPipelineProbe::Composite && PerfCounters::isTimingEnabled() == true )
+        PerfCounters::add( PerfCounters::CompositeTime, elapsed - t_nested );
+    if ( s_enabled == true )
+        s_time[stage].fetch_add( elapsed - t_nested, std::memory_order_relaxed );
+    t_stagesTotal += elapsed - t_nested;
+    t_nested = elapsed;
+}
+
+template <MLTPipelineProbe::Stage S>
+int
+imageShim( mlt_frame frame, uint8_t** image, mlt_image_format* format, int* width, int* height,
+           int writable )
+{
+    auto name = static_cast<const char*>( mlt_frame_pop_service( frame ) );
+    auto original = reinterpret_cast<mlt_get_image>( mlt_frame_pop_service( frame ) );
+    auto saved = t_nested;
+    t_nested = 0;
+    auto start = now();
+    auto res = original( frame, image, format, width, height, writable );
+    record( S, name, start );
+    t_nested += saved;
+    return res;
+}
+
+template <MLTPipelineProbe::Stage S>
+int
+audioShim( mlt_frame frame, void** buffer, mlt_audio_format* format, int* frequency, int* channels,
+           int* samples )
+{
+    auto name = static_cast<const char*>( mlt_frame_pop_audio( frame ) );
+    auto original = reinterpret_cast<mlt_get_audio>( mlt_frame_pop_audio( frame ) );
+    auto saved = t_nested;
+    t_nested = 0;
+    auto start = now();
+    auto res = original( frame, buffer, format, frequency, channels, samples );
+    record( S, name, start );
+    t_nested += saved;
+    return res;
+}
+
+/*
+ * Replace the callbacks a service just pushed on the frame stacks with a timed shim,
+ * which receives the original callback and the service name through the stack as well.
+ */
+template <MLTPipelineProbe::Stage S>
+void
+wrapCallbacks( mlt_frame frame, mlt_properties service, int imageDepth, int audioDepth )
+{
+    auto name = mlt_properties_get_data( service, TraceNameProperty, nullptr );
+    if ( mlt_deque_count( frame->stack_image ) > imageDepth )
+    {
+        auto getImage = mlt_frame_pop_get_image( frame );
+        mlt_frame_push_service( frame, reinterpret_cast<void*>( getImage ) );
+        mlt_frame_push_service( frame, name );
+        mlt_frame_push_get_image( frame, &imageShim<S> );
+    }
+    if ( mlt_deque_count( frame->stack_audio ) > audioDepth )
+    {
+        auto getAudio = mlt_frame_pop_audio( frame );
+        mlt_frame_push_audio( frame, getAudio );
+        mlt_frame_push_audio( frame, name );
+        mlt_frame_push_audio( frame, reinterpret_cast<void*>( &audioShim<S> ) );
+    }
+}
+
+template <typename T>
+T
+original( mlt_properties properties )
+{
+    return reinterpret_cast<T>( mlt_properties_get_data( properties, OriginalProperty, nullptr ) );
+}
+
+typedef int ( *GetFrame )( mlt_producer, mlt_frame_ptr, int );
+typedef mlt_frame ( *FilterProcess )( mlt_filter, mlt_frame );
+typedef mlt_frame ( *TransitionProcess )( mlt_transition, mlt_frame, mlt_frame );
+
+int
+producerShim( mlt_producer producer, mlt_frame_ptr frame, int index )
+{
+    auto properties = MLT_PRODUCER_PROPERTIES( producer );
+    auto getFrame = original<GetFrame>( properties );
+    if ( isTiming() == false )
+        return getFrame( producer, frame, index );
+    auto start = now();
+    auto res = getFrame( producer, frame, index );
+    if ( Tracer::isEnabled() == true )
+    {
+        auto name = static_cast<const char*>( mlt_properties_get_data( properties, TraceNameProperty, nullptr ) );
+        Tracer::record( name, "get_frame", start, now() );
+    }
+    if ( res == 0 && *frame != nullptr )
+        wrapCallbacks<MLTPipelineProbe::Decode>( *frame, properties, 0, 0 );
+    return res;
+}
+
+mlt_frame
+filterShim( mlt_filter filter, mlt_frame frame )
+{
+    auto properties = MLT_FILTER_PROPERTIES( filter );
+    auto process = original<FilterProcess>( properties );
+    if ( isTiming() == false )
+        return process( filter, frame );
+    auto imageDepth = mlt_deque_count( frame->stack_image );
+    auto audioDepth = mlt_deque_count( frame->stack_audio );
+    auto res = process( filter, frame );
+    wrapCallbacks<MLTPipelineProbe::Filter>( frame, properties, imageDepth, audioDepth );
+    return res;
+}
+
+mlt_frame
+transitionShim( mlt_transition transition, mlt_frame a, mlt_frame b )
+{
+    auto properties = MLT_TRANSITION_PROPERTIES( transition );
+    auto process = original<TransitionProcess>( properties );
+    if ( isTiming() == false )
+        return process( transition, a, b );
+    auto imageDepth = mlt_deque_count( a->stack_image );
+    auto audioDepth = mlt_deque_count( a->stack_audio );
+    auto res = process( transition, a, b );
+    wrapCallbacks<MLTPipelineProbe::Composite>( a, properties, imageDepth, audioDepth );
+    return res;
+}
+
+void
+traceFrame()
+{
+    // The stages of a frame run on the consumer thread between two shows; whatever
+    // isn't covered by them in the trace is the encoding.
+    auto time = now();
+    if ( t_lastShow >= Tracer::sessionStart() )
+        Tracer::record( "frame", "consumer", t_lastShow, time );
+    t_lastShow = time;
+}
+
+void
+onTracedFrameShow( mlt_properties, void*, mlt_frame )
+{
+    PerfCounters::add( PerfCounters::FramesShown );
+    if ( Tracer::isEnabled() == true )
+        traceFrame();
+}
+
+void
+onFrameShow( mlt_properties, void*, mlt_frame )
+{
+    PerfCounters::add( PerfCounters::FramesShown );
+    if ( Tracer::isEnabled() == true )
+        traceFrame();
+    if ( s_enabled == false )
+        return;
+    s_nbFrames.fetch_add( 1, std::memory_order_relaxed );
+    // Whatever this thread did outside of the stages since the previous frame was encoding
+    auto cpuTime = threadCpuTime();
+    auto generation = s_generation.load( std::memory_order_relaxed );
+    if ( t_lastCpuTime >= 0 && t_generation == generation )
+    {
+        auto encode = ( cpuTime - t_lastCpuTime ) - ( t_stagesTotal - t_lastStagesTotal );
+        if ( encode > 0 )
+            s_time[MLTPipelineProbe::Encode].fetch_add( encode, std::memory_order_relaxed );
+    }
+    t_generation = generation;
+    t_lastCpuTime = cpuTime;
+    t_lastStagesTotal = t_stagesTotal;
+}
+
+template <typename T>
+bool
+storeOriginal( mlt_properties properties, T function )
+{
+    // A service wrapped by several backend objects must only be instrumented once
+    if ( mlt_properties_get_data( properties, OriginalProperty, nullptr ) != nullptr )
+        return false;
+    mlt_properties_set_data( properties, OriginalProperty, reinterpret_cast<void*>( function ),
+                             0, nullptr, nullptr );
+    // Names are interned, so that events recorded with them outlive the service
+    std::string name = mlt_properties_get( properties, "mlt_service" ) != nullptr ?
+                mlt_properties_get( properties, "mlt_service" ) : "unknown";
+    auto resource = mlt_properties_get( properties, "resource" );
+    if ( resource != nullptr && resource[0] != 0 && resource[0] != '<' )
+    {
+        std::string path( resource );
+        name += ": " + path.substr( path.find_last_of( "/\\" ) + 1 );
+    }
+    mlt_properties_set_data( properties, TraceNameProperty,
+                             const_cast<char*>( Tracer::intern( name ) ), 0, nullptr, nullptr );
+    return true;
+}
+
+}
+
+void
+MLTPipelineProbe::setEnabled( bool enabled )
+{
+    s_enabled = enabled;
+}
+
+bool
+MLTPipelineProbe::isEnabled()
+{
+    return s_enabled;
+}
+
+void
+MLTPipelineProbe::reset()
+{
+    for ( auto& t : s_time )
+        t = 0;
+    s_nbFrames = 0;
+    // Consumer threads restart their encoding measurement from their next frame
+    ++s_generation;
+}
+
+MLTPipelineProbe::Stats
+MLTPipelineProbe::stats()
+{
+    Stats res;
+    for ( int i = 0; i < NbStages; ++i )
+        res.time[i] = s_time[i].load( std::memory_order_relaxed );
+    res.nbFrames = s_nbFrames.load( std::memory_order_relaxed );
+    return res;
+}
+
+const char*
+MLTPipelineProbe::stageName( Stage stage )
+{
+    switch ( stage )
+    {
+    case Decode:
+        return "decode";
+    case Filter:
+        return "filter";
+    case Composite:
+        return "composite";
+    case Encode:
+        return "encode";
+    default:
+        return "";
+    }
+}
+
+void
+MLTPipelineProbe::instrument( Mlt::Producer& producer )
+{
+    auto p = producer.get_producer();
+    if ( p == nullptr || p->get_frame == nullptr )
+        return;
+    if ( storeOriginal( MLT_PRODUCER_PROPERTIES( p ), p->get_frame ) == true )
+        p->get_frame = &producerShim;
+}
+
+void
+MLTPipelineProbe::instrument( Mlt::Filter& filter )
+{
+    auto f = filter.get_filter();
+    if ( f == nullptr || f->process == nullptr )
+        return;
+    if ( storeOriginal( MLT_FILTER_PROPERTIES( f ), f->process ) == true )
+        f->process = &filterShim;
+}
+
+void
+MLTPipelineProbe::instrument( Mlt::Transition& transition )
+{
+    auto t = transition.get_transition();
+    if ( t == nullptr || t->process == nullptr )
+        return;
+    if ( storeOriginal( MLT_TRANSITION_PROPERTIES( t ), t->process ) == true )
+        t->process = &transitionShim;
+}
+
+void
+MLTPipelineProbe::instrument( Mlt::Consumer& consumer, bool measure )
+{
+    consumer.listen( "consumer-frame-show", consumer.get_consumer(),
+                     measure == true ? (mlt_listener)onFrameShow : (mlt_listener)onTracedFrameShow );
+}
@@ -0,0 +1,95 @@
+/*****************************************************************************
+ * MLTPipelineProbe.h: Measures the time spent in each stage of the MLT pipeline
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef MLTPIPELINEPROBE_H
+#define MLTPIPELINEPROBE_H
+
+#include <cstdint>
+
+namespace Mlt
+{
+class Consumer;
+class Filter;
+class Producer;
+class Transition;
+}
+
+namespace Backend
+{
+namespace MLT
+{
+
+/**
+ * \brief   Accumulates the time spent decoding, filtering, compositing and encoding.
+ *
+ * MLT renders lazily: getting a frame only stacks the image & audio callbacks of each
+ * service, which run when the consumer asks for the picture. The probe wraps the
+ * services created by the backend so that the callbacks they stack are timed.
+ * Nested callbacks are subtracted from their caller, so each stage only accounts for
+ * its own work. Encoding is the CPU time of the consumer thread outside of any stage.
+ *
+ * Services are always instrumented, but their callbacks are only wrapped, at two clock
+ * reads each, while the probe, the Tracer or the PerfCounters timing is enabled;
+ * otherwise the shims call the original service and return. The frames shown are
+ * always counted. The Tracer gets a span per callback, named after its service, and a
+ * span per frame shown by each consumer thread.
+ */
+class MLTPipelineProbe
+{
+    public:
+        enum Stage
+        {
+            Decode,
+            Filter,
+            Composite,
+            Encode,
+            NbStages
+        };
+
+        struct Stats
+        {
+            /// Accumulated time, in nanoseconds
+            int64_t     time[NbStages];
+            /// Number of frames shown by the instrumented consumers
+            int64_t     nbFrames;
+        };
+
+        static void     setEnabled( bool enabled );
+        static bool     isEnabled();
+        static void     reset();
+        static Stats    stats();
+        static const char* stageName( Stage stage );
+
+        static void     instrument( Mlt::Producer& producer );
+        static void     instrument( Mlt::Filter& filter );
+        static void     instrument( Mlt::Transition& transition );
+        /**
+         *  \param measure Whether the frames shown by this consumer are accounted in the
+         *                  stats. Preview consumers are only traced and counted.
+         */
+        static void     instrument( Mlt::Consumer& consumer, bool measure = true );
+};
+
+}
+}
+
+#endif // MLTPIPELINEPROBE_H
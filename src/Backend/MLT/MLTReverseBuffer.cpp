@@ -0,0 +1,390 @@
+/*****************************************************************************
+ * MLTReverseBuffer.cpp: Presents the frames of an input backward from decoded GOPs
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "MLTReverseBuffer.h"
+#include "MLTInput.h"
+#include "Backend/KeyframeIndex.h"
+
+#include <mlt++/MltProducer.h>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace Backend::MLT;
+
+namespace Backend
+{
+namespace MLT
+{
+
+class MLTReverseSource
+{
+    public:
+        explicit MLTReverseSource( mlt_producer producer )
+            : producer( producer )
+        {
+        }
+
+        ~MLTReverseSource()
+        {
+            if ( producer != nullptr )
+                mlt_producer_close( producer );
+        }
+
+        MLTReverseSource( const MLTReverseSource& ) = delete;
+        MLTReverseSource& operator=( const MLTReverseSource& ) = delete;
+
+        // The copy, or nullptr if the source couldn't be copied
+        mlt_producer    producer;
+        // Each buffer's worker and consumer thread may fill chunks, only one at a time uses
+        // the copy, whichever buffer it belongs to.
+        std::mutex      lock;
+};
+
+}
+}
+
+namespace
+{
+
+const char* const       StateProperty = "_vlmc_reverse";
+
+/*
+ * Copies source through its XML serialization. The chunks are decoded from the copy, as
+ * the source is being played by the consumer meanwhile, from another thread.
+ */
+mlt_producer
+cloneProducer( mlt_producer source )
+{
+    auto profile = mlt_service_profile( MLT_PRODUCER_SERVICE( source ) );
+    auto xml = mlt_factory_consumer( profile, "xml", "string" );
+    if ( xml == nullptr )
+        return nullptr;
+    auto properties = MLT_CONSUMER_PROPERTIES( xml );
+    // Keep the locations absolute, whatever the working directory
+    mlt_properties_set( properties, "root", "" );
+    mlt_properties_set_int( properties, "no_meta", 1 );
+    mlt_consumer_connect( xml, MLT_PRODUCER_SERVICE( source ) );
+    // Serializing only reads the graph, but the consumer must not be getting a frame
+    mlt_service_lock( MLT_PRODUCER_SERVICE( source ) );
+    mlt_consumer_start( xml );
+    mlt_service_unlock( MLT_PRODUCER_SERVICE( source ) );
+    mlt_producer res = nullptr;
+    auto serialized = mlt_properties_get( properties, "string" );
+    if ( serialized != nullptr )
+        res = mlt_factory_producer( profile, "xml-string", serialized );
+    mlt_consumer_close( xml );
+    if ( res != nullptr && mlt_producer_get_length( res ) <= 0 )
+    {
+        mlt_producer_close( res );
+        res = nullptr;
+    }
+    return res;
+}
+
+struct Picture
+{
+    int64_t                 position;
+    mlt_image_format        format;
+    int                     width;
+    int                     height;
+    std::vector<uint8_t>    data;
+};
+
+struct Chunk
+{
+    Chunk()
+        : begin( -1 )
+        , end( -1 )
+        , format( mlt_image_none )
+        , width( 0 )
+        , height( 0 )
+    {
+    }
+
+    bool    contains( int64_t position, mlt_image_format f, int w, int h ) const
+    {
+        return begin <= position && position <= end && format == f && width == w && height == h;
+    }
+
+    int64_t                 begin;
+    int64_t                 end;
+    // The picture format requested by the consumer
+    mlt_image_format        format;
+    int                     width;
+    int                     height;
+    std::vector<Picture>    pictures;
+};
+
+struct State
+{
+    State( std::shared_ptr<MLTReverseSource> source, std::shared_ptr<const Backend::KeyframeIndex> index,
+           double fps )
+        : source( std::move( source ) )
+        , index( std::move( index ) )
+        , fps( fps )
+        , stop( false )
+        , busy( false )
+        , requestBegin( -1 )
+        , requestEnd( -1 )
+        , requestFormat( mlt_image_none )
+        , requestWidth( 0 )
+        , requestHeight( 0 )
+        , fillingBegin( -1 )
+        , fillingEnd( -1 )
+    {
+        worker = std::thread( &State::run, this );
+    }
+
+    ~State()
+    {
+        {
+            std::lock_guard<std::mutex> lock( mutex );
+            stop = true;
+        }
+        cond.notify_all();
+        worker.join();
+    }
+
+    int64_t     chunkBegin( int64_t end ) const
+    {
+        auto res = end - MLTReverseBuffer::DefaultChunkLength + 1;
+        if ( index != nullptr && index->isEmpty() == false )
+            res = index->keyframeBefore( end, fps );
+        res = std::max<int64_t>( res, end - MLTReverseBuffer::MaxChunkLength + 1 );
+        return std::max<int64_t>( res, 0 );
+    }
+
+    /*
+     * Decodes [begin, end] forward from a cut of the copied source.
+     */
+    void        fill( Chunk& chunk, int64_t begin, int64_t end, mlt_image_format format, int width, int height )
+    {
+        if ( source == nullptr || source->producer == nullptr )
+            return;
+        std::lock_guard<std::mutex> lock( source->lock );
+        chunk.begin = begin;
+        chunk.end = end;
+        chunk.format = format;
+        chunk.width = width;
+        chunk.height = height;
+        chunk.pictures.reserve( end - begin + 1 );
+
+        auto cut = mlt_producer_cut( source->producer, begin, end );
+        for ( auto position = begin; position <= end && stop == false; ++position )
+        {
+            mlt_producer_seek( cut, position - begin );
+            mlt_frame frame = nullptr;
+            if ( mlt_service_get_frame( MLT_PRODUCER_SERVICE( cut ), &frame, 0 ) != 0 || frame == nullptr )
+                break;
+            Picture picture;
+            picture.position = position;
+            picture.format = format;
+            picture.width = width;
+            picture.height = height;
+            uint8_t* image = nullptr;
+            if ( mlt_frame_get_image( frame, &image, &picture.format, &picture.width, &picture.height, 0 ) == 0 &&
+                 image != nullptr )
+            {
+                auto size = mlt_image_format_size( picture.format, picture.width, picture.height, nullptr );
+                picture.data.assign( image, image + size );
+                chunk.pictures.push_back( std::move( picture ) );
+            }
+            mlt_frame_close( frame );
+        }
+        mlt_producer_close( cut );
+    }
+
+    void        run()
+    {
+        std::unique_lock<std::mutex> lock( mutex );
+        while ( stop == false )
+        {
+            if ( requestEnd < 0 )
+            {
+                cond.wait( lock );
+                continue;
+            }
+            busy = true;
+            fillingBegin = requestBegin;
+            fillingEnd = requestEnd;
+            auto format = requestFormat;
+            auto width = requestWidth;
+            auto height = requestHeight;
+            requestBegin = requestEnd = -1;
+            lock.unlock();
+
+            Chunk chunk;
+            fill( chunk, fillingBegin, fillingEnd, format, width, height );
+
+            lock.lock();
+            previous = std::move( chunk );
+            busy = false;
+            fillingBegin = fillingEnd = -1;
+            cond.notify_all();
+        }
+    }
+
+    /*
+     * Sets the image of frame from the buffer, filling it first if the frame isn't
+     * in there already.
+     */
+    bool        serve( mlt_frame frame, uint8_t** image, mlt_image_format* format, int* width, int* height )
+    {
+        const auto position = mlt_frame_get_position( frame );
+        std::unique_lock<std::mutex> lock( mutex );
+        if ( current.contains( position, *format, *width, *height ) == false )
+        {
+            // The worker may be decoding this very chunk, waiting is cheaper than starting over
+            if ( busy == true && fillingBegin <= position && position <= fillingEnd )
+                cond.wait( lock, [this]{ return busy == false; } );
+            if ( previous.contains( position, *format, *width, *height ) == true )
+            {
+                current = std::move( previous );
+                previous = Chunk();
+            }
+            else
+            {
+                // The playhead jumped, or the worker couldn't keep up
+                lock.unlock();
+                Chunk chunk;
+                fill( chunk, chunkBegin( position ), position, *format, *width, *height );
+                lock.lock();
+                current = std::move( chunk );
+            }
+        }
+        if ( current.begin > 0 && previous.end != current.begin - 1 &&
+             fillingEnd != current.begin - 1 && requestEnd != current.begin - 1 )
+        {
+            requestEnd = current.begin - 1;
+            requestBegin = chunkBegin( requestEnd );
+            requestFormat = current.format;
+            requestWidth = current.width;
+            requestHeight = current.height;
+            cond.notify_all();
+        }
+
+        auto it = std::find_if( std::begin( current.pictures ), std::end( current.pictures ), [position]( const Picture& p ) {
+            return p.position == position;
+        });
+        if ( it == std::end( current.pictures ) )
+            return false;
+        // The frame owns its image, and the chunk may be gone by the time it's displayed
+        auto size = it->data.size();
+        auto buffer = static_cast<uint8_t*>( mlt_pool_alloc( size ) );
+        memcpy( buffer, it->data.data(), size );
+        mlt_frame_set_image( frame, buffer, size, mlt_pool_release );
+        auto properties = MLT_FRAME_PROPERTIES( frame );
+        mlt_properties_set_int( properties, "format", it->format );
+        mlt_properties_set_int( properties, "width", it->width );
+        mlt_properties_set_int( properties, "height", it->height );
+        *image = buffer;
+        *format = it->format;
+        *width = it->width;
+        *height = it->height;
+        return true;
+    }
+
+    std::shared_ptr<MLTReverseSource>               source;
+    std::shared_ptr<const Backend::KeyframeIndex>   index;
+    double                                          fps;
+
+    std::mutex                  mutex;
+    std::condition_variable     cond;
+    std::thread                 worker;
+    std::atomic_bool            stop;
+    bool                        busy;
+
+    Chunk                       current;
+    Chunk                       previous;
+
+    int64_t                     requestBegin;
+    int64_t                     requestEnd;
+    mlt_image_format            requestFormat;
+    int                         requestWidth;
+    int                         requestHeight;
+    int64_t                     fillingBegin;
+    int64_t                     fillingEnd;
+};
+
+void
+releaseState( void* state )
+{
+    delete static_cast<std::shared_ptr<State>*>( state );
+}
+
+int
+getImage( mlt_frame frame, uint8_t** image, mlt_image_format* format, int* width, int* height, int writable )
+{
+    auto state = static_cast<std::shared_ptr<State>*>(
+                mlt_properties_get_data( MLT_FRAME_PROPERTIES( frame ), StateProperty, nullptr ) );
+    if ( state != nullptr && (*state)->serve( frame, image, format, width, height ) == true )
+        return 0;
+    return mlt_frame_get_image( frame, image, format, width, height, writable );
+}
+
+}
+
+std::shared_ptr<MLTReverseSource>
+MLTReverseBuffer::copySource( MLTInput& input )
+{
+    // Positions of the frames are absolute in the source, so are the chunks
+    return std::make_shared<MLTReverseSource>( cloneProducer( input.producer()->parent().get_producer() ) );
+}
+
+MLTReverseBuffer::MLTReverseBuffer( MLTInput& input, std::shared_ptr<MLTReverseSource> source )
+    : m_producer( input.producer()->get_producer() )
+    , m_filter( mlt_filter_new() )
+{
+    auto state = new std::shared_ptr<State>( std::make_shared<State>( std::move( source ), input.keyframeIndex(),
+                                                                      input.fps() ) );
+    mlt_properties_set_data( MLT_FILTER_PROPERTIES( m_filter ), StateProperty, state, 0, &releaseState, nullptr );
+    m_filter->process = &MLTReverseBuffer::process;
+    mlt_service_attach( MLT_PRODUCER_SERVICE( m_producer ), m_filter );
+}
+
+MLTReverseBuffer::~MLTReverseBuffer()
+{
+    mlt_service_detach( MLT_PRODUCER_SERVICE( m_producer ), m_filter );
+    // Frames still in flight keep the buffer alive until they are closed
+    mlt_filter_close( m_filter );
+}
+
+mlt_frame
+MLTReverseBuffer::process( mlt_filter filter, mlt_frame frame )
+{
+    auto state = static_cast<std::shared_ptr<State>*>(
+                mlt_properties_get_data( MLT_FILTER_PROPERTIES( filter ), StateProperty, nullptr ) );
+    mlt_properties_set_data( MLT_FRAME_PROPERTIES( frame ), StateProperty, new std::shared_ptr<State>( *state ),
+                             0, &releaseState, nullptr );
+    mlt_frame_push_get_image( frame, &getImage );
+    return frame;
+}
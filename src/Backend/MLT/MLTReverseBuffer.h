@@ -0,0 +1,92 @@
+/*****************************************************************************
+ * MLTReverseBuffer.h: Presents the frames of an input backward from decoded GOPs
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef MLTREVERSEBUFFER_H
+#define MLTREVERSEBUFFER_H
+
+#include <memory>
+
+struct mlt_filter_s;
+struct mlt_frame_s;
+struct mlt_producer_s;
+
+namespace Backend
+{
+namespace MLT
+{
+
+class MLTInput;
+class MLTReverseSource;
+
+/**
+ * \brief   Serves the frames of an input played backward from whole decoded GOPs.
+ *
+ * Decoders only run forward from a keyframe, so each step backward decodes the whole GOP
+ * preceding the requested frame. While it exists, the buffer hooks the image callbacks of
+ * the input: the first frame requested in a chunk decodes the chunk forward once and keeps
+ * its pictures, which are then presented from memory in any order. The chunk preceding the
+ * one being presented is decoded on a worker thread meanwhile, so that playing backward
+ * costs about the same as playing forward.
+ *
+ * The chunks are decoded from a copy of the input's source, made through its XML
+ * serialization by copySource(): the source itself is being played by the consumer.
+ * Copying the timeline reopens all of its producers, so MLTInput keeps the copy across
+ * the buffers it creates, and only drops it once the graph or the filters are edited.
+ * The buffer itself only lives while stepping or playing backward: playing forward or
+ * seeking drops it, so that the frames it serves are the ones reached backward.
+ *
+ * Chunks start on the keyframes of the input when its keyframe index is known, and are
+ * bounded in length either way. The timeline has no index of its own, so its chunks are
+ * of a fixed length and don't follow the keyframes of its clips.
+ */
+class MLTReverseBuffer
+{
+    public:
+        static const int        DefaultChunkLength = 12;
+        static const int        MaxChunkLength = 32;
+
+        /**
+         *  \brief  Copies the source of input, for the buffers created until it's edited.
+         *
+         *  Must be called while no buffer is attached to input, so that the copy doesn't
+         *  carry one.
+         */
+        static std::shared_ptr<MLTReverseSource>    copySource( MLTInput& input );
+
+        MLTReverseBuffer( MLTInput& input, std::shared_ptr<MLTReverseSource> source );
+        ~MLTReverseBuffer();
+
+        MLTReverseBuffer( const MLTReverseBuffer& ) = delete;
+        MLTReverseBuffer& operator=( const MLTReverseBuffer& ) = delete;
+
+    private:
+        static mlt_frame_s*     process( mlt_filter_s* filter, mlt_frame_s* frame );
+
+    private:
+        mlt_producer_s*         m_producer;
+        mlt_filter_s*           m_filter;
+};
+
+}
+}
+
+#endif // MLTREVERSEBUFFER_H
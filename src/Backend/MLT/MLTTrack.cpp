@@ -87,7 +87,7 @@ MLTTrack::insertAt( Backend::IInput& input, int64_t startFrame )
 void
 MLTTrack::remove( int index )
 {
-    std::unique_ptr<Mlt::Producer> mltProducer( playlist()->replace_with_blank( index ) );
+    retire( playlist()->replace_with_blank( index ) );
     playlist()->consolidate_blanks( 0 );
 }
 
@@ -149,9 +149,22 @@ MLTTrack::count() const
 void
 MLTTrack::clear()
 {
+    for ( int i = 0; i < playlist()->count(); ++i )
+        retire( playlist()->get_clip( i ) );
     playlist()->clear();
 }
 
+void
+MLTTrack::retire( Mlt::Producer* producer )
+{
+    auto now = Clock::now();
+    while ( m_retired.empty() == false &&
+            now - m_retired.front().first > std::chrono::milliseconds( RetireDelay ) )
+        m_retired.pop_front();
+    if ( producer != nullptr )
+        m_retired.emplace_back( now, std::unique_ptr<Mlt::Producer>( producer ) );
+}
+
 void
 MLTTrack::hide( Backend::HideType hydeType )
 {
@@ -27,6 +27,11 @@
 #include "MLTInput.h"
 #include "Backend/ITrack.h"
 
+#include <chrono>
+#include <deque>
+#include <memory>
+#include <utility>
+
 namespace Mlt
 {
 class Playlist;
@@ -63,8 +68,18 @@ class MLTTrack : public ITrack, public MLTInput
         virtual void        clear() override;
         virtual void        hide( HideType hideType ) override;
 
+        // How long a removed clip is kept alive, in ms
+        static const int    RetireDelay = 2000;
+
     private:
+        void                retire( Mlt::Producer* producer );
+
+    private:
+        typedef std::chrono::steady_clock   Clock;
+
         Mlt::Playlist*                  m_playlist;
+        // The frames already produced by a playing output may still use a removed clip
+        std::deque<std::pair<Clock::time_point, std::unique_ptr<Mlt::Producer>>>  m_retired;
 };
 
 }
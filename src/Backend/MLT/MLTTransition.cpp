@@ -29,6 +29,7 @@
 #include <mlt++/MltTransition.h>
 #include "MLTProfile.h"
 #include "MLTBackend.h"
+#include "MLTPipelineProbe.h"
 
 using namespace Backend::MLT;
 
@@ -38,6 +39,7 @@ MLTTransition::MLTTransition( Backend::IProfile& profile, const char *id )
     m_transition = new Mlt::Transition( *mltProfile.m_profile, id );
     if ( isValid() == false )
         throw InvalidServiceException();
+    MLTPipelineProbe::instrument( *m_transition );
 }
 
 MLTTransition::MLTTransition( const char* id )
@@ -0,0 +1,374 @@
+/*****************************************************************************
+ * Benchmark.cpp: Measures the performance of VLMC on a synthetic project
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "Benchmark.h"
+#include "Backend/IInput.h"
+#include "Backend/IOutput.h"
+#include "Backend/MLT/MLTOutput.h"
+#include "Commands/AbstractUndoStack.h"
+#include "Library/Library.h"
+#include "Main/Core.h"
+#include "Project/Project.h"
+#include "Settings/Settings.h"
+#include "Tools/VlmcDebug.h"
+#include "Workflow/MainWorkflow.h"
+#include "Workflow/Types.h"
+
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QTimer>
+#include <QUuid>
+
+#include <algorithm>
+#include <numeric>
+#include <vector>
+
+struct Metric
+{
+    const char*     name;
+    bool            higherIsBetter;
+};
+
+static const Metric    Metrics[] = {
+    { "generateMs", false },
+    { "editOpsPerSecond", true },
+    { "loadJsonMs", false },
+    { "loadBinaryMs", false },
+    { "seekLatencyMs", false },
+    { "seekLatencyP95Ms", false },
+    { "previewFps", true },
+    { "exportFps", true },
+};
+
+/// Nothing paces the preview output when it doesn't play its audio
+class DiscardAudioSink : public Backend::IAudioSink
+{
+    public:
+        virtual void    onAudio( const int16_t*, int, int, int ) override
+        {
+        }
+};
+
+static double
+elapsedMs( const QElapsedTimer& timer )
+{
+    return timer.nsecsElapsed() / 1e6;
+}
+
+Benchmark::Options::Options()
+    : width( 1280 )
+    , height( 720 )
+    , nbEdits( 300 )
+    , nbSeeks( 100 )
+    , previewDuration( 5000 )
+    , exportLength( 250 )
+    , seed( 1 )
+{
+}
+
+QJsonObject
+Benchmark::Options::toJson() const
+{
+    auto res = project.toJson();
+    res["width"] = width;
+    res["height"] = height;
+    res["edits"] = nbEdits;
+    res["seeks"] = nbSeeks;
+    res["previewDuration"] = previewDuration;
+    res["exportLength"] = exportLength;
+    res["seed"] = static_cast<qint64>( seed );
+    return res;
+}
+
+Benchmark::Benchmark( const Options& options )
+    : m_options( options )
+    , m_project( options.project )
+    , m_random( options.seed )
+{
+}
+
+bool
+Benchmark::run()
+{
+    if ( m_dir.isValid() == false )
+    {
+        vlmcCritical() << "Can't create a temporary directory";
+        return false;
+    }
+    auto settings = Core::instance()->project()->settings();
+    settings->setValue( "general/ProjectName", QStringLiteral( "Benchmark" ) );
+    settings->setValue( "video/VideoProjectWidth", m_options.width );
+    settings->setValue( "video/VideoProjectHeight", m_options.height );
+
+    QElapsedTimer   timer;
+    timer.start();
+    if ( m_project.generate( Core::instance()->workflow(), Core::instance()->library() ) == false )
+        return false;
+    m_metrics["generateMs"] = elapsedMs( timer );
+
+    auto res = measureEdits();
+    // The remaining measurements run on the loaded project
+    if ( measureLoad() == false )
+        return false;
+    measureSeeks();
+    measurePreview();
+    return measureExport() && res;
+}
+
+bool
+Benchmark::measureEdits()
+{
+    if ( m_options.nbEdits <= 0 )
+        return true;
+
+    struct Instance
+    {
+        QString     uuid;
+        quint32     trackId;
+        qint64      position;
+    };
+    auto workflow = Core::instance()->workflow();
+    std::vector<Instance>   instances;
+    for ( const auto& uuid : m_project.clips() )
+    {
+        auto info = workflow->clipInfo( uuid );
+        if ( info.isEmpty() == true )
+            continue;
+        instances.push_back( { uuid, static_cast<quint32>( info["trackId"].toInt() ),
+                               static_cast<qint64>( info["position"].toDouble() ) } );
+    }
+    if ( instances.empty() == true )
+    {
+        vlmcCritical() << "No clip to edit";
+        return false;
+    }
+
+    // Every edit is undone right away, so they all apply to the generated timeline
+    const auto length = m_options.project.clipLength;
+    const auto trackEnd = m_options.project.nbClips * length;
+    std::uniform_int_distribution<size_t>   pickClip( 0, instances.size() - 1 );
+    std::uniform_int_distribution<qint64>   pickOffset( 1, std::max<qint64>( 1, length / 4 ) );
+    QElapsedTimer   timer;
+    timer.start();
+    for ( int i = 0; i < m_options.nbEdits; ++i )
+    {
+        const auto& c = instances[pickClip( m_random )];
+        const auto offset = pickOffset( m_random );
+        switch ( i % 3 )
+        {
+        case 0:
+            // Past the last clip of the track, where there's room for it
+            workflow->moveClip( c.uuid, c.trackId, trackEnd + offset );
+            break;
+        case 1:
+            workflow->resizeClip( c.uuid, offset, length - 1, c.position + offset );
+            break;
+        default:
+            workflow->splitClip( QUuid( c.uuid ), c.position + offset, offset );
+            break;
+        }
+        workflow->undoStack()->undo();
+    }
+    // Undoing is an edit as well
+    m_metrics["editOpsPerSecond"] = m_options.nbEdits * 2 / ( timer.nsecsElapsed() / 1e9 );
+    return true;
+}
+
+bool
+Benchmark::measureLoad()
+{
+    auto project = Core::instance()->project();
+    auto settings = project->settings();
+    auto workflow = Core::instance()->workflow();
+    const auto length = workflow->playableLength();
+    const QString   files[] = {
+        m_dir.filePath( QStringLiteral( "benchmark.vlmc" ) ),
+        m_dir.filePath( QStringLiteral( "benchmark" ) + Project::binaryExtension ),
+    };
+    const Settings::Format  formats[] = { Settings::Json, Settings::Binary };
+    const char* const       metrics[] = { "loadJsonMs", "loadBinaryMs" };
+
+    for ( int i = 0; i < 2; ++i )
+    {
+        settings->setFormat( formats[i] );
+        settings->setSettingsFile( files[i] );
+        if ( settings->save() == false )
+        {
+            vlmcCritical() << "Can't save the project to" << files[i];
+            return false;
+        }
+    }
+    for ( int i = 0; i < 2; ++i )
+    {
+        // Loading only clears a project which was loaded from a file
+        workflow->clear();
+        Core::instance()->library()->clear();
+        QElapsedTimer   timer;
+        timer.start();
+        if ( project->load( files[i] ) == false )
+        {
+            vlmcCritical() << "Can't load the project from" << files[i];
+            return false;
+        }
+        m_metrics[metrics[i]] = elapsedMs( timer );
+        if ( workflow->playableLength() != length )
+        {
+            vlmcCritical() << "The loaded timeline lasts" << workflow->playableLength()
+                           << "frames instead of" << length;
+            return false;
+        }
+    }
+    return true;
+}
+
+void
+Benchmark::measureSeeks()
+{
+    auto input = Core::instance()->workflow()->input();
+    const auto length = input->playableLength();
+    if ( m_options.nbSeeks <= 0 || length <= 0 )
+        return;
+
+    std::uniform_int_distribution<int64_t>  pickPosition( 0, length - 1 );
+    std::vector<double>     latencies;
+    latencies.reserve( m_options.nbSeeks );
+    for ( int i = 0; i < m_options.nbSeeks; ++i )
+    {
+        const auto position = pickPosition( m_random );
+        QElapsedTimer   timer;
+        timer.start();
+        input->setPosition( position );
+        input->image( m_options.width, m_options.height );
+        latencies.push_back( elapsedMs( timer ) );
+    }
+    std::sort( latencies.begin(), latencies.end() );
+    m_metrics["seekLatencyMs"] = std::accumulate( latencies.begin(), latencies.end(), 0.0 ) / latencies.size();
+    m_metrics["seekLatencyP95Ms"] = latencies[( latencies.size() - 1 ) * 95 / 100];
+}
+
+void
+Benchmark::measurePreview()
+{
+    auto input = Core::instance()->workflow()->input();
+    const auto length = input->playableLength();
+    if ( m_options.previewDuration <= 0 || length <= 0 )
+        return;
+
+    DiscardAudioSink                    audioSink;
+    Backend::MLT::MLTFrameSinkOutput    output( &audioSink );
+    output.connect( *input );
+    input->setPosition( 0 );
+
+    QElapsedTimer   timer;
+    QEventLoop      loop;
+    QTimer          poll;
+    // Frames shown past the end of the timeline would only be blank ones
+    QObject::connect( &poll, &QTimer::timeout, &loop, [this, &timer, &loop, input, length] {
+        if ( timer.elapsed() >= m_options.previewDuration || input->frame() >= length - 1 )
+            loop.quit();
+    } );
+    timer.start();
+    output.start();
+    poll.start( 10 );
+    loop.exec();
+    const auto nbFrames = output.framesShown();
+    const auto elapsed = timer.nsecsElapsed();
+    output.stop();
+    if ( nbFrames > 0 )
+        m_metrics["previewFps"] = nbFrames / ( elapsed / 1e9 );
+}
+
+bool
+Benchmark::measureExport()
+{
+    auto workflow = Core::instance()->workflow();
+    const auto end = std::min( m_options.exportLength, workflow->playableLength() ) - 1;
+    if ( end < 0 )
+        return true;
+
+    QList<Workflow::OutputSettings>     outputs{
+        Core::instance()->project()->outputSettings( m_dir.filePath( QStringLiteral( "export.mp4" ) ) )
+    };
+    QElapsedTimer   timer;
+    timer.start();
+    if ( workflow->renderToFiles( outputs, 0, end ) == false )
+    {
+        vlmcCritical() << "The export failed";
+        return false;
+    }
+    m_metrics["exportFps"] = ( end + 1 ) / ( timer.nsecsElapsed() / 1e9 );
+    return true;
+}
+
+QJsonObject
+Benchmark::results() const
+{
+    return QJsonObject{
+        { "version", QStringLiteral( PACKAGE_VERSION ) },
+        { "options", m_options.toJson() },
+        { "metrics", m_metrics },
+    };
+}
+
+QJsonArray
+Benchmark::compare( const QJsonObject& results, const QJsonObject& baseline, double threshold )
+{
+    if ( results["options"] != baseline["options"] )
+        vlmcWarning() << "The baseline was measured with other options, its metrics may not compare";
+
+    const auto metrics = results["metrics"].toObject();
+    const auto reference = baseline["metrics"].toObject();
+    QJsonArray  regressions;
+    for ( const auto& m : Metrics )
+    {
+        if ( reference.contains( m.name ) == false )
+            continue;
+        const auto base = reference[m.name].toDouble();
+        // A measurement which failed is a regression as well
+        if ( metrics.contains( m.name ) == false )
+        {
+            regressions.append( QJsonObject{
+                { "metric", QLatin1String( m.name ) },
+                { "value", QJsonValue() },
+                { "baseline", base },
+            } );
+            continue;
+        }
+        const auto value = metrics[m.name].toDouble();
+        if ( base <= 0 )
+            continue;
+        const auto change = ( value - base ) * 100 / base;
+        if ( ( m.higherIsBetter == true ? -change : change ) <= threshold )
+            continue;
+        regressions.append( QJsonObject{
+            { "metric", QLatin1String( m.name ) },
+            { "value", value },
+            { "baseline", base },
+            { "change", change },
+        } );
+    }
+    return regressions;
+}
@@ -0,0 +1,110 @@
+/*****************************************************************************
+ * Benchmark.h: Measures the performance of VLMC on a synthetic project
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include "SyntheticProject.h"
+
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QTemporaryDir>
+
+#include <random>
+
+/**
+ *  \brief  Measures VLMC on a synthetic project, without any GUI nor media file.
+ *
+ *  The measurements run in this order, on the project of the current Core:
+ *  - "generateMs": building the timeline through MainWorkflow
+ *  - "editOpsPerSecond": moving, trimming and splitting random clips, each edit
+ *    being undone right away so that the timeline stays the same
+ *  - "loadJsonMs", "loadBinaryMs": loading the project saved in each format
+ *  - "seekLatencyMs", "seekLatencyP95Ms": getting the picture at a random position
+ *    of the whole timeline
+ *  - "previewFps": the frames the preview output produces per second, nothing
+ *    pacing it
+ *  - "exportFps": the frames encoded per second while rendering the beginning of
+ *    the timeline
+ *  Measurements which fail are left out of the results.
+ */
+class Benchmark
+{
+    public:
+        struct Options
+        {
+            Options();
+
+            SyntheticProject::Parameters    project;
+            int         width;
+            int         height;
+            int         nbEdits;
+            int         nbSeeks;
+            /// In milliseconds
+            int         previewDuration;
+            /// In frames
+            qint64      exportLength;
+            quint32     seed;
+
+            QJsonObject toJson() const;
+        };
+
+        explicit Benchmark( const Options& options );
+
+        /**
+         *  \return false if the synthetic project couldn't be created, or if a
+         *          measurement failed.
+         */
+        bool                run();
+
+        /**
+         *  \return The options and the metrics, as a JSON object which can be used as
+         *          a baseline.
+         */
+        QJsonObject         results() const;
+
+        /**
+         *  \brief  Compares results with a baseline obtained with the same options.
+         *
+         *  \param  threshold   How much worse than the baseline a metric may get, in percent
+         *  \return The metrics which regressed: their name, value, baseline value and
+         *          change in percent.
+         */
+        static QJsonArray   compare( const QJsonObject& results, const QJsonObject& baseline,
+                                     double threshold );
+
+    private:
+        bool                measureEdits();
+        bool                measureLoad();
+        void                measureSeeks();
+        void                measurePreview();
+        bool                measureExport();
+
+    private:
+        Options             m_options;
+        SyntheticProject    m_project;
+        QJsonObject         m_metrics;
+        QTemporaryDir       m_dir;
+        std::mt19937        m_random;
+};
+
+#endif // BENCHMARK_H
@@ -0,0 +1,349 @@
+/*****************************************************************************
+ * EditBenchmarks.cpp: Microbenchmarks of the timeline edits
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "EditBenchmarks.h"
+#include "MicroBenchmark.h"
+#include "Backend/MLT/MLTTrack.h"
+#include "Commands/AbstractUndoStack.h"
+#include "Commands/Commands.h"
+#include "Media/Clip.h"
+#include "Media/Media.h"
+#include "Workflow/SequenceWorkflow.h"
+#include "Workflow/Track.h"
+#include "Workflow/Types.h"
+
+#include <QUuid>
+#include <QVector>
+
+#include <mlt++/MltPlaylist.h>
+
+namespace
+{
+
+const qint64    ClipLength = 10;
+
+/*
+ * A generated media long enough for all the clips of a fixture. It needs no file, and
+ * its cuts are cheap to create.
+ */
+QSharedPointer<Media>
+createMedia( int size )
+{
+    return QSharedPointer<Media>::create( QStringLiteral( "color:#808080" ), ( size + 2 ) * ClipLength );
+}
+
+/*
+ * A sequence workflow with a single track, holding \p size instances of the same clip.
+ */
+class SequenceWorkflowCase : public MicroBenchmark::Case
+{
+public:
+    virtual void setUp( int size ) override
+    {
+        m_media = createMedia( size );
+        m_clip = QSharedPointer<Clip>::create( m_media, 0, ClipLength - 1 );
+        m_workflow = std::make_shared<SequenceWorkflow>( 1 );
+        m_uuids.clear();
+        m_uuids.reserve( size );
+        for ( int i = 0; i < size; ++i )
+            m_uuids << m_workflow->addClip( m_clip, 0, i * ClipLength, QUuid(), false );
+        m_middle = size / 2;
+        m_end = size * ClipLength;
+    }
+
+    virtual void tearDown() override
+    {
+        m_workflow.reset();
+        m_clip.clear();
+        m_media.clear();
+    }
+
+protected:
+    qint64 middlePos() const
+    {
+        return m_middle * ClipLength;
+    }
+
+protected:
+    QSharedPointer<Media>               m_media;
+    QSharedPointer<Clip>                m_clip;
+    std::shared_ptr<SequenceWorkflow>   m_workflow;
+    QVector<QUuid>                      m_uuids;
+    int                                 m_middle;
+    qint64                              m_end;
+};
+
+class AddClip : public SequenceWorkflowCase
+{
+public:
+    virtual QString name() const override { return QStringLiteral( "SequenceWorkflow::addClip" ); }
+
+    virtual void run() override
+    {
+        m_added = m_workflow->addClip( m_clip, 0, m_end, QUuid(), false );
+    }
+
+    virtual void restore() override
+    {
+        m_workflow->removeClip( m_added );
+    }
+
+private:
+    QUuid   m_added;
+};
+
+class MoveClip : public SequenceWorkflowCase
+{
+public:
+    virtual QString name() const override { return QStringLiteral( "SequenceWorkflow::moveClip" ); }
+
+    virtual void run() override
+    {
+        m_workflow->moveClip( m_uuids[m_middle], 0, m_end );
+    }
+
+    virtual void restore() override
+    {
+        m_workflow->moveClip( m_uuids[m_middle], 0, middlePos() );
+    }
+};
+
+class ResizeClip : public SequenceWorkflowCase
+{
+public:
+    virtual QString name() const override { return QStringLiteral( "SequenceWorkflow::resizeClip" ); }
+
+    // The first resize duplicates the clip, which the warm-up run takes care of
+    virtual void run() override
+    {
+        m_workflow->resizeClip( m_uuids[m_middle], 0, ClipLength - 2, middlePos() );
+    }
+
+    virtual void restore() override
+    {
+        m_workflow->resizeClip( m_uuids[m_middle], 0, ClipLength - 1, middlePos() );
+    }
+};
+
+class RemoveClip : public SequenceWorkflowCase
+{
+public:
+    virtual QString name() const override { return QStringLiteral( "SequenceWorkflow::removeClip" ); }
+
+    virtual void run() override
+    {
+        m_workflow->removeClip( m_uuids[m_middle] );
+    }
+
+    virtual void restore() override
+    {
+        m_workflow->addClip( m_clip, 0, middlePos(), m_uuids[m_middle], false );
+    }
+};
+
+/*
+ * Undoing and redoing a move, through the undo stack used by the workflow.
+ */
+class UndoRedo : public SequenceWorkflowCase
+{
+public:
+    virtual QString name() const override { return QStringLiteral( "Commands::Clip::Move undo/redo" ); }
+
+    virtual void setUp( int size ) override
+    {
+        SequenceWorkflowCase::setUp( size );
+        m_undoStack.reset( new Commands::AbstractUndoStack );
+        m_undoStack->push( new Commands::Clip::Move( m_workflow, m_uuids[m_middle].toString(), 0, m_end ) );
+    }
+
+    virtual void run() override
+    {
+        m_undoStack->undo();
+        m_undoStack->redo();
+    }
+
+    virtual void tearDown() override
+    {
+        m_undoStack.reset();
+        SequenceWorkflowCase::tearDown();
+    }
+
+private:
+    std::unique_ptr<Commands::AbstractUndoStack>    m_undoStack;
+};
+
+class InsertableTrackIndex : public MicroBenchmark::Case
+{
+public:
+    virtual QString name() const override { return QStringLiteral( "Track::insertableTrackIndex" ); }
+
+    virtual void setUp( int size ) override
+    {
+        m_media = createMedia( size );
+        m_clip = QSharedPointer<Clip>::create( m_media, 0, ClipLength - 1 );
+        m_track.reset( new Track( Workflow::VideoTrack ) );
+        for ( int i = 0; i < size; ++i )
+        {
+            auto c = QSharedPointer<SequenceWorkflow::ClipInstance>::create( m_clip, QUuid::createUuid(),
+                                                                            0, i * ClipLength, false );
+            m_track->addClip( c, c->pos );
+        }
+        // Collides with the clip in the middle
+        m_probe = QSharedPointer<SequenceWorkflow::ClipInstance>::create( m_clip, QUuid::createUuid(), 0,
+                                                                         size / 2 * ClipLength, false );
+    }
+
+    virtual void run() override
+    {
+        m_index = m_track->insertableTrackIndex( m_probe );
+    }
+
+    virtual void tearDown() override
+    {
+        m_probe.clear();
+        m_track.reset();
+        m_clip.clear();
+        m_media.clear();
+    }
+
+private:
+    QSharedPointer<Media>                           m_media;
+    QSharedPointer<Clip>                            m_clip;
+    std::unique_ptr<Track>                          m_track;
+    QSharedPointer<SequenceWorkflow::ClipInstance>  m_probe;
+    // Keeps the call from being optimized out
+    quint32                                         m_index;
+};
+
+/*
+ * A MLT playlist of \p size clips. The clip in the middle has its own cut, so that
+ * resizing it leaves the others alone.
+ */
+class MLTTrackCase : public MicroBenchmark::Case
+{
+public:
+    virtual void setUp( int size ) override
+    {
+        m_media = createMedia( size );
+        m_clip = QSharedPointer<Clip>::create( m_media, 0, ClipLength - 1 );
+        m_middleClip = QSharedPointer<Clip>::create( m_media, 0, ClipLength - 1 );
+        m_track.reset( new Backend::MLT::MLTTrack );
+        m_middle = size / 2;
+        m_end = size * ClipLength;
+        for ( int i = 0; i < size; ++i )
+            m_track->append( *( i == m_middle ? m_middleClip : m_clip )->input() );
+    }
+
+    virtual void tearDown() override
+    {
+        m_track.reset();
+        m_middleClip.clear();
+        m_clip.clear();
+        m_media.clear();
+    }
+
+protected:
+    QSharedPointer<Media>                   m_media;
+    QSharedPointer<Clip>                    m_clip;
+    QSharedPointer<Clip>                    m_middleClip;
+    std::unique_ptr<Backend::MLT::MLTTrack> m_track;
+    int                                     m_middle;
+    qint64                                  m_end;
+};
+
+class MLTTrackMove : public MLTTrackCase
+{
+public:
+    virtual QString name() const override { return QStringLiteral( "MLTTrack::move" ); }
+
+    virtual void run() override
+    {
+        m_track->move( m_middle * ClipLength, m_end );
+    }
+
+    virtual void restore() override
+    {
+        m_track->move( m_end, m_middle * ClipLength );
+    }
+};
+
+class MLTTrackResizeClip : public MLTTrackCase
+{
+public:
+    virtual QString name() const override { return QStringLiteral( "MLTTrack::resizeClip" ); }
+
+    virtual void run() override
+    {
+        m_track->resizeClip( m_middle, 0, ClipLength - 2 );
+    }
+
+    // Shrinking the clip inserted a blank after it, so that the next clips stay in place
+    virtual void restore() override
+    {
+        m_track->playlist()->remove( m_middle + 1 );
+        m_track->resizeClip( m_middle, 0, ClipLength - 1 );
+    }
+};
+
+class MLTTrackRemove : public MLTTrackCase
+{
+public:
+    virtual QString name() const override { return QStringLiteral( "MLTTrack::remove" ); }
+
+    virtual void run() override
+    {
+        m_track->remove( m_middle );
+    }
+
+    // The clip was replaced with a blank of the same length
+    virtual void restore() override
+    {
+        m_track->insertAt( *m_middleClip->input(), m_middle * ClipLength );
+    }
+};
+
+template <typename T>
+void
+add( MicroBenchmark& benchmark )
+{
+    benchmark.add( std::unique_ptr<MicroBenchmark::Case>( new T ) );
+}
+
+}
+
+void
+EditBenchmarks::registerCases( MicroBenchmark& benchmark )
+{
+    add<AddClip>( benchmark );
+    add<MoveClip>( benchmark );
+    add<ResizeClip>( benchmark );
+    add<RemoveClip>( benchmark );
+    add<UndoRedo>( benchmark );
+    add<InsertableTrackIndex>( benchmark );
+    add<MLTTrackMove>( benchmark );
+    add<MLTTrackResizeClip>( benchmark );
+    add<MLTTrackRemove>( benchmark );
+}
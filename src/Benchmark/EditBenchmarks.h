@@ -0,0 +1,40 @@
+/*****************************************************************************
+ * EditBenchmarks.h: Microbenchmarks of the timeline edits
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef EDITBENCHMARKS_H
+#define EDITBENCHMARKS_H
+
+class MicroBenchmark;
+
+/**
+ *  \brief  The edits of a timeline, from the sequence workflow down to the MLT playlists.
+ *
+ *  The fixtures are timelines of generated clips laid back to back on a single track,
+ *  and each edit works on the clip in their middle, so that the cost of walking the
+ *  playlists shows.
+ */
+namespace EditBenchmarks
+{
+    void    registerCases( MicroBenchmark& benchmark );
+}
+
+#endif // EDITBENCHMARKS_H
@@ -0,0 +1,157 @@
+/*****************************************************************************
+ * MicroBenchmark.cpp: Times operations against the size of their data
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "MicroBenchmark.h"
+
+#include <QJsonArray>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+typedef std::chrono::steady_clock   Clock;
+
+MicroBenchmark::MicroBenchmark( const QList<int>& sizes, int minTime, int minIterations )
+    : m_sizes( sizes )
+    , m_minTime( minTime )
+    , m_minIterations( minIterations )
+{
+    std::sort( m_sizes.begin(), m_sizes.end() );
+}
+
+void
+MicroBenchmark::add( std::unique_ptr<Case> c )
+{
+    m_cases.push_back( std::move( c ) );
+}
+
+QList<MicroBenchmark::Result>
+MicroBenchmark::run( const QString& filter )
+{
+    QList<Result>   results;
+    for ( const auto& c : m_cases )
+    {
+        if ( filter.isEmpty() == false && c->name().contains( filter ) == false )
+            continue;
+        Result  res;
+        res.name = c->name();
+        for ( auto size : m_sizes )
+        {
+            c->setUp( size );
+            res.sizes << size;
+            res.nsPerOp << measure( *c );
+            c->tearDown();
+        }
+        // Constant costs hide how the small sizes scale, only fit the larger ones
+        const int first = qMax( 0, qMin( res.sizes.size() / 2, res.sizes.size() - 2 ) );
+        res.exponent = fitExponent( res.sizes.mid( first ), res.nsPerOp.mid( first ) );
+        results << res;
+    }
+    return results;
+}
+
+double
+MicroBenchmark::measure( Case& c )
+{
+    // The first run may take a slower path, ie. to fill a cache
+    c.run();
+    c.restore();
+
+    const auto  minTime = std::chrono::milliseconds( m_minTime );
+    Clock::duration total( 0 );
+    int nbIterations = 0;
+    while ( nbIterations < m_minIterations || total < minTime )
+    {
+        const auto start = Clock::now();
+        c.run();
+        total += Clock::now() - start;
+        c.restore();
+        ++nbIterations;
+    }
+    return std::chrono::duration_cast<std::chrono::nanoseconds>( total ).count() / (double)nbIterations;
+}
+
+double
+MicroBenchmark::fitExponent( const QVector<int>& sizes, const QVector<double>& times )
+{
+    const int n = qMin( sizes.size(), times.size() );
+    if ( n < 2 )
+        return 0;
+    double sx = 0, sy = 0, sxx = 0, sxy = 0;
+    for ( int i = 0; i < n; ++i )
+    {
+        const auto x = std::log( (double)sizes[i] );
+        const auto y = std::log( qMax( times[i], 1.0 ) );
+        sx += x;
+        sy += y;
+        sxx += x * x;
+        sxy += x * y;
+    }
+    const auto d = n * sxx - sx * sx;
+    if ( d == 0 )
+        return 0;
+    return ( n * sxy - sx * sy ) / d;
+}
+
+QJsonObject
+MicroBenchmark::Result::toJson() const
+{
+    QJsonArray  s;
+    QJsonArray  t;
+    for ( int i = 0; i < sizes.size(); ++i )
+    {
+        s.append( sizes[i] );
+        t.append( nsPerOp[i] );
+    }
+    return QJsonObject{
+        { "name", name },
+        { "sizes", s },
+        { "nsPerOp", t },
+        { "exponent", exponent },
+    };
+}
+
+QString
+MicroBenchmark::Result::toText() const
+{
+    QString res = QStringLiteral( "%1    ~ n^%2\n" ).arg( name ).arg( exponent, 0, 'f', 2 );
+    res += QStringLiteral( "%1 %2 %3\n" ).arg( QStringLiteral( "size" ), 10 )
+            .arg( QStringLiteral( "ns/op" ), 14 ).arg( QStringLiteral( "slope" ), 7 );
+    const auto fastest = qMax( 1.0, *std::min_element( nsPerOp.begin(), nsPerOp.end() ) );
+    for ( int i = 0; i < sizes.size(); ++i )
+    {
+        QString slope;
+        if ( i > 0 )
+            slope = QString::number( std::log( qMax( nsPerOp[i], 1.0 ) / qMax( nsPerOp[i - 1], 1.0 ) ) /
+                                     std::log( (double)sizes[i] / sizes[i - 1] ), 'f', 2 );
+        // Log-log: 10 columns per decade of time, so the sizes being decades apart, a
+        // linear operation grows by 10 columns a line and a quadratic one by 20.
+        const int width = qBound( 1, 1 + qRound( std::log10( qMax( nsPerOp[i], 1.0 ) / fastest ) * 10 ), 80 );
+        res += QStringLiteral( "%1 %2 %3  |%4\n" ).arg( sizes[i], 10 ).arg( nsPerOp[i], 14, 'f', 0 )
+                .arg( slope, 7 ).arg( QString( width, '#' ) );
+    }
+    return res;
+}
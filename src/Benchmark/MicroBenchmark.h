@@ -0,0 +1,99 @@
+/*****************************************************************************
+ * MicroBenchmark.h: Times operations against the size of their data
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef MICROBENCHMARK_H
+#define MICROBENCHMARK_H
+
+#include <QJsonObject>
+#include <QList>
+#include <QString>
+#include <QVector>
+
+#include <memory>
+#include <vector>
+
+/**
+ *  \brief  Times an operation against the size of the data it works on.
+ *
+ *  Each case is timed on fixtures of growing sizes. Single numbers hide how an
+ *  operation scales, so the result of a case is its time per operation at each size,
+ *  and the exponent of the power law which fits it best: 0 for an operation which
+ *  doesn't depend on the size, 1 for a linear one, 2 for a quadratic one.
+ */
+class MicroBenchmark
+{
+    public:
+        class Case
+        {
+            public:
+                virtual ~Case() = default;
+
+                virtual QString     name() const = 0;
+                /// Builds a fixture of \p size elements
+                virtual void        setUp( int size ) = 0;
+                /// The timed operation
+                virtual void        run() = 0;
+                /// Brings the fixture back to its state before run(). Not timed.
+                virtual void        restore() {}
+                virtual void        tearDown() = 0;
+        };
+
+        struct Result
+        {
+            QString         name;
+            QVector<int>    sizes;
+            QVector<double> nsPerOp;
+            double          exponent;
+
+            QJsonObject     toJson() const;
+            /// The times per operation as a table and a log-log plot
+            QString         toText() const;
+        };
+
+        /**
+         *  \param  minTime         How long to run the operation for at each size, in ms
+         *  \param  minIterations   How many times to run it at least
+         */
+        MicroBenchmark( const QList<int>& sizes, int minTime, int minIterations );
+
+        void                add( std::unique_ptr<Case> c );
+        /**
+         *  \param  filter  Only runs the cases containing this string
+         */
+        QList<Result>       run( const QString& filter = QString() );
+
+        /**
+         *  \return The slope of log(time) against log(size), by least squares
+         */
+        static double       fitExponent( const QVector<int>& sizes, const QVector<double>& times );
+
+    private:
+        double              measure( Case& c );
+
+    private:
+        QList<int>                          m_sizes;
+        int                                 m_minTime;
+        int                                 m_minIterations;
+        std::vector<std::unique_ptr<Case>>  m_cases;
+};
+
+#endif // MICROBENCHMARK_H
@@ -0,0 +1,146 @@
+/*****************************************************************************
+ * SyntheticProject.cpp: Generates projects made of MLT generators
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "SyntheticProject.h"
+#include "Backend/MLT/MLTService.h"
+#include "Library/Library.h"
+#include "Media/Clip.h"
+#include "Media/Media.h"
+#include "Tools/VlmcDebug.h"
+#include "Workflow/MainWorkflow.h"
+
+// Only filters of the MLT core module, which is always there
+static const char* const   Filters[] = { "brightness", "gamma", "greyscale" };
+
+SyntheticProject::Parameters::Parameters()
+    : nbTracks( 4 )
+    , nbClips( 25 )
+    , clipLength( 100 )
+    , nbFilters( 20 )
+    , nbTransitions( 6 )
+{
+}
+
+QJsonObject
+SyntheticProject::Parameters::toJson() const
+{
+    return QJsonObject{
+        { "tracks", nbTracks },
+        { "clips", nbClips },
+        { "clipLength", clipLength },
+        { "filters", nbFilters },
+        { "transitions", nbTransitions },
+    };
+}
+
+SyntheticProject::SyntheticProject( const Parameters& params )
+    : m_params( params )
+{
+}
+
+QString
+SyntheticProject::generator( int track, int clip )
+{
+    switch ( ( track + clip ) % 4 )
+    {
+    case 2:
+        return QStringLiteral( "noise:" );
+    case 3:
+        return QStringLiteral( "tone:" );
+    default:
+    {
+        // Neighbour clips get different colors
+        const quint32 rgb = ( track * 0x3f1d27u + clip * 0x9e3779u ) & 0xffffff;
+        return QStringLiteral( "color:#%1" ).arg( rgb, 6, 16, QChar( '0' ) );
+    }
+    }
+}
+
+bool
+SyntheticProject::generate( MainWorkflow* workflow, Library* library )
+{
+    m_clips.clear();
+    m_videoClips.clear();
+    auto connection = QObject::connect( workflow, &MainWorkflow::clipAdded, [this]( const QString& uuid ) {
+        m_clips << uuid;
+    } );
+
+    for ( int t = 0; t < m_params.nbTracks; ++t )
+    {
+        for ( int i = 0; i < m_params.nbClips; ++i )
+        {
+            QSharedPointer<Media> media;
+            try
+            {
+                media = QSharedPointer<Media>::create( generator( t, i ), m_params.clipLength );
+            }
+            catch ( Backend::InvalidServiceException& )
+            {
+                vlmcCritical() << "Can't create generated media" << generator( t, i );
+                QObject::disconnect( connection );
+                return false;
+            }
+            library->addMedia( media );
+            workflow->addClip( media->baseClip()->uuid().toString(), t,
+                              static_cast<qint32>( i * m_params.clipLength ) );
+        }
+    }
+    QObject::disconnect( connection );
+
+    for ( const auto& uuid : m_clips )
+    {
+        if ( workflow->clipInfo( uuid )["audio"].toBool() == false )
+            m_videoClips << uuid;
+    }
+
+    const int nbFilterIds = sizeof( Filters ) / sizeof( Filters[0] );
+    for ( int i = 0; i < m_params.nbFilters && m_videoClips.isEmpty() == false; ++i )
+    {
+        const auto& clip = m_videoClips[i % m_videoClips.size()];
+        if ( workflow->addEffect( clip, Filters[i % nbFilterIds] ).isEmpty() == true )
+            vlmcWarning() << "Can't add filter" << Filters[i % nbFilterIds];
+    }
+
+    // Transitions blend a track with the next one, from the beginning to the middle of a clip
+    const int nbTrackPairs = m_params.nbTracks - 1;
+    if ( m_params.nbTransitions > 0 && nbTrackPairs <= 0 )
+        vlmcWarning() << "Transitions need at least 2 tracks";
+    for ( int i = 0; i < m_params.nbTransitions && nbTrackPairs > 0; ++i )
+    {
+        const quint32 track = i % nbTrackPairs;
+        const qint64 begin = ( i / nbTrackPairs ) % m_params.nbClips * m_params.clipLength;
+        workflow->addTransitionBetweenTracks( QStringLiteral( "dissolve" ), begin,
+                                              begin + m_params.clipLength / 2, track, track + 1,
+                                              i % 2 == 0 ? QStringLiteral( "Video" ) : QStringLiteral( "Audio" ) );
+    }
+    return m_clips.isEmpty() == false;
+}
+
+const QStringList&
+SyntheticProject::clips() const
+{
+    return m_clips;
+}
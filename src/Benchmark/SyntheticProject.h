@@ -0,0 +1,84 @@
+/*****************************************************************************
+ * SyntheticProject.h: Generates projects made of MLT generators
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef SYNTHETICPROJECT_H
+#define SYNTHETICPROJECT_H
+
+#include <QJsonObject>
+#include <QStringList>
+
+class Library;
+class MainWorkflow;
+
+/**
+ *  \brief  Fills the timeline with clips which need no media file.
+ *
+ *  Each clip is a media of its own, generated by an MLT producer: colors on most of
+ *  the video tracks, noise with its audio, and tones alone on the audio tracks. The
+ *  clips are laid out back to back, then the filters are spread over the video clips
+ *  and the transitions over the adjacent tracks. Every edit goes through MainWorkflow,
+ *  the way the timeline would create them.
+ *  The same parameters always produce the same project.
+ */
+class SyntheticProject
+{
+    public:
+        struct Parameters
+        {
+            Parameters();
+
+            int         nbTracks;
+            /// Per track
+            int         nbClips;
+            /// In frames
+            qint64      clipLength;
+            int         nbFilters;
+            int         nbTransitions;
+
+            QJsonObject toJson() const;
+        };
+
+        explicit SyntheticProject( const Parameters& params );
+
+        /**
+         *  \brief  Populates the timeline of the current project.
+         *  \return false if a generated media couldn't be created.
+         */
+        bool                generate( MainWorkflow* workflow, Library* library );
+
+        /**
+         *  \return The uuids of the clips added to the timeline, audio and video ones.
+         */
+        const QStringList&  clips() const;
+
+        /**
+         *  \return The MLT generator of the \p clip -th clip of the \p track -th track
+         */
+        static QString      generator( int track, int clip );
+
+    private:
+        Parameters          m_params;
+        QStringList         m_clips;
+        QStringList         m_videoClips;
+};
+
+#endif // SYNTHETICPROJECT_H
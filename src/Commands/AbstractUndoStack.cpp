@@ -31,11 +31,13 @@ using namespace Commands;
 
 AbstractUndoStack::AbstractUndoStack( QObject* parent )
     : QObject( parent )
-    , m_index( -1 )
+    , m_isClean( true )
+    , m_index( 0 )
 {
 
 }
 
+// As with QUndoStack, the index is the number of commands applied
 void
 AbstractUndoStack::redo()
 {
@@ -44,28 +46,31 @@ AbstractUndoStack::redo()
     m_stack[m_index]->redo();
     m_index++;
     _setClean( false );
+    emit indexChanged( m_index );
 }
 
 void
 AbstractUndoStack::undo()
 {
-    if ( m_index < 0 )
+    if ( m_index <= 0 )
         return;
-    m_stack[m_index]->undo();
     m_index--;
+    m_stack[m_index]->undo();
     _setClean( false );
+    emit indexChanged( m_index );
 }
 
 void
 AbstractUndoStack::push( Generic* command )
 {
-    if ( m_index == -1 )
-        m_index = 0;
+    // The undone commands can't be redone anymore
     while ( m_index < m_stack.size() )
-        m_stack.pop();
+        delete m_stack.pop();
     m_stack.push( command );
     command->redo();
+    m_index = m_stack.size();
     _setClean( false );
+    emit indexChanged( m_index );
 }
 
 void
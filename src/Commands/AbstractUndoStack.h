@@ -48,6 +48,7 @@ namespace Commands
 
         signals:
             void cleanChanged( bool val );
+            void indexChanged( int idx );
 
         public slots:
             void redo();
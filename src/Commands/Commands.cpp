@@ -121,13 +121,22 @@ Commands::Clip::Add::internalRedo()
         // so that future operations could still rely on the same instance being present
         m_audioInstanceUuid = m_workflow->addClip( clip, m_trackId, m_pos, m_audioInstanceUuid, true );
         if ( m_audioInstanceUuid.isNull() == true )
+        {
             invalidate();
+            return;
+        }
     }
     if ( clip->media()->hasVideoTracks() )
     {
         m_videoInstanceUuid = m_workflow->addClip( clip, m_trackId, m_pos, m_videoInstanceUuid, false );
         if ( m_videoInstanceUuid.isNull() == true )
+        {
+            // Don't leave the audio part alone in the timeline
+            if ( m_audioInstanceUuid.isNull() == false )
+                m_workflow->removeClip( m_audioInstanceUuid );
             invalidate();
+            return;
+        }
     }
     if ( m_audioInstanceUuid.isNull() == false && m_videoInstanceUuid.isNull() == false )
         m_workflow->linkClips( m_audioInstanceUuid, m_videoInstanceUuid );
@@ -174,7 +183,7 @@ bool
 Commands::Clip::Move::mergeWith( const Generic* command )
 {
     auto cmd = static_cast<const Move*>( command );
-    if ( cmd->m_infos.count() > 1 )
+    if ( cmd->isValid() == false || cmd->m_infos.count() > 1 )
         return false;
     const auto& clip = m_workflow->clip( m_infos[0].uuid );
     const auto& linkedClips = clip->linkedClips;
@@ -209,6 +218,11 @@ Commands::Clip::Remove::Remove( std::shared_ptr<SequenceWorkflow> const& workflo
     : m_workflow( workflow )
 {
     auto clip = workflow->clip( uuid );
+    if ( clip == nullptr )
+    {
+        invalidate();
+        return;
+    }
     m_clips.append( clip );
     retranslate();
 }
@@ -229,7 +243,7 @@ bool
 Commands::Clip::Remove::mergeWith( const Generic* command )
 {
     auto cmd = static_cast<const Remove*>( command );
-    if ( cmd->m_clips.count() > 1 )
+    if ( cmd->isValid() == false || cmd->m_clips.count() > 1 )
         return false;
     const auto& linkedClips = m_clips[0]->linkedClips;
     if ( linkedClips.contains( cmd->m_clips[0]->uuid ) == false )
@@ -241,8 +255,19 @@ Commands::Clip::Remove::mergeWith( const Generic* command )
 void
 Commands::Clip::Remove::internalRedo()
 {
-    for ( const auto& clip : m_clips )
-        m_workflow->removeClip( clip->uuid );
+    for ( int i = 0; i < m_clips.count(); ++i )
+    {
+        if ( m_workflow->removeClip( m_clips[i]->uuid ) != nullptr )
+            continue;
+        // Put back the clips removed so far, so that a failure leaves the timeline untouched
+        for ( int j = 0; j < i; ++j )
+        {
+            const auto& clip = m_clips[j];
+            m_workflow->addClip( clip->clip, clip->trackId, clip->pos, clip->uuid, clip->isAudio );
+        }
+        invalidate();
+        return;
+    }
 }
 
 void
@@ -288,7 +313,7 @@ bool
 Commands::Clip::Resize::mergeWith( const Generic* command )
 {
     auto cmd = static_cast<const Resize*>( command );
-    if ( cmd->m_infos.count() > 1 )
+    if ( cmd->isValid() == false || cmd->m_infos.count() > 1 )
         return false;
     const auto& linkedClips = m_infos[0].clip->linkedClips;
     if ( linkedClips.contains( cmd->m_infos[0].clip->uuid ) == false )
@@ -370,7 +395,10 @@ Commands::Clip::Split::internalRedo()
     m_newClipInstanceUuid = m_workflow->addClip( m_newClip, m_trackId, m_newClipPos, m_newClipInstanceUuid,
                                                  m_toSplit->isAudio );
     if ( m_newClipInstanceUuid.isNull() == true )
+    {
+        m_workflow->resizeClip( m_toSplit->uuid, m_toSplit->clip->begin(), m_oldEnd, m_toSplit->pos );
         invalidate();
+    }
 }
 
 void
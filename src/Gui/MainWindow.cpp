@@ -41,8 +41,10 @@
 #include "Project/Project.h"
 #include "Library/Library.h"
 #include "Tools/VlmcDebug.h"
+#include "Tools/Tracer.h"
 #include "Tools/VlmcLogger.h"
 #include "Backend/IBackend.h"
+#include "Workflow/Journal.h"
 #include "Workflow/MainWorkflow.h"
 #include "Renderer/ClipRenderer.h"
 #include "Commands/AbstractUndoStack.h"
@@ -101,6 +103,8 @@ MainWindow::MainWindow( Backend::IBackend* backend, QWidget *parent )
              this, &MainWindow::onOudatedBackupFile );
     connect( Core::instance()->project(), &Project::backupProjectLoaded,
              this, &MainWindow::onBackupFileLoaded );
+    connect( Core::instance()->project(), &Project::projectLoaded,
+             this, &MainWindow::onProjectLoaded );
     connect( Core::instance()->project(), &Project::projectSaved,
              this, &MainWindow::onProjectSaved );
     connect( Core::instance()->project(), &Project::cleanStateChanged,
@@ -226,6 +230,18 @@ MainWindow::initVlmcPreferences()
                                      QT_TRANSLATE_NOOP( "PreferenceWidget", "Render preview" ),
                                      QT_TRANSLATE_NOOP( "PreferenceWidget", "Preview the project, or pause the current preview" ) );
 
+    VLMC_CREATE_PREFERENCE_KEYBOARD( "keyboard/shuttlebackward", "J",
+                                     QT_TRANSLATE_NOOP( "PreferenceWidget", "Shuttle backward" ),
+                                     QT_TRANSLATE_NOOP( "PreferenceWidget", "Play the project backward, faster each time it's pressed" ) );
+
+    VLMC_CREATE_PREFERENCE_KEYBOARD( "keyboard/shuttlestop", "K",
+                                     QT_TRANSLATE_NOOP( "PreferenceWidget", "Shuttle stop" ),
+                                     QT_TRANSLATE_NOOP( "PreferenceWidget", "Pause the project preview" ) );
+
+    VLMC_CREATE_PREFERENCE_KEYBOARD( "keyboard/shuttleforward", "L",
+                                     QT_TRANSLATE_NOOP( "PreferenceWidget", "Shuttle forward" ),
+                                     QT_TRANSLATE_NOOP( "PreferenceWidget", "Play the project forward, faster each time it's pressed" ) );
+
     //A bit nasty, but we better use what Qt's providing as default shortcut
     CREATE_MENU_SHORTCUT( "keyboard/undo",
                           QKeySequence( QKeySequence::Undo ).toString().toLocal8Bit(),
@@ -315,6 +331,38 @@ MainWindow::initVlmcPreferences()
                                     QT_TRANSLATE_NOOP( "PreferenceWidget", "Temporary folder" ),
                                     QT_TRANSLATE_NOOP( "PreferenceWidget", "The temporary folder used by VLMC to process videos." ) );
 
+    SettingValue* previewQuality = VLMC_CREATE_PREFERENCE( SettingValue::Int, "vlmc/PreviewQuality", 1,
+                                     QT_TRANSLATE_NOOP( "PreferenceWidget", "Preview quality" ),
+                                     QT_TRANSLATE_NOOP( "PreferenceWidget", "The resolution of the preview: 1 for full, "
+                                                        "2 for half, 3 for quarter, or 0 to lower it automatically "
+                                                        "when the preview can't play in real time. "
+                                                        "Exports always use the project resolution." ),
+                                     SettingValue::Clamped );
+    previewQuality->setLimits( 0, 3 );
+
+    VLMC_CREATE_PREFERENCE( SettingValue::Bool, "vlmc/NativePreview", true,
+                            QT_TRANSLATE_NOOP( "PreferenceWidget", "Paint the preview in process" ),
+                            QT_TRANSLATE_NOOP( "PreferenceWidget", "Paint the preview frames in VLMC's window, "
+                                               "rather than in a window of their own. Takes effect the next "
+                                               "time VLMC starts." ),
+                            SettingValue::Nothing );
+
+    VLMC_CREATE_PREFERENCE( SettingValue::Bool, "vlmc/PerfOverlay", false,
+                            QT_TRANSLATE_NOOP( "PreferenceWidget", "Show the performance counters" ),
+                            QT_TRANSLATE_NOOP( "PreferenceWidget", "Show the frame rate, compositing time, dropped "
+                                               "frames and memory use over the previews." ),
+                            SettingValue::Nothing );
+
+    SettingValue* traceFile = VLMC_CREATE_PREFERENCE_STRING( "vlmc/TraceFile", "",
+                                     QT_TRANSLATE_NOOP( "PreferenceWidget", "Pipeline trace file" ),
+                                     QT_TRANSLATE_NOOP( "PreferenceWidget", "Trace the pipeline while previewing or "
+                                                        "rendering, and write the events to this file, to be opened "
+                                                        "in chrome://tracing or Perfetto. Leave empty to disable." ) );
+    connect( traceFile, &SettingValue::changed, this, []( const QVariant& var )
+    {
+        Tracer::setOutput( var.toString() );
+    } );
+
     //Setup VLMC Youtube Preference...
     VLMC_CREATE_PREFERENCE_STRING( "youtube/DeveloperKey", "",
                                      QT_TRANSLATE_NOOP( "PreferenceWidget", "Youtube Developer Key" ),
@@ -410,13 +458,17 @@ MainWindow::on_actionSave_As_triggered()
     if ( path.isEmpty() == true )
         path = VLMC_GET_STRING( "vlmc/WorkspaceLocation" );
 
+    const QString binaryFilter = QObject::tr( "VLMC binary project file(*.vlmcb)" );
+    QString selectedFilter;
     QString dest = QFileDialog::getSaveFileName( nullptr, QObject::tr( "Enter the output file name" ),
-                                  path, QObject::tr( "VLMC project file(*.vlmc)" ) );
+                                  path, QObject::tr( "VLMC project file(*.vlmc)" ) + ";;" + binaryFilter,
+                                  &selectedFilter );
     if ( dest.isEmpty() == true )
         return;
-    if ( !dest.endsWith( ".vlmc" ) )
-        dest += ".vlmc";
+    if ( !dest.endsWith( ".vlmc" ) && !dest.endsWith( Project::binaryExtension ) )
+        dest += selectedFilter == binaryFilter ? Project::binaryExtension : ".vlmc";
     Core::instance()->project()->saveAs( dest );
+    openJournal( dest );
 }
 
 void
@@ -424,7 +476,7 @@ MainWindow::on_actionLoad_Project_triggered()
 {
     QString folder = VLMC_GET_STRING( "vlmc/WorkspaceLocation" );
     QString fileName = QFileDialog::getOpenFileName( nullptr, tr( "Please choose a project file" ),
-                                    folder, tr( "VLMC project file(*.vlmc)" ) );
+                                    folder, tr( "VLMC project file(*.vlmc *.vlmcb)" ) );
     if ( fileName.isEmpty() == true )
         return ;
     Core::instance()->project()->load( fileName );
@@ -559,6 +611,13 @@ MainWindow::setupProjectPreview()
     m_projectPreview->setRenderer( Core::instance()->workflow()->renderer() );
     KeyboardShortcutHelper* renderShortcut = new KeyboardShortcutHelper( "keyboard/renderpreview", this );
     connect( renderShortcut, SIGNAL( activated() ), m_projectPreview, SLOT( on_pushButtonPlay_clicked() ) );
+    auto renderer = Core::instance()->workflow()->renderer();
+    auto shuttleBackward = new KeyboardShortcutHelper( "keyboard/shuttlebackward", this );
+    connect( shuttleBackward, &KeyboardShortcutHelper::activated, renderer, &AbstractRenderer::shuttleBackward );
+    auto shuttleStop = new KeyboardShortcutHelper( "keyboard/shuttlestop", this );
+    connect( shuttleStop, &KeyboardShortcutHelper::activated, renderer, &AbstractRenderer::shuttleStop );
+    auto shuttleForward = new KeyboardShortcutHelper( "keyboard/shuttleforward", this );
+    connect( shuttleForward, &KeyboardShortcutHelper::activated, renderer, &AbstractRenderer::shuttleForward );
     m_dockedProjectPreview = dockWidget( m_projectPreview, Qt::TopDockWidgetArea );
 }
 
@@ -850,6 +909,8 @@ MainWindow::closeEvent( QCloseEvent* e )
             on_actionSave_triggered();
             break;
         case QMessageBox::Discard:
+            // Otherwise the edits would be recovered when the project is loaded again
+            Core::instance()->workflow()->journal()->discard();
             break;
         case QMessageBox::Cancel:
             e->ignore();
@@ -895,9 +956,27 @@ MainWindow::cleanStateChanged( bool isClean )
 }
 
 void
-MainWindow::onProjectSaved()
+MainWindow::onProjectLoaded( const QString&, const QString& projectFilePath )
+{
+    openJournal( projectFilePath );
+}
+
+void
+MainWindow::onProjectSaved( const QString&, const QString& projectFilePath )
 {
     setWindowModified( false );
+    // A new project is only saved once created, its journal starts then
+    if ( projectFilePath.endsWith( Project::backupSuffix ) == false &&
+         Core::instance()->workflow()->journal()->isOpen() == false )
+        openJournal( projectFilePath );
+}
+
+void
+MainWindow::openJournal( const QString& projectFilePath )
+{
+    // Replayed edits are only in the journal until the project is saved again
+    if ( Core::instance()->workflow()->journal()->open( projectFilePath + Project::journalSuffix ) > 0 )
+        Core::instance()->project()->cleanChanged( false );
 }
 
 void
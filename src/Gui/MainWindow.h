@@ -92,6 +92,13 @@ private:
     void        setupTransitionsList();
     void        setupUndoRedoWidget();
     void        retranslateUi();
+    /**
+     *  \brief  Recover the edits made after the last save, and journal the next ones.
+     *
+     *  Only the editor does so: the headless renderers load the same project files,
+     *  and must neither replay nor remove the journal of an editor.
+     */
+    void        openJournal( const QString& projectFilePath );
 #ifdef WITH_CRASHBUTTON
     void        setupCrashTester();
 #endif
@@ -169,7 +176,8 @@ private slots:
     void                    canRedoChanged( bool canRedo );
     void                    onOudatedBackupFile();
     void                    onBackupFileLoaded();
-    void                    onProjectSaved();
+    void                    onProjectLoaded( const QString& projectName, const QString& projectFilePath );
+    void                    onProjectSaved( const QString& projectName, const QString& projectFilePath );
 
 signals:
     void                    selectionToolSelected();
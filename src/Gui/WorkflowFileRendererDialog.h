@@ -24,6 +24,7 @@
 #define WORKFLOWFILERENDERERDIALOG_H
 
 #include <QDialog>
+#include <QImage>
 #include "ui/WorkflowFileRendererDialog.h"
 
 class   RendererEventWatcher;
@@ -46,7 +47,7 @@ signals:
     void    stop();
 
 public slots:
-    void    updatePreview( const uchar* buff );
+    void    updatePreview( const QImage& image );
     void    frameChanged( qint64 newFrame, qint64 length );
 
 private slots:
@@ -0,0 +1,99 @@
+/*****************************************************************************
+ * FrameView.cpp: Paints the frames of an in-process preview output
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "FrameView.h"
+#include "Backend/MLT/MLTOutput.h"
+#include "Tools/PerfCounters.h"
+
+#include <QImage>
+#include <QPainter>
+
+#include <chrono>
+
+FrameView::FrameView( QWidget* parent )
+    : QWidget( parent )
+    , m_output( nullptr )
+    , m_updatePending( false )
+{
+    // Every pixel is painted, don't let Qt clear the background first
+    setAttribute( Qt::WA_OpaquePaintEvent );
+}
+
+FrameView::~FrameView()
+{
+    setOutput( nullptr );
+}
+
+void
+FrameView::setOutput( Backend::MLT::MLTFrameSinkOutput* output )
+{
+    if ( m_output != nullptr )
+        m_output->setFrameSink( nullptr );
+    m_output = output;
+    if ( m_output != nullptr )
+        m_output->setFrameSink( this );
+    update();
+}
+
+void
+FrameView::onFrameReady()
+{
+    // Only one update in flight, the paint event picks the latest frame anyway
+    if ( m_updatePending.exchange( true ) == false )
+        QMetaObject::invokeMethod( this, "update", Qt::QueuedConnection );
+}
+
+void
+FrameView::paintEvent( QPaintEvent* )
+{
+    m_updatePending = false;
+    QPainter painter( this );
+    painter.fillRect( rect(), Qt::black );
+    if ( m_output == nullptr )
+        return;
+
+    auto& frames = m_output->frames();
+    const bool fresh = frames.update();
+    const auto& frame = frames.readBuffer();
+    if ( frame.pixels.empty() == true )
+        return;
+
+    // Wrap the buffer, it stays valid until the next update()
+    QImage image( frame.pixels.data(), frame.width, frame.height, frame.width * 4,
+                  QImage::Format_RGBA8888 );
+    QSize size = image.size().scaled( this->size(), Qt::KeepAspectRatio );
+    QRect target( ( width() - size.width() ) / 2, ( height() - size.height() ) / 2,
+                  size.width(), size.height() );
+    painter.drawImage( target, image );
+
+    if ( fresh == true )
+    {
+        const auto now = std::chrono::duration_cast<std::chrono::microseconds>(
+                    std::chrono::steady_clock::now().time_since_epoch() ).count();
+        PerfCounters::add( PerfCounters::FramesPresented );
+        PerfCounters::add( PerfCounters::PresentLatency, now - frame.time );
+    }
+}
@@ -0,0 +1,71 @@
+/*****************************************************************************
+ * FrameView.h: Paints the frames of an in-process preview output
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef FRAMEVIEW_H
+#define FRAMEVIEW_H
+
+#include "Backend/IOutput.h"
+
+#include <QWidget>
+
+#include <atomic>
+
+namespace Backend
+{
+namespace MLT
+{
+class MLTFrameSinkOutput;
+}
+}
+
+/**
+ *  \brief  Paints the frames published by a MLTFrameSinkOutput.
+ *
+ *  The output only notifies the view, which picks the latest frame up when it paints,
+ *  so frames the GUI thread couldn't paint in time are skipped without queueing up.
+ */
+class FrameView : public QWidget, public Backend::IFrameSink
+{
+    Q_OBJECT
+
+public:
+    explicit FrameView( QWidget* parent = nullptr );
+    ~FrameView();
+
+    /**
+     *  \param  output  The output to paint the frames of, or nullptr. It must outlive
+     *                  the view, or be replaced before being destroyed.
+     */
+    void                setOutput( Backend::MLT::MLTFrameSinkOutput* output );
+
+protected:
+    virtual void        paintEvent( QPaintEvent* event ) override;
+
+private:
+    virtual void        onFrameReady() override;
+
+private:
+    Backend::MLT::MLTFrameSinkOutput*   m_output;
+    std::atomic_bool                    m_updatePending;
+};
+
+#endif // FRAMEVIEW_H
@@ -196,6 +196,7 @@ void
 PreviewRuler::mousePressEvent( QMouseEvent* event )
 {
     m_isSliding = true;
+    emit scrubStarted();
     if ( m_renderer->length() > 0 )
     {
         setFrame( (qreal)(event->pos().x() * m_renderer->length() ) / width(), true );
@@ -219,7 +220,10 @@ PreviewRuler::mouseMoveEvent( QMouseEvent* event )
 void
 PreviewRuler::mouseReleaseEvent( QMouseEvent* )
 {
+    if ( m_isSliding == false )
+        return;
     m_isSliding = false;
+    emit scrubFinished( m_frame );
 }
 
 void
@@ -236,6 +240,9 @@ PreviewRuler::setFrame( qint64 frame, bool broadcastEvent /*= false*/ )
 void
 PreviewRuler::updateTimecode( qint64 frames /*= -1*/ )
 {
+    // While scrubbing, the renderer may show a nearby frame; keep following the mouse
+    if ( m_isSliding == true )
+        frames = m_frame;
     setFrame( frames );
     if ( m_renderer->length() > 0 )
     {
@@ -73,6 +73,8 @@ private:
 
 signals:
     void                frameChanged( qint64, Vlmc::FrameChangedReason );
+    void                scrubStarted();
+    void                scrubFinished( qint64 frame );
     void                timeChanged( int h, int m, int s, int f );
 };
 
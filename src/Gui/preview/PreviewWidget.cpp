@@ -32,19 +32,34 @@
 #include "Renderer/ClipRenderer.h"
 #include "Backend/MLT/MLTOutput.h"
 #include "PreviewWidget.h"
+#include "FrameView.h"
 #include "PreviewRuler.h"
 #include "RenderWidget.h"
+#include "Tools/PerfCounters.h"
 #include "Tools/RendererEventWatcher.h"
+#include "Tools/VlmcDebug.h"
+#include "Main/Core.h"
+#include "Settings/Settings.h"
+#include "Settings/SettingValue.h"
 #include "ui/PreviewWidget.h"
 
+#include <QGuiApplication>
+#include <QLabel>
 #include <QMessageBox>
 #include <QLayout>
+#include <QScreen>
+#include <QVBoxLayout>
 
 PreviewWidget::PreviewWidget( QWidget *parent )
     : QWidget( parent )
     , m_ui( new Ui::PreviewWidget )
     , m_renderer( nullptr )
     , m_previewStopped( true )
+    , m_output( nullptr )
+    , m_frameView( nullptr )
+    , m_quality( Full )
+    , m_lastFramesShown( 0 )
+    , m_statsOverlay( nullptr )
 {
     m_ui->setupUi( this );
 
@@ -62,38 +77,92 @@ PreviewWidget::PreviewWidget( QWidget *parent )
     connect( m_ui->pushButtonMarkerStart, SIGNAL( clicked() ), this, SLOT( markerStartClicked() ) );
     connect( m_ui->pushButtonMarkerStop, SIGNAL( clicked() ), this, SLOT( markerStopClicked() ) );
     connect( m_ui->pushButtonCreateClip, SIGNAL( clicked() ), this, SLOT( createNewClipFromMarkers() ) );
+
+    m_qualityTimer.setInterval( 2000 );
+    connect( &m_qualityTimer, &QTimer::timeout, this, &PreviewWidget::checkPlaybackSpeed );
+    auto quality = Core::instance()->settings()->value( QStringLiteral( "vlmc/PreviewQuality" ) );
+    if ( quality != nullptr )
+    {
+        m_quality = quality->get().toInt();
+        connect( quality, &SettingValue::changed, this, [this]( const QVariant& value ) {
+            setQuality( value.toInt() );
+        });
+    }
+
+    m_statsTimer.setInterval( 1000 );
+    connect( &m_statsTimer, &QTimer::timeout, this, &PreviewWidget::updateStatsOverlay );
+    auto overlay = Core::instance()->settings()->value( QStringLiteral( "vlmc/PerfOverlay" ) );
+    if ( overlay != nullptr )
+    {
+        showStatsOverlay( overlay->get().toBool() );
+        connect( overlay, &SettingValue::changed, this, [this]( const QVariant& value ) {
+            showStatsOverlay( value.toBool() );
+        });
+    }
 }
 
 PreviewWidget::~PreviewWidget()
 {
+    if ( m_statsOverlay != nullptr )
+        PerfCounters::setTimingEnabled( false );
     delete m_ui;
 }
 
 void
 PreviewWidget::setRenderer( AbstractRenderer* renderer )
 {
+    // The output is about to go along with the renderer
+    if ( m_frameView != nullptr )
+        m_frameView->setOutput( nullptr );
     delete m_renderer;
     m_renderer = renderer;
 
     // Give the renderer to the ruler
     m_ui->rulerWidget->setRenderer( m_renderer );
-    auto output = new Backend::MLT::MLTSdlOutput;
-    output->setWindowId( (intptr_t)m_ui->renderWidget->id() );
-    m_renderer->setOutput( std::unique_ptr<Backend::IOutput>( output ) );
+    auto native = Core::instance()->settings()->value( QStringLiteral( "vlmc/NativePreview" ) );
+    if ( native == nullptr || native->get().toBool() == true )
+    {
+        if ( m_frameView == nullptr )
+        {
+            m_frameView = new FrameView( m_ui->renderWidget );
+            auto layout = new QVBoxLayout( m_ui->renderWidget );
+            layout->setContentsMargins( 0, 0, 0, 0 );
+            layout->addWidget( m_frameView );
+        }
+        auto output = new Backend::MLT::MLTFrameSinkOutput;
+        m_frameView->setOutput( output );
+        m_output = output;
+    }
+    else
+    {
+        auto output = new Backend::MLT::MLTSdlOutput;
+        output->setWindowId( (intptr_t)m_ui->renderWidget->id() );
+        m_output = output;
+    }
+    setQuality( m_quality );
+    m_renderer->setOutput( std::unique_ptr<Backend::IOutput>( m_output ) );
 
 #if defined ( Q_OS_MAC )
     /* Releases the NSView in the RenderWidget*/
     m_ui->renderWidget->release();
 #endif
 
+    // There's no point in moving the cursors more often than the screen refreshes
+    auto screen = QGuiApplication::primaryScreen();
+    if ( screen != nullptr )
+        renderer->eventWatcher()->setDispatchRate( screen->refreshRate() );
     connect( renderer->eventWatcher().data(), SIGNAL( stopped() ), this, SLOT( videoStopped() ) );
     connect( renderer->eventWatcher().data(), SIGNAL( paused() ), this, SLOT( videoPaused() ) );
     connect( renderer->eventWatcher().data(), SIGNAL( playing() ), this, SLOT( videoPlaying() ) );
     connect( renderer->eventWatcher().data(), SIGNAL( errorEncountered() ), this, SLOT( error() ) );
     connect( renderer->eventWatcher().data(), SIGNAL( volumeChanged() ), this, SLOT( volumeChanged() ) );
+    connect( renderer->eventWatcher().data(), &RendererEventWatcher::playbackStatsChanged,
+             this, &PreviewWidget::playbackStatsChanged );
 
     connect( m_ui->rulerWidget, SIGNAL( frameChanged(qint64, Vlmc::FrameChangedReason) ),
              m_renderer,       SLOT( previewWidgetCursorChanged(qint64) ) );
+    connect( m_ui->rulerWidget, &PreviewRuler::scrubStarted, m_renderer, &AbstractRenderer::beginScrub );
+    connect( m_ui->rulerWidget, &PreviewRuler::scrubFinished, m_renderer, &AbstractRenderer::endScrub );
 
     connect( m_ui->volumeSlider, SIGNAL( valueChanged ( int ) ),
              this, SLOT( updateVolume( int ) ) );
@@ -144,18 +213,134 @@ void
 PreviewWidget::videoPaused()
 {
     m_ui->pushButtonPlay->setIcon( QIcon( ":/images/play" ) );
+    // Show the still frame at full resolution
+    m_qualityTimer.stop();
+    if ( m_quality == Automatic )
+        setScale( 1 );
 }
 
 void
 PreviewWidget::videoStopped()
 {
     m_ui->pushButtonPlay->setIcon( QIcon( ":/images/play" ) );
+    m_qualityTimer.stop();
+    if ( m_quality == Automatic )
+        setScale( 1 );
+    vlmcDebug() << "Preview position events:" << m_renderer->eventWatcher()->positionEvents()
+                << "coalesced:" << m_renderer->eventWatcher()->coalescedPositionEvents();
 }
 
 void
 PreviewWidget::videoPlaying()
 {
     m_ui->pushButtonPlay->setIcon( QIcon( ":/images/pause" ) );
+    if ( m_quality == Automatic && m_qualityTimer.isActive() == false )
+    {
+        m_lastFramesShown = m_output->framesShown();
+        m_qualityClock.start();
+        m_qualityTimer.start();
+    }
+}
+
+void
+PreviewWidget::playbackStatsChanged( qint64 droppedFrames, qint64 lateFrames )
+{
+    m_ui->droppedFramesLabel->setVisible( droppedFrames > 0 || lateFrames > 0 );
+    m_ui->droppedFramesLabel->setText( tr( "%n frame(s) dropped", "", static_cast<int>( droppedFrames ) ) );
+    m_ui->droppedFramesLabel->setToolTip( tr( "%n frame(s) displayed late", "", static_cast<int>( lateFrames ) ) );
+}
+
+void
+PreviewWidget::setQuality( int quality )
+{
+    m_quality = qBound<int>( Automatic, quality, Quarter );
+    if ( m_output == nullptr )
+        return;
+    switch ( m_quality )
+    {
+    case Half:
+        setScale( 2 );
+        break;
+    case Quarter:
+        setScale( 4 );
+        break;
+    default:
+        // Automatic mode starts at full resolution, and degrades while playing
+        setScale( 1 );
+        break;
+    }
+    if ( m_quality != Automatic )
+        m_qualityTimer.stop();
+    else if ( m_renderer != nullptr && m_renderer->isRendering() == true &&
+              m_renderer->isPaused() == false )
+        videoPlaying();
+}
+
+void
+PreviewWidget::setScale( int divisor )
+{
+    if ( m_output == nullptr || m_output->scale() == divisor )
+        return;
+    m_output->setScale( divisor );
+    // Don't judge the new resolution on the frames shown while the output restarted
+    m_lastFramesShown = m_output->framesShown();
+    m_qualityClock.restart();
+}
+
+void
+PreviewWidget::checkPlaybackSpeed()
+{
+    const auto elapsed = m_qualityClock.restart();
+    const auto framesShown = m_output->framesShown();
+    const auto nbFrames = framesShown - m_lastFramesShown;
+    m_lastFramesShown = framesShown;
+    const auto expected = m_renderer->getFps() * elapsed / 1000.0;
+    // The consumer drops frames, or the position lags, once it can't keep up with real time
+    if ( expected > 0 && nbFrames < expected * 0.9 && m_output->scale() < 4 )
+    {
+        vlmcDebug() << "Preview is behind real time (" << nbFrames << "frames shown out of"
+                    << expected << "), lowering its resolution";
+        setScale( m_output->scale() * 2 );
+    }
+}
+
+void
+PreviewWidget::showStatsOverlay( bool show )
+{
+    if ( show == false )
+    {
+        if ( m_statsOverlay == nullptr )
+            return;
+        m_statsTimer.stop();
+        delete m_statsOverlay;
+        m_statsOverlay = nullptr;
+        PerfCounters::setTimingEnabled( false );
+        return;
+    }
+    if ( m_statsOverlay != nullptr )
+        return;
+    PerfCounters::setTimingEnabled( true );
+    // Over the frames when they're painted in process. A native SDL window may hide it.
+    m_statsOverlay = new QLabel( m_ui->renderWidget );
+    m_statsOverlay->setAttribute( Qt::WA_TransparentForMouseEvents );
+    m_statsOverlay->setStyleSheet( QStringLiteral( "QLabel { background-color: rgba( 0, 0, 0, 160 ); "
+                                                   "color: white; padding: 4px; }" ) );
+    m_statsOverlay->move( 8, 8 );
+    m_lastStats = PerfCounters::snapshot();
+    updateStatsOverlay();
+    m_statsOverlay->show();
+    m_statsTimer.start();
+}
+
+void
+PreviewWidget::updateStatsOverlay()
+{
+    auto stats = PerfCounters::snapshot();
+    m_statsOverlay->setText( PerfCounters::report( m_lastStats, stats ) );
+    m_statsOverlay->adjustSize();
+    // The frame view may have been created since
+    m_statsOverlay->raise();
+    m_lastStats = stats;
 }
 
 void
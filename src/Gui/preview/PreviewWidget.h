@@ -24,12 +24,25 @@
 #ifndef PREVIEWWIDGET_H
 #define PREVIEWWIDGET_H
 
+#include <QElapsedTimer>
+#include <QTimer>
 #include <QWidget>
 #include "Workflow/MainWorkflow.h"
+#include "Tools/PerfCounters.h"
 
 class AbstractRenderer;
+class FrameView;
+class QLabel;
 class RendererEventWatcher;
 
+namespace Backend
+{
+namespace MLT
+{
+class MLTSdlOutput;
+}
+}
+
 namespace Ui {
     class PreviewWidget;
 }
@@ -49,10 +62,39 @@ public:
      */
     void                    setClipEdition( bool enable );
 
+    /**
+     * @brief The resolution of the preview, as stored in the "vlmc/PreviewQuality" setting
+     */
+    enum PreviewQuality
+    {
+        Automatic,
+        Full,
+        Half,
+        Quarter,
+    };
+
+private:
+    void                    setQuality( int quality );
+    void                    setScale( int divisor );
+    /// Shows the PerfCounters over the preview, as set in the "vlmc/PerfOverlay" setting
+    void                    showStatsOverlay( bool show );
+    void                    updateStatsOverlay();
+
 private:
     Ui::PreviewWidget*      m_ui;
     AbstractRenderer*        m_renderer;
     bool                    m_previewStopped;
+    // Owned by the renderer
+    Backend::MLT::MLTSdlOutput* m_output;
+    // Paints the frames when the output delivers them in process
+    FrameView*              m_frameView;
+    int                     m_quality;
+    QTimer                  m_qualityTimer;
+    QElapsedTimer           m_qualityClock;
+    qint64                  m_lastFramesShown;
+    QLabel*                 m_statsOverlay;
+    QTimer                  m_statsTimer;
+    PerfCounters::Snapshot  m_lastStats;
 
 protected:
     virtual void    changeEvent( QEvent *e );
@@ -75,6 +117,8 @@ private slots:
     void            markerStopClicked();
     void            createNewClipFromMarkers();
     void            error();
+    void            checkPlaybackSpeed();
+    void            playbackStatsChanged( qint64 droppedFrames, qint64 lateFrames );
 };
 
 #endif // PREVIEWWIDGET_H
@@ -99,14 +99,16 @@ Rectangle {
     }
 
     MouseArea {
+        id: cursorMouseArea
         anchors.fill: parent
 
         onPressed: {
             cursorPosition = ptof( mouseX );
+            workflow.beginScrub();
         }
 
         onReleased: {
-            workflow.setPosition( cursorPosition );
+            workflow.endScrub( cursorPosition );
         }
 
         onClicked: {
@@ -116,7 +118,7 @@ Rectangle {
 
         onPositionChanged: {
             cursorPosition = ptof( mouseX );
-            workflow.setPosition( cursorPosition );
+            workflow.scrub( cursorPosition );
         }
     }
 
@@ -156,7 +158,9 @@ Rectangle {
     Connections {
         target: workflow
         onFrameChanged: {
-            cursorPosition = newFrame;
+            // While scrubbing, the preview may show a nearby frame; the cursor follows the mouse
+            if ( cursorMouseArea.pressed === false )
+                cursorPosition = newFrame;
         }
     }
 }
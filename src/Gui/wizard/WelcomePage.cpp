@@ -146,7 +146,7 @@ WelcomePage::loadProject()
     QString projectPath =
             QFileDialog::getOpenFileName( nullptr, tr( "Select a project file" ),
                                           VLMC_GET_STRING( "vlmc/WorkspaceLocation" ),
-                                          tr( "VLMC project file(*.vlmc)" ) );
+                                          tr( "VLMC project file(*.vlmc *.vlmcb)" ) );
 
     if ( projectPath.isEmpty() ) return;
 
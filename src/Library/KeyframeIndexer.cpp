@@ -0,0 +1,147 @@
+/*****************************************************************************
+ * KeyframeIndexer.cpp: Builds the keyframe index of the media in the background
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "KeyframeIndexer.h"
+#include "Backend/IInput.h"
+#include "Backend/KeyframeIndex.h"
+#include "Media/Media.h"
+#include "Tools/VlmcDebug.h"
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <QUrl>
+
+KeyframeIndexer::KeyframeIndexer( QObject* parent )
+    : QThread( parent )
+    , m_stop( false )
+{
+    connect( this, &KeyframeIndexer::indexed, this, &KeyframeIndexer::indexReady, Qt::QueuedConnection );
+    start( QThread::LowestPriority );
+}
+
+KeyframeIndexer::~KeyframeIndexer()
+{
+    {
+        QMutexLocker lock( &m_mutex );
+        m_stop = true;
+        m_queue.clear();
+    }
+    m_cond.wakeAll();
+    wait();
+}
+
+void
+KeyframeIndexer::setCacheDirectory( const QString& path )
+{
+    QMutexLocker lock( &m_mutex );
+    m_cacheDirectory = path;
+}
+
+void
+KeyframeIndexer::index( QSharedPointer<Media> media )
+{
+    // libavformat wants a path rather than a file:// url
+    const auto url = QUrl( media->mrl() );
+    const auto path = url.isLocalFile() == true ? url.toLocalFile() : media->mrl();
+    if ( m_pending.contains( path ) == true )
+        return;
+    m_pending.insert( path, media );
+    QMutexLocker lock( &m_mutex );
+    m_queue.push_back( path );
+    m_cond.wakeAll();
+}
+
+void
+KeyframeIndexer::indexReady( const QString& path )
+{
+    std::shared_ptr<const Backend::KeyframeIndex> index;
+    {
+        QMutexLocker lock( &m_mutex );
+        index = m_results.take( path );
+    }
+    auto media = m_pending.take( path ).toStrongRef();
+    if ( media == nullptr || index == nullptr )
+        return;
+    auto input = media->input();
+    input->setKeyframeIndex( index );
+    vlmcDebug() << "Indexed" << index->size() << "keyframes of" << path << "- a seek decodes at most"
+                << index->maxGopLength( input->fps() ) << "frames";
+}
+
+void
+KeyframeIndexer::run()
+{
+    QMutexLocker lock( &m_mutex );
+    while ( m_stop == false )
+    {
+        if ( m_queue.empty() == true )
+        {
+            m_cond.wait( &m_mutex );
+            continue;
+        }
+        const auto path = m_queue.front();
+        m_queue.pop_front();
+        const auto cacheDirectory = m_cacheDirectory;
+        lock.unlock();
+
+        QFileInfo source( path );
+        const auto size = source.size();
+        const auto mtime = source.lastModified().toMSecsSinceEpoch();
+        QString cacheFile;
+        if ( cacheDirectory.isEmpty() == false && QDir().mkpath( cacheDirectory ) == true )
+        {
+            const auto hash = QCryptographicHash::hash( path.toUtf8(), QCryptographicHash::Sha1 );
+            cacheFile = QDir( cacheDirectory ).filePath( QString::fromLatin1( hash.toHex() ) + ".idx" );
+        }
+
+        auto index = std::make_shared<Backend::KeyframeIndex>();
+        bool ok = cacheFile.isEmpty() == false &&
+                index->load( QFile::encodeName( cacheFile ).toStdString(), size, mtime );
+        if ( ok == false )
+        {
+            QElapsedTimer timer;
+            timer.start();
+            ok = index->build( QFile::encodeName( path ).toStdString(), &m_stop );
+            if ( ok == true )
+            {
+                vlmcDebug() << "Scanned the keyframes of" << path << "in" << timer.elapsed() << "ms";
+                if ( cacheFile.isEmpty() == false &&
+                     index->save( QFile::encodeName( cacheFile ).toStdString(), size, mtime ) == false )
+                    vlmcWarning() << "Can't save the keyframe index to" << cacheFile;
+            }
+        }
+
+        lock.relock();
+        if ( ok == true )
+            m_results.insert( path, index );
+        emit indexed( path );
+    }
+}
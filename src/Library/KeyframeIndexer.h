@@ -0,0 +1,83 @@
+/*****************************************************************************
+ * KeyframeIndexer.h: Builds the keyframe index of the media in the background
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef KEYFRAMEINDEXER_H
+#define KEYFRAMEINDEXER_H
+
+#include <QHash>
+#include <QMutex>
+#include <QSharedPointer>
+#include <QThread>
+#include <QWaitCondition>
+#include <QWeakPointer>
+
+#include <atomic>
+#include <deque>
+#include <memory>
+
+class Media;
+
+namespace Backend
+{
+class KeyframeIndex;
+}
+
+/**
+ *  \brief  Indexes the keyframes of the media, one at a time, in a background thread.
+ *
+ *  Indexes are saved in the "keyframes" folder of the workspace, next to the media
+ *  library database & thumbnails, and are only rebuilt when the file changes.
+ */
+class KeyframeIndexer : public QThread
+{
+    Q_OBJECT
+
+    public:
+        explicit KeyframeIndexer( QObject* parent = nullptr );
+        ~KeyframeIndexer();
+
+        /// An empty directory disables the persistence of the indexes
+        void            setCacheDirectory( const QString& path );
+        void            index( QSharedPointer<Media> media );
+
+    protected:
+        virtual void    run() override;
+
+    private:
+        void            indexReady( const QString& path );
+
+    private:
+        // Only used from the thread the indexer belongs to
+        QHash<QString, QWeakPointer<Media>>     m_pending;
+
+        QMutex                  m_mutex;
+        QWaitCondition          m_cond;
+        QString                 m_cacheDirectory;
+        std::deque<QString>     m_queue;
+        QHash<QString, std::shared_ptr<const Backend::KeyframeIndex>>  m_results;
+        std::atomic_bool        m_stop;
+
+    signals:
+        void            indexed( const QString& path );
+};
+
+#endif // KEYFRAMEINDEXER_H
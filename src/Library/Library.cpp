@@ -32,6 +32,7 @@
 #endif
 
 #include "Library.h"
+#include "KeyframeIndexer.h"
 #include "Media/Clip.h"
 #include "Media/Media.h"
 #include "MediaLibraryModel.h"
@@ -47,6 +48,7 @@ Library::Library( Settings* vlmcSettings, Settings *projectSettings )
     : m_initialized( false )
     , m_cleanState( true )
     , m_settings( new Settings )
+    , m_keyframeIndexer( new KeyframeIndexer )
 {
     // Setting up the external media library
     m_ml.reset( NewMediaLibrary() );
@@ -64,6 +66,9 @@ Library::Library( Settings* vlmcSettings, Settings *projectSettings )
     m_settings->createVar( SettingValue::List, QStringLiteral( "medias" ), QVariantList(), "", "", SettingValue::Nothing );
     connect( m_settings.get(), &Settings::postLoad, this, &Library::postLoad, Qt::DirectConnection );
     connect( m_settings.get(), &Settings::preSave, this, &Library::preSave, Qt::DirectConnection );
+    m_settings->setRecordHandler( { QStringLiteral( "medias" ) }, [this]( const QVariant& var ) {
+        loadMedia( var.toMap() );
+    } );
     projectSettings->addSettings( QStringLiteral( "Library" ), *m_settings );
 }
 
@@ -80,17 +85,23 @@ Library::preSave()
 void
 Library::postLoad()
 {
+    // Binary projects hand the medias over while they're read, see loadMedia()
     for ( const auto& var : m_settings->value( "medias" )->get().toList() )
+        loadMedia( var.toMap() );
+}
+
+void
+Library::loadMedia( const QVariantMap& map )
+{
+    auto m = Media::fromVariant( map );
+    if ( m == nullptr )
+        return;
+    addMedia( m );
+    if ( map.contains( "clips" ) == true )
     {
-        auto map = var.toMap();
-        auto m = Media::fromVariant( map );
-        addMedia( m );
-        if ( map.contains( "clips" ) == true )
-        {
-            const auto& subClipsList = map["clips"].toList();
-            for ( const auto& subClip : subClipsList )
-                m->loadSubclip( subClip.toMap() );
-        }
+        const auto& subClipsList = map["clips"].toList();
+        for ( const auto& subClip : subClipsList )
+            m->loadSubclip( subClip.toMap() );
     }
 }
 
@@ -106,6 +117,9 @@ Library::addMedia( QSharedPointer<Media> media )
         return;
     m_media[media->id()] = media;
     m_clips[media->baseClip()->uuid()] = media->baseClip();
+    // Generated medias seek anywhere at no cost
+    if ( media->isGenerated() == false )
+        m_keyframeIndexer->index( media );
     emit clipAdded( media->baseClip()->uuid().toString() );
     vlmcDebug() << "Clip" << media->baseClip()->uuid().toString() << "is added to Library";
     connect( media.data(), &Media::subclipAdded, [this]( QSharedPointer<Clip> c ) {
@@ -141,6 +155,12 @@ Library::mlMedia( qint64 mediaId )
     return m_ml->media( mediaId );
 }
 
+medialibrary::MediaPtr
+Library::mlMedia( const QString& mrl )
+{
+    return m_ml->media( mrl.toStdString() );
+}
+
 MediaLibraryModel*
 Library::model() const
 {
@@ -199,6 +219,7 @@ Library::workspaceChanged(const QVariant& workspace)
         // Initializing the medialibrary doesn't start new folders discovery.
         // This will happen after the first call to IMediaLibrary::discover()
         m_ml->initialize( w + "/ml.db", w + "/thumbnails/", this );
+        m_keyframeIndexer->setCacheDirectory( workspace.toString() + "/keyframes/" );
         m_initialized = true;
         m_ml->start();
         m_ml->reload();
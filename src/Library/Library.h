@@ -39,6 +39,7 @@
 #include <memory>
 
 class Clip;
+class KeyframeIndexer;
 class Media;
 class MediaLibraryModel;
 class ProjectManager;
@@ -62,6 +63,7 @@ public:
 
     //FIXME: This feels rather ugly
     medialibrary::MediaPtr mlMedia( qint64 mediaId);
+    medialibrary::MediaPtr mlMedia( const QString& mrl );
 
     MediaLibraryModel* model() const;
 
@@ -81,6 +83,7 @@ private:
 
     void            preSave();
     void            postLoad();
+    void            loadMedia( const QVariantMap& map );
 
 private:
     virtual void onMediaAdded( std::vector<medialibrary::MediaPtr> media ) override;
@@ -121,6 +124,7 @@ private:
      *                  subclip hierarchy
      */
     QHash<QUuid, QSharedPointer<Clip>>              m_clips;
+    std::unique_ptr<KeyframeIndexer>                m_keyframeIndexer;
 
 signals:
     /**
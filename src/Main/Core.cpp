@@ -38,6 +38,7 @@
 #include "Project/Workspace.h"
 #include <Settings/Settings.h>
 #include <Tools/VlmcLogger.h>
+#include "Workflow/Journal.h"
 #include "Workflow/MainWorkflow.h"
 
 Core::Core()
@@ -53,13 +54,14 @@ Core::Core()
     m_workflow = new MainWorkflow( m_currentProject->settings() );
 
     QObject::connect( m_workflow, &MainWorkflow::cleanChanged, m_currentProject, &Project::cleanChanged );
-    QObject::connect( m_currentProject, &Project::projectSaved, m_workflow, &MainWorkflow::setClean );
     QObject::connect( m_library, &Library::cleanStateChanged, m_currentProject, &Project::libraryCleanChanged );
     QObject::connect( m_currentProject, &Project::projectLoaded, m_recentProjects, &RecentProjects::projectLoaded );
     QObject::connect( m_currentProject, &Project::projectSaved, m_recentProjects, &RecentProjects::projectLoaded );
     QObject::connect( m_currentProject, &Project::projectClosed, m_library, &Library::clear );
     QObject::connect( m_currentProject, &Project::projectClosed, m_workflow, &MainWorkflow::clear );
     QObject::connect( m_currentProject, &Project::fpsChanged, m_workflow, &MainWorkflow::fpsChanged );
+    QObject::connect( m_workflow->journal(), &Journal::compactionRequired,
+                      m_currentProject, &Project::journalCompactionRequired );
 
     m_timer.start();
 }
@@ -72,8 +74,9 @@ Core::~Core()
     delete m_workspace;
     delete m_currentProject;
     delete m_settings;
-    delete m_backend;
+    // The logger removes its handler from the backend
     delete m_logger;
+    delete m_backend;
 }
 
 void
@@ -0,0 +1,353 @@
+/*****************************************************************************
+ * Engine.cpp: Embeddable headless VLMC
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "Engine.h"
+#include "Backend/IBackend.h"
+#include "Backend/IInput.h"
+#include "Commands/AbstractUndoStack.h"
+#include "Main/Core.h"
+#include "Project/Project.h"
+#include "Settings/Settings.h"
+#include "Tools/VlmcDebug.h"
+#include "Workflow/MainWorkflow.h"
+#include "Workflow/Types.h"
+
+#include <QCoreApplication>
+#include <QFileInfo>
+#include <QUuid>
+
+using namespace Vlmc;
+
+// The core outlives the engine, and so does the application it runs in
+static int      appArgc = 1;
+static char     appName[] = "vlmc";
+static char*    appArgv[] = { appName, nullptr };
+
+Engine::Edit::Edit( Type type )
+    : m_type( type )
+    , m_trackId( 0 )
+    , m_trackBId( 0 )
+    , m_pos( 0 )
+    , m_begin( 0 )
+    , m_end( 0 )
+    , m_isAudio( false )
+{
+}
+
+Engine::Edit
+Engine::Edit::addClip( const QString& libraryClip, quint32 trackId, qint64 pos )
+{
+    Edit e( AddClip );
+    e.m_uuid = libraryClip;
+    e.m_trackId = trackId;
+    e.m_pos = pos;
+    return e;
+}
+
+Engine::Edit
+Engine::Edit::moveClip( const QString& clip, quint32 trackId, qint64 pos )
+{
+    Edit e( MoveClip );
+    e.m_uuid = clip;
+    e.m_trackId = trackId;
+    e.m_pos = pos;
+    return e;
+}
+
+Engine::Edit
+Engine::Edit::resizeClip( const QString& clip, qint64 begin, qint64 end, qint64 pos )
+{
+    Edit e( ResizeClip );
+    e.m_uuid = clip;
+    e.m_begin = begin;
+    e.m_end = end;
+    e.m_pos = pos;
+    return e;
+}
+
+Engine::Edit
+Engine::Edit::removeClip( const QString& clip )
+{
+    Edit e( RemoveClip );
+    e.m_uuid = clip;
+    return e;
+}
+
+Engine::Edit
+Engine::Edit::splitClip( const QString& clip, qint64 pos, qint64 begin )
+{
+    Edit e( SplitClip );
+    e.m_uuid = clip;
+    e.m_pos = pos;
+    e.m_begin = begin;
+    return e;
+}
+
+Engine::Edit
+Engine::Edit::addEffect( const QString& clip, const QString& effect )
+{
+    Edit e( AddEffect );
+    e.m_uuid = clip;
+    e.m_identifier = effect;
+    return e;
+}
+
+Engine::Edit
+Engine::Edit::addTransition( const QString& transition, qint64 begin, qint64 end,
+                             quint32 trackAId, quint32 trackBId, bool isAudio )
+{
+    Edit e( AddTransition );
+    e.m_identifier = transition;
+    e.m_begin = begin;
+    e.m_end = end;
+    e.m_trackId = trackAId;
+    e.m_trackBId = trackBId;
+    e.m_isAudio = isAudio;
+    return e;
+}
+
+Engine::Edit
+Engine::Edit::removeTransition( const QString& transition )
+{
+    Edit e( RemoveTransition );
+    e.m_uuid = transition;
+    return e;
+}
+
+Engine::Engine()
+{
+    if ( QCoreApplication::instance() == nullptr )
+    {
+        auto app = new QCoreApplication( appArgc, appArgv );
+        app->setApplicationName( "VLMC" );
+        app->setOrganizationName( "VideoLAN" );
+        app->setOrganizationDomain( "videolan.org" );
+        app->setApplicationVersion( PACKAGE_VERSION );
+    }
+
+    qRegisterMetaType<Workflow::TrackType>( "Workflow::TrackType" );
+    qRegisterMetaType<Vlmc::FrameChangedReason>( "Vlmc::FrameChangedReason" );
+    qRegisterMetaType<QVariant>( "QVariant" );
+    qRegisterMetaType<QUuid>( "QUuid" );
+    Backend::instance();
+    Core::instance()->settings()->load();
+}
+
+Engine::~Engine()
+{
+    close();
+}
+
+bool
+Engine::open( const QString& path )
+{
+    return Core::instance()->project()->load( QFileInfo( path ).absoluteFilePath() );
+}
+
+bool
+Engine::save( const QString& path )
+{
+    // Project::saveAs() completes from the event loop, which the caller may not run
+    return Core::instance()->project()->saveAsNow( QFileInfo( path ).absoluteFilePath() );
+}
+
+void
+Engine::close()
+{
+    Core::instance()->project()->closeProject();
+}
+
+qint64
+Engine::length() const
+{
+    return Core::instance()->workflow()->playableLength();
+}
+
+double
+Engine::fps() const
+{
+    return Core::instance()->project()->fps();
+}
+
+quint32
+Engine::width() const
+{
+    return Core::instance()->project()->width();
+}
+
+quint32
+Engine::height() const
+{
+    return Core::instance()->project()->height();
+}
+
+bool
+Engine::apply( const QList<Edit>& edits, QStringList* created )
+{
+    auto workflow = Core::instance()->workflow();
+    // Failed commands are pushed as well. They revert what they did before failing,
+    // and undoing them does nothing.
+    int nbCommands = 0;
+    auto pushed = QObject::connect( workflow->undoStack(), &Commands::AbstractUndoStack::indexChanged,
+                                    [&nbCommands]{ ++nbCommands; } );
+    QStringList uuids;
+    auto added = QObject::connect( workflow, &MainWorkflow::clipAdded, [&uuids]( const QString& uuid ) {
+        uuids << uuid;
+    } );
+
+    bool res = true;
+    for ( int i = 0; i < edits.size(); ++i )
+    {
+        if ( applyEdit( edits[i], uuids ) == false )
+        {
+            vlmcWarning() << "Edit" << i << "of the batch failed, undoing the batch";
+            res = false;
+            break;
+        }
+    }
+    QObject::disconnect( added );
+    QObject::disconnect( pushed );
+
+    if ( res == false )
+    {
+        for ( int i = 0; i < nbCommands; ++i )
+            workflow->undoStack()->undo();
+        uuids.clear();
+    }
+    if ( created != nullptr )
+        *created = uuids;
+    return res;
+}
+
+bool
+Engine::applyEdit( const Edit& edit, QStringList& created )
+{
+    auto workflow = Core::instance()->workflow();
+    // The commands expect the clips & transitions they're given to exist
+    switch ( edit.m_type )
+    {
+    case Edit::AddClip:
+    case Edit::AddTransition:
+        break;
+    case Edit::RemoveTransition:
+        if ( workflow->transitionInfo( edit.m_uuid ).isEmpty() == true )
+        {
+            vlmcWarning() << "Unknown transition:" << edit.m_uuid;
+            return false;
+        }
+        break;
+    default:
+        if ( workflow->clipInfo( edit.m_uuid ).isEmpty() == true )
+        {
+            vlmcWarning() << "Unknown clip:" << edit.m_uuid;
+            return false;
+        }
+        break;
+    }
+    switch ( edit.m_type )
+    {
+    case Edit::AddClip:
+        return workflow->addClip( edit.m_uuid, edit.m_trackId, static_cast<qint32>( edit.m_pos ) );
+    case Edit::MoveClip:
+        return workflow->moveClip( edit.m_uuid, edit.m_trackId, edit.m_pos );
+    case Edit::ResizeClip:
+        return workflow->resizeClip( edit.m_uuid, edit.m_begin, edit.m_end, edit.m_pos );
+    case Edit::RemoveClip:
+        return workflow->removeClip( edit.m_uuid );
+    case Edit::SplitClip:
+        return workflow->splitClip( QUuid( edit.m_uuid ), edit.m_pos, edit.m_begin );
+    case Edit::AddEffect:
+    {
+        auto uuid = workflow->addEffect( edit.m_uuid, edit.m_identifier );
+        if ( uuid.isEmpty() == true )
+            return false;
+        created << uuid;
+        return true;
+    }
+    case Edit::AddTransition:
+    {
+        const QString type = edit.m_isAudio == true ? QStringLiteral( "Audio" ) : QStringLiteral( "Video" );
+        QString uuid;
+        if ( edit.m_trackId == edit.m_trackBId )
+            uuid = workflow->addTransition( edit.m_identifier, edit.m_begin, edit.m_end,
+                                            edit.m_trackId, type );
+        else
+            uuid = workflow->addTransitionBetweenTracks( edit.m_identifier, edit.m_begin, edit.m_end,
+                                                         edit.m_trackId, edit.m_trackBId, type );
+        if ( QUuid( uuid ).isNull() == true )
+            return false;
+        created << uuid;
+        return true;
+    }
+    case Edit::RemoveTransition:
+        return workflow->removeTransition( QUuid( edit.m_uuid ) );
+    }
+    return false;
+}
+
+void
+Engine::undo()
+{
+    Core::instance()->workflow()->undoStack()->undo();
+}
+
+void
+Engine::redo()
+{
+    Core::instance()->workflow()->undoStack()->redo();
+}
+
+QJsonObject
+Engine::clipInfo( const QString& clip ) const
+{
+    return Core::instance()->workflow()->clipInfo( clip );
+}
+
+bool
+Engine::frame( qint64 position, uint8_t* buffer, quint32 width, quint32 height )
+{
+    auto input = Core::instance()->workflow()->input();
+    if ( buffer == nullptr || position < 0 || position >= input->playableLength() )
+        return false;
+    input->setPosition( position );
+    return input->image( buffer, width, height );
+}
+
+bool
+Engine::render( const QString& fileName, qint64 begin, qint64 end )
+{
+    auto workflow = Core::instance()->workflow();
+    if ( end < 0 )
+        end = workflow->playableLength() - 1;
+    auto settings = Core::instance()->project()->outputSettings( QFileInfo( fileName ).absoluteFilePath() );
+    return workflow->renderToFiles( { settings }, begin, end );
+}
+
+void
+Engine::processEvents()
+{
+    QCoreApplication::processEvents();
+}
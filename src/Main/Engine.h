@@ -0,0 +1,203 @@
+/*****************************************************************************
+ * Engine.h: Embeddable headless VLMC
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef ENGINE_H
+#define ENGINE_H
+
+#include <QJsonObject>
+#include <QList>
+#include <QString>
+#include <QStringList>
+
+#include <cstdint>
+
+namespace Vlmc
+{
+
+/**
+ *  \brief  Drives VLMC from another program, without any UI.
+ *
+ *  This is the API of libvlmccore, which holds the backend, the workflow, the media,
+ *  the library, the projects, the commands and the renderers, built without the GUI.
+ *  All the calls are synchronous: the caller doesn't need to run an event loop, and
+ *  gets its result when a call returns. The engine must be used from the thread
+ *  which created it.
+ *
+ *  VLMC's core is made of process wide singletons, so only one engine may exist at a
+ *  time. They outlive the engine, as do their caches (the decoded media, the keyframe
+ *  indexes): a process running several jobs in a row, with one project each, keeps
+ *  them warm from one job to the next.
+ *
+ *  If the program has no QCoreApplication, the engine creates one, named after VLMC
+ *  so that the projects made by VLMC find their media in its media library.
+ *
+ *  \code
+ *  Vlmc::Engine engine;
+ *  if ( engine.open( "movie.vlmc" ) == false )
+ *      return 1;
+ *  QStringList created;
+ *  engine.apply( { Vlmc::Engine::Edit::moveClip( clip, 1, 250 ),
+ *                  Vlmc::Engine::Edit::addEffect( clip, "greyscale" ) }, &created );
+ *  std::vector<uint8_t> rgba( 320 * 180 * 4 );
+ *  engine.frame( 250, rgba.data(), 320, 180 );
+ *  engine.render( "movie.mp4" );
+ *  \endcode
+ */
+class Engine
+{
+    public:
+        /**
+         *  \brief  An edit of the timeline, see apply()
+         *
+         *  Clips are clip instances of the timeline, identified by their uuid, but for
+         *  addClip() which takes a clip of the library. Positions are in frames.
+         */
+        class Edit
+        {
+            public:
+                static Edit     addClip( const QString& libraryClip, quint32 trackId, qint64 pos );
+                static Edit     moveClip( const QString& clip, quint32 trackId, qint64 pos );
+                /// \param begin, end   The new boundaries of the clip, in its media
+                static Edit     resizeClip( const QString& clip, qint64 begin, qint64 end, qint64 pos );
+                static Edit     removeClip( const QString& clip );
+                /// \param pos      The position of the new clip in the timeline
+                /// \param begin    The first frame of the new clip, in its media
+                static Edit     splitClip( const QString& clip, qint64 pos, qint64 begin );
+                /// \param effect   The MLT identifier of the filter, ie. "greyscale"
+                static Edit     addEffect( const QString& clip, const QString& effect );
+                /**
+                 *  \param  transition  The identifier of the transition, ie. "dissolve"
+                 *  \param  trackAId, trackBId  The tracks to blend. The same track blends
+                 *                              its overlapping clips.
+                 */
+                static Edit     addTransition( const QString& transition, qint64 begin, qint64 end,
+                                               quint32 trackAId, quint32 trackBId, bool isAudio = false );
+                static Edit     removeTransition( const QString& transition );
+
+            private:
+                enum Type
+                {
+                    AddClip,
+                    MoveClip,
+                    ResizeClip,
+                    RemoveClip,
+                    SplitClip,
+                    AddEffect,
+                    AddTransition,
+                    RemoveTransition,
+                };
+
+                explicit Edit( Type type );
+
+            private:
+                Type        m_type;
+                QString     m_uuid;
+                QString     m_identifier;
+                quint32     m_trackId;
+                quint32     m_trackBId;
+                qint64      m_pos;
+                qint64      m_begin;
+                qint64      m_end;
+                bool        m_isAudio;
+
+                friend class Engine;
+        };
+
+        Engine();
+        ~Engine();
+
+        Engine( const Engine& ) = delete;
+        Engine& operator=( const Engine& ) = delete;
+
+        /**
+         *  \brief  Load a project, closing the current one.
+         */
+        bool            open( const QString& path );
+        /**
+         *  \brief  Save the project, in the binary format if path ends with ".vlmcb".
+         *  \return false if the file couldn't be written
+         */
+        bool            save( const QString& path );
+        void            close();
+
+        /// The length of the timeline, in frames
+        qint64          length() const;
+        double          fps() const;
+        quint32         width() const;
+        quint32         height() const;
+
+        /**
+         *  \brief  Apply a batch of edits, in order.
+         *
+         *  Each edit is an undoable command, as if it was made in VLMC. The batch is
+         *  applied as a whole: if an edit fails, the previous ones are undone.
+         *  \param  created     If set, receives the uuids of the clips, effects and
+         *                      transitions created by the batch, in order. Adding a clip
+         *                      with audio & video creates two clip instances.
+         *  \return false if an edit failed, and the timeline was left as it was.
+         */
+        bool            apply( const QList<Edit>& edits, QStringList* created = nullptr );
+        /**
+         *  \brief  Undo the last edit, or redo the last undone one.
+         */
+        void            undo();
+        void            redo();
+
+        /**
+         *  \return The state of a clip instance of the timeline: its position, track,
+         *          boundaries, media & filters. Empty if there is no such clip.
+         */
+        QJsonObject     clipInfo( const QString& clip ) const;
+
+        /**
+         *  \brief  Render a frame of the timeline into a caller provided buffer.
+         *
+         *  \param  buffer  Receives the frame as 32-bit RGBA, width * height * 4 bytes.
+         *  \return false if the frame couldn't be rendered
+         */
+        bool            frame( qint64 position, uint8_t* buffer, quint32 width, quint32 height );
+
+        /**
+         *  \brief  Export the timeline to a file, with the output settings of the project.
+         *
+         *  \param  begin   The first frame to render
+         *  \param  end     The last frame to render, included. -1 renders up to the end.
+         *  \return true once the whole range was rendered.
+         */
+        bool            render( const QString& fileName, qint64 begin = 0, qint64 end = -1 );
+
+        /**
+         *  \brief  Deliver the pending notifications.
+         *
+         *  Not needed for the synchronous calls. Long running programs may call it
+         *  between jobs, so that the background tasks, such as the media library
+         *  discovery, report their progress.
+         */
+        void            processEvents();
+
+    private:
+        bool            applyEdit( const Edit& edit, QStringList& created );
+};
+
+}
+
+#endif // ENGINE_H
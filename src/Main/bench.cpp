@@ -0,0 +1,169 @@
+/*****************************************************************************
+ * bench.cpp: Headless benchmark entry point
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/** \file
+ *  Measures VLMC on a synthetic project, and prints the results as JSON.
+ *  With a baseline, the metrics which got worse than it by more than the threshold
+ *  are listed as regressions.
+ *  The exit code is 0 on success, 1 when a regression was found, and 2 when the
+ *  benchmark couldn't run.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "Backend/IBackend.h"
+#include "Benchmark/Benchmark.h"
+#include "Workflow/Types.h"
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QFile>
+#include <QJsonDocument>
+#include <QUuid>
+
+#include <cstdio>
+
+int
+main( int argc, char **argv )
+{
+    QCoreApplication app( argc, argv );
+    // Keeps the settings, media library and recent projects apart from VLMC's
+    app.setApplicationName( "vlmc-bench" );
+    app.setOrganizationName( "VideoLAN" );
+    app.setOrganizationDomain( "videolan.org" );
+    app.setApplicationVersion( PACKAGE_VERSION );
+
+    const Benchmark::Options defaults;
+    QCommandLineParser parser;
+    parser.setApplicationDescription( "Measures the performance of VLMC on a synthetic project, "
+                                      "which needs no media file." );
+    parser.addHelpOption();
+    parser.addVersionOption();
+    parser.addOption( { "tracks", "Number of tracks.", "count",
+                        QString::number( defaults.project.nbTracks ) } );
+    parser.addOption( { "clips", "Number of clips per track.", "count",
+                        QString::number( defaults.project.nbClips ) } );
+    parser.addOption( { "clip-length", "Length of the clips, in frames.", "frames",
+                        QString::number( defaults.project.clipLength ) } );
+    parser.addOption( { "filters", "Number of filters, spread over the video clips.", "count",
+                        QString::number( defaults.project.nbFilters ) } );
+    parser.addOption( { "transitions", "Number of transitions between adjacent tracks.", "count",
+                        QString::number( defaults.project.nbTransitions ) } );
+    parser.addOption( { "size", "Size of the project.", "WIDTHxHEIGHT",
+                        QStringLiteral( "%1x%2" ).arg( defaults.width ).arg( defaults.height ) } );
+    parser.addOption( { "edits", "Number of edits to time.", "count",
+                        QString::number( defaults.nbEdits ) } );
+    parser.addOption( { "seeks", "Number of seeks to time.", "count",
+                        QString::number( defaults.nbSeeks ) } );
+    parser.addOption( { "preview-duration", "How long to pull frames from the preview output, "
+                        "in milliseconds.", "msec", QString::number( defaults.previewDuration ) } );
+    parser.addOption( { "export-length", "Number of frames to export.", "frames",
+                        QString::number( defaults.exportLength ) } );
+    parser.addOption( { "seed", "Seed of the random edits and seeks.", "seed",
+                        QString::number( defaults.seed ) } );
+    parser.addOption( { { "o", "output" }, "Write the results to this file rather than to "
+                        "the standard output.", "filename" } );
+    parser.addOption( { "baseline", "Compare the results with the ones in this file.", "filename" } );
+    parser.addOption( { "threshold", "How much worse than the baseline a metric may get, "
+                        "in percent.", "percent", "10" } );
+    parser.process( app );
+
+    Benchmark::Options options;
+    options.project.nbTracks = parser.value( "tracks" ).toInt();
+    options.project.nbClips = parser.value( "clips" ).toInt();
+    options.project.clipLength = parser.value( "clip-length" ).toLongLong();
+    options.project.nbFilters = parser.value( "filters" ).toInt();
+    options.project.nbTransitions = parser.value( "transitions" ).toInt();
+    options.nbEdits = parser.value( "edits" ).toInt();
+    options.nbSeeks = parser.value( "seeks" ).toInt();
+    options.previewDuration = parser.value( "preview-duration" ).toInt();
+    options.exportLength = parser.value( "export-length" ).toLongLong();
+    options.seed = parser.value( "seed" ).toUInt();
+    auto size = parser.value( "size" ).split( 'x' );
+    if ( size.size() == 2 )
+    {
+        options.width = size[0].toInt();
+        options.height = size[1].toInt();
+    }
+    if ( size.size() != 2 || options.width <= 0 || options.height <= 0 ||
+         options.project.nbTracks <= 0 || options.project.nbClips <= 0 ||
+         options.project.clipLength < 2 )
+    {
+        fprintf( stderr, "Invalid project description\n" );
+        return 2;
+    }
+
+    qRegisterMetaType<Workflow::TrackType>( "Workflow::TrackType" );
+    qRegisterMetaType<Vlmc::FrameChangedReason>( "Vlmc::FrameChangedReason" );
+    qRegisterMetaType<QVariant>( "QVariant" );
+    qRegisterMetaType<QUuid>( "QUuid" );
+    Backend::instance();
+
+    Benchmark benchmark( options );
+    int res = benchmark.run() == true ? 0 : 2;
+    auto results = benchmark.results();
+
+    if ( parser.isSet( "baseline" ) == true )
+    {
+        QFile file( parser.value( "baseline" ) );
+        if ( file.open( QFile::ReadOnly ) == false )
+        {
+            fprintf( stderr, "Can't read the baseline %s\n", qPrintable( file.fileName() ) );
+            return 2;
+        }
+        auto regressions = Benchmark::compare( results, QJsonDocument::fromJson( file.readAll() ).object(),
+                                               parser.value( "threshold" ).toDouble() );
+        for ( const auto& r : regressions )
+        {
+            auto regression = r.toObject();
+            if ( regression["value"].isNull() == true )
+            {
+                fprintf( stderr, "Regression: %s couldn't be measured\n",
+                         qPrintable( regression["metric"].toString() ) );
+                continue;
+            }
+            fprintf( stderr, "Regression: %s went from %g to %g\n",
+                     qPrintable( regression["metric"].toString() ),
+                     regression["baseline"].toDouble(), regression["value"].toDouble() );
+        }
+        results["regressions"] = regressions;
+        if ( res == 0 && regressions.isEmpty() == false )
+            res = 1;
+    }
+
+    const auto json = QJsonDocument( results ).toJson();
+    if ( parser.isSet( "output" ) == true )
+    {
+        QFile file( parser.value( "output" ) );
+        if ( file.open( QFile::WriteOnly | QFile::Truncate ) == false )
+        {
+            fprintf( stderr, "Can't write the results to %s\n", qPrintable( file.fileName() ) );
+            return 2;
+        }
+        file.write( json );
+    }
+    else
+        fwrite( json.constData(), 1, json.size(), stdout );
+    return res;
+}
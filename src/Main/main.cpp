@@ -30,9 +30,14 @@
 # include "config.h"
 #endif
 
+#include "Tools/Tracer.h"
 #include "Tools/VlmcDebug.h"
 #include "Workflow/Types.h"
 #include "Renderer/ConsoleRenderer.h"
+#include "Renderer/RenderDaemon.h"
+#include "Renderer/RenderFarmCoordinator.h"
+#include "Renderer/RenderFarmWorker.h"
+#include "Renderer/RenderWorker.h"
 #include "Project/Project.h"
 #include "Backend/IBackend.h"
 #include "Main/Core.h"
@@ -52,6 +57,8 @@
 #include <QCoreApplication>
 #endif
 #include <QFile>
+#include <QFileInfo>
+#include <QHostAddress>
 #include <QSettings>
 #include <QUuid>
 #include <QTextCodec>
@@ -87,6 +94,64 @@ setupCommandLine( QCommandLineParser& parser )
     parser.addOption( { { "b", "backendverbose" },
                         QCoreApplication::translate( "main", "Backend Log level to set" ),
                         "value" } );
+    parser.addOption( { { "o", "output" },
+                        QCoreApplication::translate( "main", "Additional file to render in the "
+                                                     "same pass. Size and video bitrate default "
+                                                     "to the project ones." ),
+                        "filename[,WIDTHxHEIGHT[,VIDEOBITRATE]]" } );
+    parser.addOption( { "segment-duration",
+                        QCoreApplication::translate( "main", "Render in resumable segments of "
+                                                     "this duration, in seconds. An interrupted "
+                                                     "render resumes from its last complete "
+                                                     "segment." ),
+                        "seconds" } );
+    parser.addOption( { "progress-fd",
+                        QCoreApplication::translate( "main", "Report the render progress, "
+                                                     "throughput and per stage timings as JSON "
+                                                     "lines on this file descriptor." ),
+                        "fd" } );
+    parser.addOption( { "daemon",
+                        QCoreApplication::translate( "main", "Run as a headless render service, "
+                                                     "accepting jobs on this local socket. "
+                                                     "Use vlmc-submit to send them." ),
+                        "socket" } );
+    parser.addOption( { "max-jobs",
+                        QCoreApplication::translate( "main", "Number of jobs the render service "
+                                                     "runs concurrently." ),
+                        "count", "1" } );
+    // Only used by the render service to start its workers
+    parser.addOption( { "render-worker",
+                        QCoreApplication::translate( "main", "Internal: run as a worker of the "
+                                                     "render service listening on this socket." ),
+                        "socket" } );
+    parser.addOption( { "farm-coordinator",
+                        QCoreApplication::translate( "main", "Render the project to the output "
+                                                     "file on render farm nodes, which connect "
+                                                     "to this port." ),
+                        "port" } );
+    parser.addOption( { "farm-worker",
+                        QCoreApplication::translate( "main", "Run as a render farm node for this "
+                                                     "coordinator." ),
+                        "host:port" } );
+    parser.addOption( { "path-map",
+                        QCoreApplication::translate( "main", "Render farm node: media stored in "
+                                                     "FROM on the coordinator are in TO on this "
+                                                     "node. Can be repeated." ),
+                        "FROM=TO" } );
+    parser.addOption( { "farm-token",
+                        QCoreApplication::translate( "main", "Render farm: secret shared by the "
+                                                     "coordinator and its nodes. Defaults to the "
+                                                     "VLMC_FARM_TOKEN environment variable." ),
+                        "token" } );
+    parser.addOption( { "bind",
+                        QCoreApplication::translate( "main", "Render farm coordinator: address "
+                                                     "to listen on." ),
+                        "address", "127.0.0.1" } );
+    parser.addOption( { "trace",
+                        QCoreApplication::translate( "main", "Trace the pipeline while previewing "
+                                                     "or rendering, and write the events to this "
+                                                     "file in the Chrome trace format." ),
+                        "file" } );
     parser.process( *qApp );
 }
 
@@ -109,7 +174,7 @@ VLMCmainCommon( Backend::IBackend** backend )
  */
 #ifdef HAVE_GUI
 int
-VLMCGuimain( const QString& projectFile )
+VLMCGuimain( const QString& projectFile, const QString& traceFile )
 {
 #ifdef Q_WS_X11
     XInitThreads();
@@ -165,6 +230,9 @@ VLMCGuimain( const QString& projectFile )
 
     qApp->setAttribute( Qt::AA_DontCreateNativeWidgetSiblings, true );
     MainWindow w( backend );
+    // The command line takes precedence over the preference
+    if ( traceFile.isEmpty() == false )
+        Tracer::setOutput( traceFile );
 
     if ( FirstLaunchWizard::shouldRun() == true )
     {
@@ -195,12 +263,16 @@ VLMCGuimain( const QString& projectFile )
  *  \return Return value of vlmc
  */
 int
-VLMCCoremain( const QString& projectFile , const QString& outputFile)
+VLMCCoremain( const QString& projectFile , const QStringList& outputFiles,
+              double segmentDuration, int progressFd )
 {
     Backend::IBackend* backend;
     VLMCmainCommon( &backend );
 
-    ConsoleRenderer renderer( outputFile );
+    ConsoleRenderer renderer( outputFiles );
+    renderer.setSegmentDuration( segmentDuration );
+    if ( progressFd >= 0 && renderer.setProgressFd( progressFd ) == false )
+        return 1;
     Project  *p = Core::instance()->project();
 
     QCoreApplication::connect( p, &Project::projectLoaded, &renderer, &ConsoleRenderer::startRender );
@@ -213,6 +285,106 @@ VLMCCoremain( const QString& projectFile , const QString& outputFile)
     return res;
 }
 
+/**
+ *  \brief Render service entry point.
+ *
+ *  The service itself doesn't initialize the backend, the workers it spawns do.
+ */
+int
+VLMCDaemonmain( const QString& serverName, int maxJobs, const QStringList& workerArguments )
+{
+    RenderDaemon daemon( serverName, maxJobs );
+    daemon.setWorkerArguments( workerArguments );
+    if ( daemon.listen() == false )
+        return 1;
+    return qApp->exec();
+}
+
+int
+VLMCWorkermain( const QString& serverName )
+{
+    Backend::IBackend* backend;
+    VLMCmainCommon( &backend );
+
+    Core::instance()->settings()->load();
+    RenderWorker worker( serverName );
+    if ( worker.connectToDaemon() == false )
+        return 1;
+    return qApp->exec();
+}
+
+int
+VLMCFarmCoordinatormain( const QString& projectFile, const QString& outputFile,
+                         const QString& bind, quint16 port, double segmentDuration,
+                         const QString& token )
+{
+    QHostAddress address;
+    if ( address.setAddress( bind ) == false )
+    {
+        vlmcCritical() << "Invalid address:" << bind;
+        return 1;
+    }
+    if ( token.isEmpty() == true )
+    {
+        vlmcCritical() << "The render farm needs a token: use --farm-token or VLMC_FARM_TOKEN";
+        return 1;
+    }
+
+    Backend::IBackend* backend;
+    VLMCmainCommon( &backend );
+
+    Core::instance()->settings()->load();
+    auto path = QFileInfo( projectFile ).absoluteFilePath();
+    if ( Core::instance()->project()->load( path ) == false )
+        return 1;
+    auto settings = Core::instance()->project()->outputSettings( QFileInfo( outputFile ).absoluteFilePath() );
+    RenderFarmCoordinator coordinator( Core::instance()->workflow(), path, settings, segmentDuration, token );
+    QCoreApplication::connect( &coordinator, &RenderFarmCoordinator::finished, qApp, []( bool success ) {
+        QCoreApplication::exit( success ? 0 : 1 );
+    }, Qt::QueuedConnection );
+    if ( coordinator.listen( address, port ) == false )
+        return 1;
+    return qApp->exec();
+}
+
+int
+VLMCFarmWorkermain( const QString& coordinator, const QStringList& pathMapping,
+                    const QString& token )
+{
+    auto sep = coordinator.lastIndexOf( ':' );
+    if ( sep <= 0 )
+    {
+        vlmcCritical() << "Invalid coordinator address:" << coordinator;
+        return 1;
+    }
+    if ( token.isEmpty() == true )
+    {
+        vlmcCritical() << "The render farm needs a token: use --farm-token or VLMC_FARM_TOKEN";
+        return 1;
+    }
+    QList<QPair<QString, QString>>  mapping;
+    for ( const auto& m : pathMapping )
+    {
+        auto parts = m.split( '=' );
+        if ( parts.size() != 2 )
+        {
+            vlmcCritical() << "Invalid path mapping:" << m;
+            return 1;
+        }
+        mapping << qMakePair( parts[0], parts[1] );
+    }
+
+    Backend::IBackend* backend;
+    VLMCmainCommon( &backend );
+
+    Core::instance()->settings()->load();
+    RenderFarmWorker worker( coordinator.left( sep ), coordinator.mid( sep + 1 ).toUShort(),
+                             mapping, token );
+    if ( worker.connectToCoordinator() == false )
+        return 1;
+    return qApp->exec();
+}
+
 int
 VLMCmain( int argc, char **argv )
 {
@@ -239,14 +411,43 @@ VLMCmain( int argc, char **argv )
     setupCommandLine( parser );
 
     const auto& args = parser.positionalArguments();
+    if ( parser.isSet( "trace" ) == true )
+        Tracer::setOutput( parser.value( "trace" ) );
+
+    const auto farmToken = parser.isSet( "farm-token" ) == true ? parser.value( "farm-token" )
+                                    : QString::fromLocal8Bit( qgetenv( "VLMC_FARM_TOKEN" ) );
+    if ( parser.isSet( "farm-worker" ) == true )
+        return VLMCFarmWorkermain( parser.value( "farm-worker" ), parser.values( "path-map" ), farmToken );
+    if ( parser.isSet( "farm-coordinator" ) == true )
+    {
+        if ( args.size() < 2 )
+            parser.showHelp( 1 );
+        auto segmentDuration = parser.value( "segment-duration" ).toDouble();
+        return VLMCFarmCoordinatormain( args.at( 0 ), args.at( 1 ), parser.value( "bind" ),
+                                        parser.value( "farm-coordinator" ).toUShort(),
+                                        segmentDuration > 0 ? segmentDuration : 10., farmToken );
+    }
+    if ( parser.isSet( "render-worker" ) == true )
+        return VLMCWorkermain( parser.value( "render-worker" ) );
+    if ( parser.isSet( "daemon" ) == true )
+    {
+        QStringList workerArguments;
+        if ( parser.isSet( "backendverbose" ) == true )
+            workerArguments << "--backendverbose" << parser.value( "backendverbose" );
+        workerArguments << "--render-worker";
+        return VLMCDaemonmain( parser.value( "daemon" ), parser.value( "max-jobs" ).toInt(),
+                               workerArguments );
+    }
 
     if ( args.size() >= 2  )
-        return VLMCCoremain( args.at( 0 ), args.at( 1 ) );
+        return VLMCCoremain( args.at( 0 ), QStringList( args.at( 1 ) ) + parser.values( "output" ),
+                             parser.value( "segment-duration" ).toDouble(),
+                             parser.isSet( "progress-fd" ) ? parser.value( "progress-fd" ).toInt() : -1 );
 #ifdef HAVE_GUI
     else if ( args.size() == 1 )
-        return VLMCGuimain( args.at( 0 ) );
+        return VLMCGuimain( args.at( 0 ), parser.value( "trace" ) );
     else
-        return VLMCGuimain( "" );
+        return VLMCGuimain( "", parser.value( "trace" ) );
 #else
     else
         parser.showHelp( 1 ); // This function exits the application. No need to return any value.
@@ -0,0 +1,129 @@
+/*****************************************************************************
+ * microbench.cpp: Microbenchmarks entry point
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/** \file
+ *  Times the edits of the timeline against its size, and prints how each of them
+ *  scales. With a maximum exponent, the exit code is 1 when an edit scales worse than it.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "Backend/IBackend.h"
+#include "Benchmark/EditBenchmarks.h"
+#include "Benchmark/MicroBenchmark.h"
+#include "Workflow/Types.h"
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QUuid>
+
+#include <cstdio>
+
+int
+main( int argc, char **argv )
+{
+    QCoreApplication app( argc, argv );
+    app.setApplicationName( "vlmc-microbench" );
+    app.setOrganizationName( "VideoLAN" );
+    app.setOrganizationDomain( "videolan.org" );
+    app.setApplicationVersion( PACKAGE_VERSION );
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription( "Times the timeline edits on timelines of growing sizes. "
+                                      "Building the largest timelines takes a while." );
+    parser.addHelpOption();
+    parser.addVersionOption();
+    parser.addOption( { "sizes", "Comma separated numbers of clips in the timeline.", "sizes",
+                        "10,100,1000,10000,100000" } );
+    parser.addOption( { "min-time", "How long to repeat each edit for, in milliseconds.", "msec",
+                        "200" } );
+    parser.addOption( { "min-iterations", "How many times to repeat each edit at least.", "count",
+                        "3" } );
+    parser.addOption( { "filter", "Only run the edits whose name contains this string.", "name" } );
+    parser.addOption( { { "o", "output" }, "Also write the results to this file, as JSON.", "filename" } );
+    parser.addOption( { "max-exponent", "Fail when an edit scales worse than size^exponent.",
+                        "exponent" } );
+    parser.process( app );
+
+    QList<int> sizes;
+    for ( const auto& s : parser.value( "sizes" ).split( ',', QString::SkipEmptyParts ) )
+    {
+        bool ok;
+        auto size = s.toInt( &ok );
+        if ( ok == false || size <= 0 )
+        {
+            fprintf( stderr, "Invalid size: %s\n", qPrintable( s ) );
+            return 2;
+        }
+        sizes << size;
+    }
+    if ( sizes.isEmpty() == true )
+    {
+        fprintf( stderr, "No size to run the edits on\n" );
+        return 2;
+    }
+
+    qRegisterMetaType<Workflow::TrackType>( "Workflow::TrackType" );
+    qRegisterMetaType<Vlmc::FrameChangedReason>( "Vlmc::FrameChangedReason" );
+    qRegisterMetaType<QVariant>( "QVariant" );
+    qRegisterMetaType<QUuid>( "QUuid" );
+    Backend::instance();
+
+    MicroBenchmark benchmark( sizes, parser.value( "min-time" ).toInt(),
+                              parser.value( "min-iterations" ).toInt() );
+    EditBenchmarks::registerCases( benchmark );
+    const auto results = benchmark.run( parser.value( "filter" ) );
+
+    int res = 0;
+    QJsonArray cases;
+    for ( const auto& r : results )
+    {
+        const auto text = r.toText().toUtf8();
+        fwrite( text.constData(), 1, text.size(), stdout );
+        fputc( '\n', stdout );
+        fflush( stdout );
+        cases.append( r.toJson() );
+        if ( parser.isSet( "max-exponent" ) == true &&
+             r.exponent > parser.value( "max-exponent" ).toDouble() )
+        {
+            fprintf( stderr, "%s scales as size^%.2f\n", qPrintable( r.name ), r.exponent );
+            res = 1;
+        }
+    }
+
+    if ( parser.isSet( "output" ) == true )
+    {
+        QFile file( parser.value( "output" ) );
+        if ( file.open( QFile::WriteOnly | QFile::Truncate ) == false )
+        {
+            fprintf( stderr, "Can't write the results to %s\n", qPrintable( file.fileName() ) );
+            return 2;
+        }
+        file.write( QJsonDocument( QJsonObject{ { "cases", cases } } ).toJson() );
+    }
+    return res;
+}
@@ -0,0 +1,145 @@
+/*****************************************************************************
+ * submit.cpp: Command line client for the VLMC render service
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/** \file
+ *  Sends a job to a running "vlmc --daemon" and prints the service's answers,
+ *  one JSON object per line, until the job completes.
+ *  The exit code is 0 when the job succeeded.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QLocalSocket>
+#include <QTextStream>
+
+#include <cstdio>
+
+static QJsonObject
+parseOutput( const QString& description )
+{
+    // filename[,WIDTHxHEIGHT[,VIDEOBITRATE]], as for "vlmc --output"
+    auto parts = description.split( ',' );
+    QJsonObject output{ { "fileName", QFileInfo( parts[0] ).absoluteFilePath() } };
+    if ( parts.size() > 1 )
+    {
+        auto size = parts[1].split( 'x' );
+        if ( size.size() != 2 )
+            return QJsonObject();
+        output["width"] = size[0].toInt();
+        output["height"] = size[1].toInt();
+    }
+    if ( parts.size() > 2 )
+        output["videoBitrate"] = parts[2].toInt();
+    return output;
+}
+
+int
+main( int argc, char **argv )
+{
+    QCoreApplication app( argc, argv );
+    app.setApplicationName( "vlmc-submit" );
+    app.setOrganizationName( "VideoLAN" );
+    app.setApplicationVersion( PACKAGE_VERSION );
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription( "Submits a render job to a VLMC render service." );
+    parser.addHelpOption();
+    parser.addVersionOption();
+    parser.addPositionalArgument( "project", "Project file to render.", "[filename]" );
+    parser.addPositionalArgument( "output", "Output files to render to.",
+                                  "[filename[,WIDTHxHEIGHT[,VIDEOBITRATE]]...]" );
+    parser.addOption( { { "s", "socket" }, "Socket the service listens on.", "socket", "vlmc" } );
+    parser.addOption( { "begin", "First frame to render.", "frame" } );
+    parser.addOption( { "end", "Last frame to render.", "frame" } );
+    parser.addOption( { "segment-duration", "Render in resumable segments of this duration, "
+                        "in seconds.", "seconds" } );
+    parser.addOption( { "status", "Print the service's queued and running jobs, and exit." } );
+    parser.process( app );
+
+    QJsonObject request;
+    if ( parser.isSet( "status" ) == true )
+        request["type"] = QStringLiteral( "status" );
+    else
+    {
+        const auto args = parser.positionalArguments();
+        if ( args.size() < 2 )
+            parser.showHelp( 1 );
+        QJsonArray outputs;
+        for ( int i = 1; i < args.size(); ++i )
+        {
+            auto output = parseOutput( args[i] );
+            if ( output.isEmpty() == true )
+            {
+                fprintf( stderr, "Invalid output description: %s\n", qPrintable( args[i] ) );
+                return 1;
+            }
+            outputs.append( output );
+        }
+        request["type"] = QStringLiteral( "submit" );
+        request["project"] = QFileInfo( args[0] ).absoluteFilePath();
+        request["outputs"] = outputs;
+        if ( parser.isSet( "begin" ) == true )
+            request["begin"] = parser.value( "begin" ).toLongLong();
+        if ( parser.isSet( "end" ) == true )
+            request["end"] = parser.value( "end" ).toLongLong();
+        if ( parser.isSet( "segment-duration" ) == true )
+            request["segmentDuration"] = parser.value( "segment-duration" ).toDouble();
+    }
+
+    QLocalSocket socket;
+    socket.connectToServer( parser.value( "socket" ) );
+    if ( socket.waitForConnected() == false )
+    {
+        fprintf( stderr, "Can't connect to the render service: %s\n", qPrintable( socket.errorString() ) );
+        return 1;
+    }
+    socket.write( QJsonDocument( request ).toJson( QJsonDocument::Compact ) + '\n' );
+
+    QTextStream out( stdout );
+    while ( socket.waitForReadyRead( -1 ) == true )
+    {
+        while ( socket.canReadLine() == true )
+        {
+            auto line = socket.readLine();
+            out << line;
+            out.flush();
+            auto message = QJsonDocument::fromJson( line ).object();
+            auto type = message["type"].toString();
+            if ( type == QStringLiteral( "status" ) )
+                return 0;
+            if ( type == QStringLiteral( "error" ) )
+                return 1;
+            if ( type == QStringLiteral( "result" ) )
+                return message["success"].toBool() == true ? 0 : 1;
+        }
+    }
+    fprintf( stderr, "The render service closed the connection\n" );
+    return 1;
+}
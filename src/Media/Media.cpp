@@ -35,9 +35,12 @@
 #include <QVariant>
 #include <QFileInfo>
 
+#include <atomic>
+
 #include "Media.h"
 
 #include "Clip.h"
+#include "Backend/IBackend.h"
 #include "Main/Core.h"
 #include "Library/Library.h"
 #include "Tools/VlmcDebug.h"
@@ -61,6 +64,8 @@ const QString   Media::streamPrefix = "stream://";
 Media::Media( medialibrary::MediaPtr media, const QUuid& uuid /* = QUuid() */ )
     : m_input( nullptr )
     , m_mlMedia( media )
+    , m_length( 0 )
+    , m_id( media->id() )
     , m_baseClipUuid( uuid )
     , m_baseClip( nullptr )
 {
@@ -79,22 +84,50 @@ Media::Media( medialibrary::MediaPtr media, const QUuid& uuid /* = QUuid() */ )
     m_input.reset( new Backend::MLT::MLTInput( qPrintable( mrl() ) ) );
 }
 
+Media::Media( const QString& generator, qint64 length, const QUuid& uuid /* = QUuid() */ )
+    : m_input( nullptr )
+    , m_generator( generator )
+    , m_length( length )
+    , m_baseClipUuid( uuid )
+    , m_baseClip( nullptr )
+{
+    static std::atomic<qint64>  lastId( 0 );
+    m_id = --lastId;
+
+    auto sep = generator.indexOf( ':' );
+    auto service = generator.left( sep ).toUtf8();
+    auto argument = sep < 0 ? QByteArray() : generator.mid( sep + 1 ).toUtf8();
+    m_input.reset( new Backend::MLT::MLTInput( Backend::instance()->profile(), service.constData(),
+                                               argument.isEmpty() ? nullptr : argument.constData(),
+                                               length ) );
+}
+
+bool
+Media::isGenerated() const
+{
+    return m_mlMedia == nullptr;
+}
+
 QString
 Media::mrl() const
 {
+    if ( isGenerated() == true )
+        return m_generator;
     return QUrl::fromPercentEncoding( QByteArray( m_mlFile->mrl().c_str() ) );
 }
 
 QString
 Media::title() const
 {
+    if ( isGenerated() == true )
+        return m_generator;
     return QUrl::fromPercentEncoding( QByteArray( m_mlMedia->title().c_str() ) );
 }
 
 qint64
 Media::id() const
 {
-    return m_mlMedia->id();
+    return m_id;
 }
 
 QSharedPointer<Clip>
@@ -125,10 +158,23 @@ Media::removeSubclip(const QUuid& uuid)
 QVariant
 Media::toVariant() const
 {
-    QVariantHash h = {
-        { "uuid", m_baseClip->uuid() },
-        { "mlId", static_cast<qlonglong>( m_mlMedia->id() ) }
-    };
+    QVariantHash h;
+    if ( isGenerated() == true )
+    {
+        h = {
+            { "uuid", m_baseClip->uuid() },
+            { "generator", m_generator },
+            { "length", m_length },
+        };
+    }
+    else
+    {
+        h = {
+            { "uuid", m_baseClip->uuid() },
+            { "mlId", static_cast<qlonglong>( m_mlMedia->id() ) },
+            { "mrl", QString::fromStdString( m_mlFile->mrl() ) },
+        };
+    }
     if ( m_clips.isEmpty() == false )
     {
         QVariantList l;
@@ -170,25 +216,62 @@ Media::fromVariant( const QVariant& v )
      * The media is stored as such:
      * media: {
      *  mlId: <id>   // The media library ID
+     *  mrl: <mrl>   // The media location, as known by the media library
      *  uuid: <uuid> // The root clip UUID
      *  clips: [
      *    <clip 1>,  // The subclips
      *    ...
      *  ]
      * }
+     * Generated medias have "generator" and "length" fields instead of "mlId" and "mrl".
      */
     const auto& m = v.toMap();
 
-    if ( m.contains( "mlId" ) == false || m.contains( "uuid" ) == false )
+    if ( m.contains( "uuid" ) == false )
     {
-        vlmcWarning() << "Invalid clip provided:" << m << "Missing 'mlId' and/or 'uuid' field(s)";
+        vlmcWarning() << "Invalid clip provided:" << m << "Missing 'uuid' field";
         return {};
     }
-    auto mediaId = m["mlId"].toLongLong();
     auto uuid = m["uuid"].toUuid();
-    auto mlMedia = Core::instance()->library()->mlMedia( mediaId );
-    //FIXME: Is QSharedPointer exception safe in case its constructor throws an exception?
-    auto media = QSharedPointer<Media>::create( mlMedia, uuid );
+
+    QSharedPointer<Media> media;
+    if ( m.contains( "generator" ) == true )
+    {
+        try
+        {
+            media = QSharedPointer<Media>::create( m["generator"].toString(), m["length"].toLongLong(), uuid );
+        }
+        catch ( Backend::InvalidServiceException& )
+        {
+            vlmcWarning() << "Can't create generated media" << m["generator"].toString();
+            return {};
+        }
+    }
+    else
+    {
+        if ( m.contains( "mlId" ) == false )
+        {
+            vlmcWarning() << "Invalid clip provided:" << m << "Missing 'mlId' field";
+            return {};
+        }
+        auto mediaId = m["mlId"].toLongLong();
+        auto library = Core::instance()->library();
+        // Media library IDs are local to a media library, which may not be the one this
+        // project was created with (see RenderFarmWorker), where the same ID may be
+        // another media. The location, when known, is the only reliable key.
+        medialibrary::MediaPtr mlMedia;
+        if ( m.contains( "mrl" ) == true )
+            mlMedia = library->mlMedia( m["mrl"].toString() );
+        else
+            mlMedia = library->mlMedia( mediaId );
+        if ( mlMedia == nullptr )
+        {
+            vlmcWarning() << "Can't find media" << mediaId << m["mrl"].toString() << "in the media library";
+            return {};
+        }
+        //FIXME: Is QSharedPointer exception safe in case its constructor throws an exception?
+        media = QSharedPointer<Media>::create( mlMedia, uuid );
+    }
 
     // Now load the subclips:
     if ( m.contains( "clips" ) == false )
@@ -205,6 +288,8 @@ Media::fromVariant( const QVariant& v )
 QString
 Media::snapshot()
 {
+    if ( isGenerated() == true )
+        return {};
     return QString::fromStdString( m_mlMedia->thumbnail() );
 }
 
@@ -70,6 +70,16 @@ public:
     static const QString        streamPrefix;
 
     Media( medialibrary::MediaPtr media, const QUuid& uuid = QUuid() );
+    /**
+     *  \brief Creates a media generated by an MLT producer, which isn't backed by a file
+     *          nor known to the media library.
+     *  \param generator   The producer, followed by its argument if any, ie. "color:red",
+     *                      "noise:" or "tone:"
+     *  \param length      The length of the media, in frames
+     */
+    Media( const QString& generator, qint64 length, const QUuid& uuid = QUuid() );
+
+    bool                        isGenerated() const;
 
     QString                     mrl() const;
     QString                     title() const;
@@ -103,6 +113,10 @@ protected:
     std::unique_ptr<Backend::IInput>         m_input;
     medialibrary::MediaPtr      m_mlMedia;
     medialibrary::FilePtr       m_mlFile;
+    QString                     m_generator;
+    qint64                      m_length;
+    /// Generated medias get negative ids, so they can't collide with the media library's
+    qint64                      m_id;
     QUuid                       m_baseClipUuid;
     QSharedPointer<Clip>        m_baseClip;
     QHash<QUuid, QSharedPointer<Clip>>      m_clips;
@@ -37,9 +37,13 @@
 #include "RecentProjects.h"
 #include "Settings/Settings.h"
 #include "Tools/VlmcDebug.h"
+#include "Workflow/Journal.h"
+#include "Workflow/MainWorkflow.h"
 
 const QString   Project::unNamedProject = Project::tr( "Untitled Project" );
 const QString   Project::backupSuffix = "~";
+const QString   Project::journalSuffix = ".journal";
+const QString   Project::binaryExtension = ".vlmcb";
 
 Project::Project( Settings* settings )
     : m_projectFile( nullptr )
@@ -61,6 +65,21 @@ Project::Project( Settings* settings )
                                                        "between two automatic save" ), SettingValue::Clamped );
     automaticBackupInterval->setLimits( 1, QVariant( QVariant::Invalid ) );
 
+    connect( m_settings, &Settings::saved, this, [this]( bool success, const QString& path ) {
+        // Only the asynchronous saves are reported, each of them was queued
+        if ( m_pendingSaves.isEmpty() == true )
+            return;
+        const auto pending = m_pendingSaves.dequeue();
+        if ( success == false )
+            return;
+        auto workflow = Core::instance()->workflow();
+        // The edits preceding the snapshot are in the file now, the ones made while it
+        // was written aren't.
+        workflow->journal()->compact( pending.checkpoint );
+        if ( workflow->editCount() == pending.editCount )
+            workflow->setClean();
+        emit projectSaved( m_settings->value( "general/ProjectName" )->get().toString(), path );
+    } );
     connect( m_timer, &QTimer::timeout, this, &Project::autoSaveRequired );
     connect( this, &Project::destroyed, m_timer, &QTimer::stop );
 
@@ -156,10 +175,39 @@ Project::save()
 void
 Project::saveAs( const QString& fileName )
 {
-    m_projectFile.reset( new QFile( fileName ) );
+    setProjectFile( fileName );
     saveProject( fileName );
 }
 
+bool
+Project::saveAsNow( const QString& fileName )
+{
+    setProjectFile( fileName );
+    auto workflow = Core::instance()->workflow();
+    const auto checkpoint = workflow->journal()->checkpoint();
+    m_settings->setSettingsFile( fileName );
+    if ( m_settings->save() == false )
+    {
+        vlmcWarning() << "Failed to save the project to" << fileName;
+        return false;
+    }
+    // Nothing could be edited meanwhile
+    workflow->journal()->compact( checkpoint );
+    workflow->setClean();
+    emit projectSaved( m_settings->value( "general/ProjectName" )->get().toString(), fileName );
+    return true;
+}
+
+void
+Project::setProjectFile( const QString& fileName )
+{
+    // The journal of the previous file only applies to it
+    Core::instance()->workflow()->journal()->discard();
+    // Loading picks the format up from the file itself, the backups keep using it
+    m_settings->setFormat( fileName.endsWith( binaryExtension ) == true ? Settings::Binary : Settings::Json );
+    m_projectFile.reset( new QFile( fileName ) );
+}
+
 void
 Project::newProject( const QString& projectName, const QString& projectFilePath )
 {
@@ -210,6 +258,13 @@ Project::initSettings()
                                                              QT_TRANSLATE_NOOP("PreferenceWidget", "Number of audio channels" ),
                                                              SettingValue::Clamped );
     audioChannel->setLimits( 2, 2 );
+    m_fps = SettingHandle<double>( fps );
+    m_width = SettingHandle<unsigned int>( width );
+    m_height = SettingHandle<unsigned int>( height );
+    m_audioBitrate = SettingHandle<unsigned int>( aBitRate );
+    m_videoBitrate = SettingHandle<unsigned int>( vBitRate );
+    m_sampleRate = SettingHandle<unsigned int>( sampleRate );
+    m_nbChannels = SettingHandle<unsigned int>( audioChannel );
     SettingValue    *pName = m_settings->createVar( SettingValue::String, "general/ProjectName", unNamedProject,
                                     QT_TRANSLATE_NOOP( "PreferenceWidget", "Project name" ),
                                     QT_TRANSLATE_NOOP( "PreferenceWidget", "The project name" ),
@@ -226,17 +281,25 @@ Project::initSettings()
 void
 Project::saveProject( const QString& fileName )
 {
+    auto workflow = Core::instance()->workflow();
+    m_pendingSaves.enqueue( PendingSave{ workflow->journal()->checkpoint(), workflow->editCount() } );
     m_settings->setSettingsFile( fileName );
-    bool ret = m_settings->save();
-    if ( ret == true )
-        emit projectSaved( m_settings->value( "general/ProjectName" )->get().toString(), fileName );
+    // Only the snapshot of the project is taken here, it's written in the background
+    m_settings->saveAsync();
 }
 
 void
 Project::emergencyBackup()
 {
     const QString& name = m_projectFile->fileName() + Project::backupSuffix;
-    saveProject( name );
+    // There may be no event loop to complete an asynchronous save
+    Core::instance()->workflow()->journal()->checkpoint();
+    m_settings->setSettingsFile( name );
+    if ( m_settings->save() == true )
+    {
+        Core::instance()->workflow()->setClean();
+        emit projectSaved( m_settings->value( "general/ProjectName" )->get().toString(), name );
+    }
     Core::instance()->settings()->setValue( "private/EmergencyBackup", name );
 }
 
@@ -251,6 +314,8 @@ Project::closeProject()
 {
     if ( m_projectFile == nullptr )
         return;
+    // The unsaved edits are dropped along with the project
+    Core::instance()->workflow()->journal()->discard();
     m_settings->restoreDefaultValues();
     emit projectClosed();
     m_projectFile.release();
@@ -280,19 +345,19 @@ Project::name() const
 double
 Project::fps() const
 {
-    return m_settings->value( "video/VLMCOutputFPS" )->get().toDouble();
+    return m_fps.get();
 }
 
 unsigned int
 Project::width() const
 {
-    return m_settings->value( "video/VideoProjectWidth" )->get().toUInt();
+    return m_width.get();
 }
 
 unsigned int
 Project::height() const
 {
-    return m_settings->value( "video/VideoProjectHeight" )->get().toUInt();
+    return m_height.get();
 }
 
 QString
@@ -304,25 +369,41 @@ Project::aspectRatio() const
 unsigned int
 Project::audioBitrate() const
 {
-    return m_settings->value( "audio/AudioBitRate" )->get().toUInt();
+    return m_audioBitrate.get();
 }
 
 unsigned int
 Project::videoBitrate() const
 {
-    return m_settings->value( "video/VideoBitRate" )->get().toUInt();
+    return m_videoBitrate.get();
 }
 
 unsigned int
 Project::sampleRate() const
 {
-    return m_settings->value( "audio/AudioSampleRate" )->get().toUInt();
+    return m_sampleRate.get();
 }
 
 unsigned int
 Project::nbChannels() const
 {
-    return m_settings->value( "audio/NbChannels" )->get().toUInt();
+    return m_nbChannels.get();
+}
+
+Workflow::OutputSettings
+Project::outputSettings( const QString& fileName ) const
+{
+    Workflow::OutputSettings    settings;
+    settings.fileName = fileName;
+    settings.width = width();
+    settings.height = height();
+    settings.fps = fps();
+    settings.aspectRatio = aspectRatio();
+    settings.videoBitrate = videoBitrate();
+    settings.audioBitrate = audioBitrate();
+    settings.nbChannels = nbChannels();
+    settings.sampleRate = sampleRate();
+    return settings;
 }
 
 QFile*
@@ -348,11 +429,26 @@ Project::libraryCleanChanged( bool val )
 {
     Q_ASSERT( m_libraryCleanState != val);
     m_libraryCleanState = val;
+    // The journal refers to the library clips, which it doesn't save
+    if ( val == false && Core::instance()->workflow()->journal()->isOpen() == true )
+        journalCompactionRequired();
     emit cleanStateChanged( m_libraryCleanState == true && m_isClean == true );
 }
 
 void
 Project::autoSaveRequired()
+{
+    if ( m_projectFile == nullptr )
+        return ;
+    // The journal already covers the timeline edits, only save them once in a while
+    auto journal = Core::instance()->workflow()->journal();
+    if ( journal->isOpen() == true && journal->hasEdits() == false && m_libraryCleanState == true )
+        return ;
+    saveProject( m_projectFile->fileName() + Project::backupSuffix );
+}
+
+void
+Project::journalCompactionRequired()
 {
     if ( m_projectFile == nullptr )
         return ;
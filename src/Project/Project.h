@@ -28,6 +28,10 @@
 #include <memory>
 
 #include <QObject>
+#include <QQueue>
+
+#include "Settings/SettingHandle.h"
+#include "Workflow/Types.h"
 
 class QFile;
 class QString;
@@ -45,6 +49,9 @@ class Project : public QObject
     public:
         static const QString            unNamedProject;
         static const QString            backupSuffix;
+        static const QString            journalSuffix;
+        /// Projects saved with this extension use the binary format, see BinarySettings
+        static const QString            binaryExtension;
 
     public:
         Q_DISABLE_COPY( Project )
@@ -54,6 +61,13 @@ class Project : public QObject
 
         void            save();
         void            saveAs( const QString& fileName );
+        /**
+         *  @brief          Save as fileName, and return once the file is written.
+         *
+         *  For the callers without an event loop, which saveAs() needs to complete.
+         *  @return         false if the file couldn't be written
+         */
+        bool            saveAsNow( const QString& fileName );
         void            newProject( const QString& projectName, const QString& projectFilePath );
         /**
          *  @brief          Check for a project backup file, and load the appropriate file,
@@ -82,18 +96,27 @@ class Project : public QObject
         unsigned int    sampleRate() const;
         unsigned int    nbChannels() const;
 
+        /**
+         *  @brief          Returns the settings to render the project to fileName, using
+         *                  the project output settings.
+         */
+        Workflow::OutputSettings    outputSettings( const QString& fileName ) const;
+
     public:
         static QFile* emergencyBackupFile();
 
     private:
         void                initSettings();
         void                saveProject( const QString& filename );
+        void                setProjectFile( const QString& fileName );
 
 
     public slots:
         void                cleanChanged( bool val );
         void                libraryCleanChanged( bool val );
         void                autoSaveRequired();
+        /// Save a backup, so that the journal of the edits can be truncated
+        void                journalCompactionRequired();
         void                autoSaveEnabledChanged( const QVariant& enabled );
         void                autoSaveIntervalChanged( const QVariant& interval );
 
@@ -127,6 +150,23 @@ class Project : public QObject
 
     private:
         std::unique_ptr<QFile>              m_projectFile;
+        struct PendingSave
+        {
+            // The journal checkpoint of the snapshot, see Journal
+            QString     checkpoint;
+            // MainWorkflow::editCount() when the snapshot was taken
+            quint64     editCount;
+        };
+        // The saves being written
+        QQueue<PendingSave>                 m_pendingSaves;
+        // Read for every output and every profile change, see SettingHandle
+        SettingHandle<double>               m_fps;
+        SettingHandle<unsigned int>         m_width;
+        SettingHandle<unsigned int>         m_height;
+        SettingHandle<unsigned int>         m_audioBitrate;
+        SettingHandle<unsigned int>         m_videoBitrate;
+        SettingHandle<unsigned int>         m_sampleRate;
+        SettingHandle<unsigned int>         m_nbChannels;
         bool                m_isClean;
         bool                m_libraryCleanState;
         QTimer*             m_timer;
@@ -27,7 +27,9 @@
 
 #include "AbstractRenderer.h"
 
+#include "Tools/PerfCounters.h"
 #include "Tools/RendererEventWatcher.h"
+#include "Tools/Tracer.h"
 #include "Backend/MLT/MLTOutput.h"
 
 #include <QtGlobal>
@@ -35,7 +37,14 @@
 AbstractRenderer::AbstractRenderer()
     : m_input( nullptr )
     , m_eventWatcher( new RendererEventWatcher )
+    , m_scrubbing( false )
+    , m_scrubFrame( -1 )
+    , m_scrubShown( -1 )
+    , m_tracing( false )
 {
+    m_scrubTimer.setSingleShot( true );
+    m_scrubTimer.setInterval( ScrubInterval );
+    connect( &m_scrubTimer, &QTimer::timeout, this, &AbstractRenderer::applyScrub );
     connect( m_eventWatcher.data(), &RendererEventWatcher::stopped, this, &AbstractRenderer::stop );
     connect( m_eventWatcher.data(), &RendererEventWatcher::positionChanged, this, [this]( qint64 pos ){ emit frameChanged( pos, Vlmc::Renderer ); } );
     connect( m_eventWatcher.data(), &RendererEventWatcher::lengthChanged, this, &AbstractRenderer::lengthChanged );
@@ -44,6 +53,7 @@ AbstractRenderer::AbstractRenderer()
 
 AbstractRenderer::~AbstractRenderer()
 {
+    setScrubFrame( -1 );
     stop();
 }
 
@@ -58,7 +68,30 @@ AbstractRenderer::stop()
 {
     if ( m_output == nullptr )
         return;
+    stopOutput();
+}
+
+void
+AbstractRenderer::startOutput()
+{
+    // A preview is traced from the moment it starts playing until it stops
+    if ( m_tracing == false )
+    {
+        m_tracing = true;
+        Tracer::beginSession();
+    }
+    m_output->start();
+}
+
+void
+AbstractRenderer::stopOutput()
+{
     m_output->stop();
+    if ( m_tracing == true )
+    {
+        m_tracing = false;
+        Tracer::endSession();
+    }
 }
 
 void
@@ -68,6 +101,101 @@ AbstractRenderer::setPosition( qint64 pos )
         m_input->setPosition( pos );
 }
 
+void
+AbstractRenderer::beginScrub()
+{
+    if ( m_input == nullptr || !m_output || isRendering() == false )
+        return;
+    m_scrubbing = true;
+    setScrubFrame( -1 );
+    m_scrubShown = m_input->position();
+    m_output->setScrubbing( true );
+}
+
+void
+AbstractRenderer::scrub( qint64 frame )
+{
+    if ( m_scrubbing == false )
+    {
+        setPosition( frame );
+        return;
+    }
+    // Requests coming while a seek is being served only replace the pending one
+    setScrubFrame( frame );
+    if ( m_scrubTimer.isActive() == false )
+        applyScrub();
+}
+
+void
+AbstractRenderer::applyScrub()
+{
+    if ( m_scrubFrame < 0 || !m_output || isRendering() == false )
+        return;
+    auto frame = m_scrubFrame;
+    setScrubFrame( -1 );
+
+    auto keyframe = m_keyframeLookup ? m_keyframeLookup( frame ) : m_input->keyframeBefore( frame );
+    auto target = frame;
+    // Decoding carries on from the frame shown last when it's in the same GOP, which is
+    // about as cheap as decoding the keyframe alone.
+    if ( keyframe >= 0 && ( m_scrubShown < keyframe || m_scrubShown > frame ) )
+        target = keyframe;
+    if ( target == m_scrubShown )
+        return;
+    m_scrubShown = target;
+    m_input->setPosition( target );
+    m_output->purge();
+    m_scrubTimer.start();
+}
+
+void
+AbstractRenderer::endScrub( qint64 frame )
+{
+    if ( m_scrubbing == false )
+        return;
+    m_scrubbing = false;
+    m_scrubTimer.stop();
+    setScrubFrame( -1 );
+    if ( !m_output )
+        return;
+    m_output->setScrubbing( false );
+    if ( isRendering() == false )
+        return;
+    m_input->setPosition( frame );
+    m_output->purge();
+}
+
+void
+AbstractRenderer::setScrubFrame( qint64 frame )
+{
+    if ( ( m_scrubFrame < 0 ) != ( frame < 0 ) )
+        PerfCounters::add( PerfCounters::PendingSeeks, frame < 0 ? -1 : 1 );
+    m_scrubFrame = frame;
+}
+
+bool
+AbstractRenderer::isScrubbing() const
+{
+    return m_scrubbing;
+}
+
+void
+AbstractRenderer::setKeyframeLookup( KeyframeLookup lookup )
+{
+    m_keyframeLookup = std::move( lookup );
+}
+
+QSize
+AbstractRenderer::frameSize() const
+{
+    if ( !m_output )
+    {
+        const auto& profile = Backend::instance()->profile();
+        return QSize( profile.width(), profile.height() );
+    }
+    return QSize( m_output->frameWidth(), m_output->frameHeight() );
+}
+
 void
 AbstractRenderer::togglePlayPause()
 {
@@ -76,7 +204,7 @@ AbstractRenderer::togglePlayPause()
 
     if ( m_output->isStopped() )
     {
-        m_output->start();
+        startOutput();
         m_input->setPause( false );
     }
     else
@@ -109,6 +237,49 @@ AbstractRenderer::previousFrame()
         m_input->previousFrame();
 }
 
+void
+AbstractRenderer::shuttle( double direction )
+{
+    if ( m_input == nullptr || !m_output )
+        return;
+    if ( m_output->isStopped() )
+        startOutput();
+    auto speed = shuttleSpeed();
+    // Changing direction starts over at normal speed
+    if ( speed * direction <= 0 )
+        speed = direction;
+    else if ( qAbs( speed ) < MaxShuttleSpeed )
+        speed *= 2;
+    m_input->setSpeed( speed );
+}
+
+void
+AbstractRenderer::shuttleForward()
+{
+    shuttle( 1.0 );
+}
+
+void
+AbstractRenderer::shuttleBackward()
+{
+    shuttle( -1.0 );
+}
+
+void
+AbstractRenderer::shuttleStop()
+{
+    if ( isRendering() && m_input )
+        m_input->setSpeed( 0.0 );
+}
+
+double
+AbstractRenderer::shuttleSpeed() const
+{
+    if ( m_input == nullptr || m_input->isPaused() )
+        return 0.0;
+    return m_input->speed();
+}
+
 qint64
 AbstractRenderer::length() const
 {
@@ -187,6 +358,9 @@ AbstractRenderer::previewWidgetCursorChanged( qint64 newFrame )
 {
     if ( isRendering() == true )
     {
-        m_input->setPosition( newFrame );
+        if ( m_scrubbing == true )
+            scrub( newFrame );
+        else
+            m_input->setPosition( newFrame );
     }
 }
@@ -27,9 +27,12 @@
 #ifdef HAVE_CONFIG_H
 #include "config.h"
 #endif
+#include <functional>
 #include <memory>
 #include <QObject>
 #include <QSharedPointer>
+#include <QSize>
+#include <QTimer>
 
 #include "Workflow/Types.h"
 #include "Backend/IOutput.h"
@@ -90,6 +93,33 @@ public:
      */
     virtual void                    previousFrame();
 
+    /**
+     *  \brief  Shuttle forward, as the L key of most editors does.
+     *
+     *  Starts playing forward, or doubles the forward speed up to MaxShuttleSpeed.
+     *  \sa     shuttleBackward(), shuttleStop()
+     */
+    virtual void                    shuttleForward();
+
+    /**
+     *  \brief  Shuttle backward, as the J key of most editors does.
+     *
+     *  Starts playing backward, or doubles the backward speed up to MaxShuttleSpeed.
+     */
+    virtual void                    shuttleBackward();
+
+    /**
+     *  \brief  Pause the shuttle, as the K key of most editors does.
+     */
+    virtual void                    shuttleStop();
+
+    /**
+     *  \return The playback speed, negative when playing backward and 0 when paused.
+     */
+    virtual double                  shuttleSpeed() const;
+
+    static const int                MaxShuttleSpeed = 4;
+
     /**
      *  \brief Stop the renderer.
      *  \sa togglePlayPause( bool );
@@ -98,6 +128,48 @@ public:
 
     virtual void                    setPosition( qint64 pos );
 
+    /**
+     *  \brief  Start dragging the playhead.
+     *
+     *  Until endScrub() is called, the renderer favours responsiveness over exactness:
+     *  only the latest position requested through scrub() is sought, at most every
+     *  ScrubInterval ms, and it is rounded to a frame that is cheap to decode.
+     *  \sa     scrub(), endScrub()
+     */
+    void                            beginScrub();
+
+    /**
+     *  \brief  Move the dragged playhead to frame.
+     */
+    void                            scrub( qint64 frame );
+
+    /**
+     *  \brief  Stop dragging the playhead, and show the exact frame it was dropped at.
+     */
+    void                            endScrub( qint64 frame );
+
+    bool                            isScrubbing() const;
+
+    /**
+     *  \brief  Returns the position of the keyframe at or before a frame, or -1
+     */
+    using KeyframeLookup = std::function<qint64( qint64 frame )>;
+
+    /**
+     *  \brief  Set how keyframes are found while scrubbing.
+     *
+     *  By default, the keyframe index of the input is used. Inputs made of several
+     *  sources, such as the timeline, don't have one.
+     */
+    void                            setKeyframeLookup( KeyframeLookup lookup );
+
+    /**
+     *  \brief  The size of the frames the output asks for, which the preview may lower.
+     */
+    QSize                           frameSize() const;
+
+    static const int                ScrubInterval = 40;
+
     /**
      *  \brief   Return the volume
      *  \return  The Return the volume the audio level (int)
@@ -152,11 +224,26 @@ public:
 
     QSharedPointer<RendererEventWatcher>           eventWatcher();
 protected:
+    void                                        shuttle( double direction );
+    void                                        applyScrub();
+    void                                        setScrubFrame( qint64 frame );
+    void                                        startOutput();
+    void                                        stopOutput();
+
     std::unique_ptr<Backend::IOutput>             m_output;
 
     Backend::IInput*                             m_input;
     QSharedPointer<RendererEventWatcher>           m_eventWatcher;
 
+private:
+    QTimer                                      m_scrubTimer;
+    bool                                        m_scrubbing;
+    // The latest position requested while scrubbing, or -1 once it was sought
+    qint64                                      m_scrubFrame;
+    qint64                                      m_scrubShown;
+    KeyframeLookup                              m_keyframeLookup;
+    // Whether a Tracer session was started for the current playback
+    bool                                        m_tracing;
 
 public slots:
     /**
@@ -0,0 +1,271 @@
+/*****************************************************************************
+ * CheckpointedRender.cpp: Render the workflow in resumable segments
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "CheckpointedRender.h"
+#include "Tools/Tracer.h"
+#include "Tools/VlmcDebug.h"
+#include "Workflow/MainWorkflow.h"
+
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QProcess>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QTextStream>
+
+static const int    ManifestVersion = 1;
+
+CheckpointedRender::CheckpointedRender( MainWorkflow* workflow, const Workflow::OutputSettings& settings,
+                                        double segmentDuration )
+    : m_workflow( workflow )
+    , m_settings( settings )
+    , m_segmentDuration( segmentDuration )
+{
+    QCryptographicHash  hash( QCryptographicHash::Sha1 );
+    QByteArray          settingsKey;
+    hash.addData( workflow->graphHash() );
+    QTextStream( &settingsKey ) << settings.width << 'x' << settings.height << '@' << settings.fps
+                                << ':' << settings.aspectRatio << ':' << settings.videoBitrate << ':'
+                                << settings.audioBitrate << ':' << settings.nbChannels << ':'
+                                << settings.sampleRate << ':' << segmentDuration;
+    hash.addData( settingsKey );
+    m_hash = hash.result().toHex();
+}
+
+QList<CheckpointedRender::Segment>
+CheckpointedRender::segments( qint64 length, qint64 segmentLength )
+{
+    QList<Segment>  res;
+    if ( segmentLength <= 0 )
+        return res;
+    for ( qint64 begin = 0; begin < length; begin += segmentLength )
+        res << Segment{ res.size(), begin, qMin( begin + segmentLength, length ) - 1 };
+    return res;
+}
+
+QString
+CheckpointedRender::partsDirectory() const
+{
+    return m_settings.fileName + QStringLiteral( ".parts" );
+}
+
+QString
+CheckpointedRender::segmentFileName( int index ) const
+{
+    // Keep the output extension, it selects the container of each segment.
+    auto suffix = QFileInfo( m_settings.fileName ).suffix();
+    auto name = QStringLiteral( "segment-%1" ).arg( index, 5, 10, QChar( '0' ) );
+    if ( suffix.isEmpty() == false )
+        name += '.' + suffix;
+    return partsDirectory() + '/' + name;
+}
+
+QByteArray
+CheckpointedRender::hash() const
+{
+    return m_hash;
+}
+
+qint64
+CheckpointedRender::segmentLength() const
+{
+    return qMax<qint64>( 1, qRound64( m_segmentDuration * m_settings.fps ) );
+}
+
+void
+CheckpointedRender::loadManifest( qint64 length, qint64 segmentLength )
+{
+    QFile   file( partsDirectory() + QStringLiteral( "/manifest.json" ) );
+    if ( file.open( QFile::ReadOnly ) == true )
+    {
+        auto manifest = QJsonDocument::fromJson( file.readAll() ).object();
+        if ( manifest["version"].toInt() == ManifestVersion &&
+             manifest["hash"].toString().toLatin1() == m_hash &&
+             manifest["length"].toVariant().toLongLong() == length &&
+             manifest["segmentLength"].toVariant().toLongLong() == segmentLength )
+        {
+            m_manifest = manifest;
+            return;
+        }
+        vlmcWarning() << "Discarding segments of a previous render of" << m_settings.fileName
+                      << ": the timeline or the output settings changed";
+        QDir( partsDirectory() ).removeRecursively();
+    }
+    m_manifest = QJsonObject{
+        { "version", ManifestVersion },
+        { "hash", QString::fromLatin1( m_hash ) },
+        { "length", length },
+        { "segmentLength", segmentLength },
+        { "segments", QJsonArray() },
+    };
+}
+
+bool
+CheckpointedRender::saveManifest() const
+{
+    // Never leave a partially written manifest behind, it would lose every segment.
+    QSaveFile   file( partsDirectory() + QStringLiteral( "/manifest.json" ) );
+    if ( file.open( QFile::WriteOnly ) == false )
+        return false;
+    file.write( QJsonDocument( m_manifest ).toJson() );
+    return file.commit();
+}
+
+bool
+CheckpointedRender::isCompleted( const Segment& segment ) const
+{
+    for ( const auto& s : m_manifest["segments"].toArray() )
+    {
+        auto o = s.toObject();
+        if ( o["index"].toInt() != segment.index )
+            continue;
+        // A segment removed or truncated since then has to be rendered again
+        QFileInfo info( segmentFileName( segment.index ) );
+        return info.exists() == true &&
+                info.size() == o["size"].toVariant().toLongLong();
+    }
+    return false;
+}
+
+bool
+CheckpointedRender::markCompleted( const Segment& segment )
+{
+    QFileInfo info( segmentFileName( segment.index ) );
+    if ( info.exists() == false )
+        return false;
+    auto segments = m_manifest["segments"].toArray();
+    for ( int i = 0; i < segments.size(); ++i )
+    {
+        if ( segments[i].toObject()["index"].toInt() == segment.index )
+        {
+            segments.removeAt( i );
+            break;
+        }
+    }
+    segments.append( QJsonObject{
+        { "index", segment.index },
+        { "begin", segment.begin },
+        { "end", segment.end },
+        { "file", info.fileName() },
+        { "size", info.size() },
+    } );
+    m_manifest["segments"] = segments;
+    return saveManifest();
+}
+
+QString
+CheckpointedRender::concatProgram()
+{
+    auto res = QStandardPaths::findExecutable( QStringLiteral( "ffmpeg" ) );
+    if ( res.isEmpty() == true )
+        vlmcCritical() << "Segmented renders need the ffmpeg program to join the segments,"
+                          " and it wasn't found in the PATH";
+    return res;
+}
+
+bool
+CheckpointedRender::concat( int nbSegments )
+{
+    const auto program = concatProgram();
+    if ( program.isEmpty() == true )
+        return false;
+    QFile   list( partsDirectory() + QStringLiteral( "/segments.txt" ) );
+    if ( list.open( QFile::WriteOnly | QFile::Truncate ) == false )
+        return false;
+    {
+        QTextStream stream( &list );
+        for ( int i = 0; i < nbSegments; ++i )
+        {
+            auto fileName = QFileInfo( segmentFileName( i ) ).fileName();
+            stream << "file '" << fileName << "'\n";
+        }
+    }
+    list.close();
+
+    // The concat demuxer only rewrites the container, the segments aren't re-encoded.
+    QProcess    ffmpeg;
+    ffmpeg.setProcessChannelMode( QProcess::ForwardedErrorChannel );
+    ffmpeg.start( program, {
+                      QStringLiteral( "-y" ), QStringLiteral( "-loglevel" ), QStringLiteral( "error" ),
+                      QStringLiteral( "-f" ), QStringLiteral( "concat" ),
+                      QStringLiteral( "-safe" ), QStringLiteral( "0" ),
+                      QStringLiteral( "-i" ), list.fileName(),
+                      QStringLiteral( "-c" ), QStringLiteral( "copy" ),
+                      m_settings.fileName } );
+    if ( ffmpeg.waitForFinished( -1 ) == false || ffmpeg.exitStatus() != QProcess::NormalExit ||
+         ffmpeg.exitCode() != 0 )
+    {
+        vlmcCritical() << "Failed to join the segments of" << m_settings.fileName
+                       << "; they are kept in" << partsDirectory();
+        return false;
+    }
+    QDir( partsDirectory() ).removeRecursively();
+    return true;
+}
+
+bool
+CheckpointedRender::run()
+{
+    const auto length = m_workflow->playableLength();
+    if ( length <= 0 )
+        return false;
+    const auto segmentLength = this->segmentLength();
+    // Don't render segments which couldn't be joined
+    if ( concatProgram().isEmpty() == true )
+        return false;
+    if ( QDir().mkpath( partsDirectory() ) == false )
+    {
+        vlmcCritical() << "Can't create" << partsDirectory();
+        return false;
+    }
+    loadManifest( length, segmentLength );
+
+    auto segments = CheckpointedRender::segments( length, segmentLength );
+    // All the segments are traced at once
+    Tracer::Session traceSession;
+    for ( const auto& segment : segments )
+    {
+        if ( isCompleted( segment ) == true )
+        {
+            vlmcDebug() << "Segment" << segment.index << "already rendered, skipping it";
+            continue;
+        }
+        auto settings = m_settings;
+        settings.fileName = segmentFileName( segment.index );
+        QFile::remove( settings.fileName );
+        if ( m_workflow->renderToFiles( { settings }, segment.begin, segment.end ) == false ||
+             markCompleted( segment ) == false )
+        {
+            vlmcCritical() << "Failed to render segment" << segment.index << "of" << m_settings.fileName;
+            return false;
+        }
+    }
+    return concat( segments.size() );
+}
@@ -0,0 +1,116 @@
+/*****************************************************************************
+ * CheckpointedRender.h: Render the workflow in resumable segments
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef CHECKPOINTEDRENDER_H
+#define CHECKPOINTEDRENDER_H
+
+#include "Workflow/Types.h"
+
+#include <QByteArray>
+#include <QJsonObject>
+#include <QList>
+#include <QString>
+
+class MainWorkflow;
+
+/**
+ *  \brief  Renders the timeline as fixed duration segments, then joins them.
+ *
+ *  Completed segments are recorded in a manifest stored next to the segments, in
+ *  "<output>.parts/". When a render is interrupted, running it again with the same
+ *  timeline and output settings only renders the missing segments.
+ *  Segments are joined without re-encoding, using ffmpeg's concat demuxer: the ffmpeg
+ *  program must be in the PATH, which run() checks before rendering anything.
+ */
+class CheckpointedRender
+{
+    public:
+        struct Segment
+        {
+            int         index;
+            qint64      begin;
+            qint64      end; ///< Included
+        };
+
+        /**
+         *  \param  segmentDuration     The duration of a segment, in seconds.
+         */
+        CheckpointedRender( MainWorkflow* workflow, const Workflow::OutputSettings& settings,
+                            double segmentDuration );
+
+        /**
+         *  \brief  Render the missing segments and join them into the output file.
+         *  \return true if the output file was written.
+         */
+        bool                run();
+
+        /**
+         *  \brief  Find the ffmpeg program used to join the segments.
+         *  \return Its path, or an empty string, after logging why, if it's missing.
+         */
+        static QString      concatProgram();
+
+        /**
+         *  \brief  Split the timeline into segments of segmentLength frames.
+         */
+        static QList<Segment>   segments( qint64 length, qint64 segmentLength );
+
+        QString             partsDirectory() const;
+        QString             segmentFileName( int index ) const;
+
+        /**
+         *  \brief  Identifies the timeline and the output settings.
+         *
+         *  Segments recorded under another hash are discarded.
+         */
+        QByteArray          hash() const;
+
+        /**
+         *  \brief  Record a successfully rendered segment in the manifest.
+         */
+        bool                markCompleted( const Segment& segment );
+        bool                isCompleted( const Segment& segment ) const;
+
+        /**
+         *  \brief  Load the manifest, discarding it if it doesn't match the timeline.
+         */
+        void                loadManifest( qint64 length, qint64 segmentLength );
+
+        /**
+         *  \brief  Join all segments into the output file and remove them.
+         */
+        bool                concat( int nbSegments );
+
+        qint64              segmentLength() const;
+
+    private:
+        bool                saveManifest() const;
+
+    private:
+        MainWorkflow*               m_workflow;
+        Workflow::OutputSettings    m_settings;
+        double                      m_segmentDuration;
+        QByteArray                  m_hash;
+        QJsonObject                 m_manifest;
+};
+
+#endif // CHECKPOINTEDRENDER_H
@@ -87,7 +87,7 @@ ClipRenderer::startPreview()
 
     m_input->setPosition( 0 );
     m_input->setPause( false );
-    m_output->start();
+    startOutput();
 
     m_clipLoaded = true;
     m_mediaChanged = false;
@@ -98,7 +98,7 @@ ClipRenderer::stop()
 {
     if ( m_clipLoaded == true && isRendering() == true )
     {
-        m_output->stop();
+        stopOutput();
         if ( m_mediaChanged == true )
             m_clipLoaded = false;
     }
@@ -117,7 +117,7 @@ ClipRenderer::togglePlayPause()
     }
     if ( m_output->isStopped() )
     {
-        m_output->start();
+        startOutput();
         m_input->setPause( false );
     }
     else
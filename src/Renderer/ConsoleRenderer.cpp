@@ -25,46 +25,140 @@
 #endif
 
 #include "ConsoleRenderer.h"
+#include "CheckpointedRender.h"
+#include "RenderProgress.h"
 #include "Main/Core.h"
 #include "Project/Project.h"
+#include "Tools/PerfCounters.h"
 #include "Tools/VlmcDebug.h"
 #include "Workflow/MainWorkflow.h"
 
-ConsoleRenderer::ConsoleRenderer( const QString& outputFileName, QObject *parent )
+#include <QTextStream>
+
+ConsoleRenderer::ConsoleRenderer( const QStringList& outputs, QObject *parent )
     : QObject( parent )
-    , m_outputFileName( outputFileName )
+    , m_outputs( outputs )
+    , m_segmentDuration( 0 )
+    , m_progress( nullptr )
+    , m_percent( 0 )
 {
     connect( Core::instance()->workflow(), &MainWorkflow::frameChanged,
              this, &ConsoleRenderer::frameChanged, Qt::DirectConnection );
 }
 
 void
-ConsoleRenderer::frameChanged( qint64 frame, qint64 length ) const
+ConsoleRenderer::frameChanged( qint64 frame, qint64 length )
 {
-    static qint64   percent = 0;
-    qint64          newPercent;
-
-    newPercent = ( frame + 1 ) * 100 / length; // The frame is 0-indexed
-    if ( newPercent != percent )
+    // The positions are coalesced by the renderer's event watcher, this isn't called for
+    // every frame.
+    if ( m_progress != nullptr )
+    {
+        m_progress->setFrame( frame );
+        return;
+    }
+    auto percent = ( frame + 1 ) * 100 / length; // The frame is 0-indexed
+    if ( percent != m_percent )
     {
-        percent = newPercent;
+        m_percent = percent;
         vlmcDebug() << "ConsoleRenderer:" << percent << "%";
     }
 }
 
+bool
+ConsoleRenderer::setProgressFd( int fd )
+{
+    m_progress = new RenderProgress( fd, this );
+    if ( m_progress->isValid() == true )
+        return true;
+    delete m_progress;
+    m_progress = nullptr;
+    return false;
+}
+
+void
+ConsoleRenderer::setSegmentDuration( double duration )
+{
+    m_segmentDuration = duration;
+}
+
+bool
+ConsoleRenderer::parseOutput( const QString& output, Workflow::OutputSettings& settings ) const
+{
+    auto fields = output.split( ',' );
+
+    settings = Core::instance()->project()->outputSettings( fields[0] );
+
+    if ( settings.fileName.isEmpty() == true || fields.size() > 3 )
+        return false;
+    if ( fields.size() >= 2 )
+    {
+        auto size = fields[1].split( 'x' );
+        bool okWidth = false;
+        bool okHeight = false;
+        if ( size.size() != 2 )
+            return false;
+        settings.width = size[0].toUInt( &okWidth );
+        settings.height = size[1].toUInt( &okHeight );
+        if ( okWidth == false || okHeight == false )
+            return false;
+    }
+    if ( fields.size() == 3 )
+    {
+        bool ok = false;
+        settings.videoBitrate = fields[2].toUInt( &ok );
+        if ( ok == false )
+            return false;
+    }
+    return true;
+}
+
 void
 ConsoleRenderer::startRender()
 {
-    auto project = Core::instance()->project();
-    Core::instance()->workflow()->startRenderToFile( m_outputFileName,
-                                                     project->width(),
-                                                     project->height(),
-                                                     project->fps(),
-                                                     project->aspectRatio(),
-                                                     project->videoBitrate(),
-                                                     project->audioBitrate(),
-                                                     project->nbChannels(),
-                                                     project->sampleRate()
-                                                     );
+    QList<Workflow::OutputSettings>     outputs;
+    for ( const auto& output : m_outputs )
+    {
+        Workflow::OutputSettings    settings;
+        if ( parseOutput( output, settings ) == false )
+        {
+            vlmcCritical() << "Invalid output:" << output;
+            emit finished();
+            return;
+        }
+        outputs << settings;
+    }
+    auto workflow = Core::instance()->workflow();
+    // The report below includes the compositing time
+    PerfCounters::setTimingEnabled( true );
+    const auto start = PerfCounters::snapshot();
+    if ( m_progress != nullptr )
+    {
+        m_progress->start( workflow->playableLength(), outputs.first().fps );
+        connect( workflow, &MainWorkflow::renderStarted, m_progress, &RenderProgress::passStarted );
+    }
+    bool res = true;
+    if ( m_segmentDuration > 0 )
+    {
+        // Segments are checkpointed per output, so each of them gets its own pass.
+        for ( const auto& settings : outputs )
+        {
+            CheckpointedRender render( workflow, settings, m_segmentDuration );
+            res = render.run();
+            if ( res == false )
+                break;
+        }
+    }
+    else
+    {
+        // Runs an event loop, unlike startRenderToFiles(), so progress can be reported
+        res = workflow->canRender() == true &&
+                workflow->renderToFiles( outputs, 0, workflow->playableLength() - 1 );
+    }
+    if ( m_progress != nullptr )
+        m_progress->finish( res );
+    // Averaged over the whole render, so that slow renders can be reported with numbers
+    QTextStream( stderr ) << "Render statistics:\n"
+                          << PerfCounters::report( start, PerfCounters::snapshot() ) << '\n';
+    PerfCounters::setTimingEnabled( false );
     emit finished();
 }
@@ -25,21 +25,49 @@
 
 #include <QObject>
 #include <QString>
+#include <QStringList>
+
+#include "Workflow/Types.h"
+
+class RenderProgress;
 
 class ConsoleRenderer : public QObject
 {
     Q_OBJECT
 
 public:
-    explicit ConsoleRenderer( const QString& outputFileName, QObject *parent = 0 );
+    /**
+     *  \param outputs  The files to render to, as "filename[,WIDTHxHEIGHT[,VIDEOBITRATE]]"
+     *                  Unspecified values are taken from the project.
+     */
+    explicit ConsoleRenderer( const QStringList& outputs, QObject *parent = 0 );
+
+    /**
+     *  \brief Render in resumable segments of \p duration seconds.
+     *
+     *  An interrupted render started again with the same project and outputs resumes
+     *  from its last complete segment. 0 disables checkpointing, which is the default.
+     */
+    void        setSegmentDuration( double duration );
+
+    /**
+     *  \brief Report the progress as JSON lines on the file descriptor \p fd
+     *
+     *  See RenderProgress for the format. By default, only a percentage is logged.
+     */
+    bool        setProgressFd( int fd );
 
     void        startRender();
 
 private:
-    void        frameChanged( qint64 frame, qint64 length ) const;
+    void        frameChanged( qint64 frame, qint64 length );
+    bool        parseOutput( const QString& output, Workflow::OutputSettings& settings ) const;
 
 private:
-    QString                 m_outputFileName;
+    QStringList             m_outputs;
+    double                  m_segmentDuration;
+    RenderProgress*         m_progress;
+    qint64                  m_percent;
 
 signals:
     void        finished();
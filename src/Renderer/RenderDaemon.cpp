@@ -0,0 +1,269 @@
+/*****************************************************************************
+ * RenderDaemon.cpp: Long running headless render service
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "RenderDaemon.h"
+#include "Tools/VlmcDebug.h"
+
+#include <QCoreApplication>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QProcess>
+
+RenderDaemon::RenderDaemon( const QString& serverName, int maxJobs, QObject* parent )
+    : QObject( parent )
+    , m_serverName( serverName )
+    , m_maxJobs( qMax( 1, maxJobs ) )
+    , m_server( new QLocalServer( this ) )
+    , m_lastJobId( 0 )
+{
+    connect( m_server, &QLocalServer::newConnection, this, &RenderDaemon::newConnection );
+}
+
+RenderDaemon::~RenderDaemon()
+{
+    for ( auto w : m_workers )
+    {
+        w->process->disconnect( this );
+        w->process->terminate();
+        w->process->waitForFinished();
+        delete w->job;
+        delete w;
+    }
+    qDeleteAll( m_queue );
+}
+
+void
+RenderDaemon::setWorkerArguments( const QStringList& arguments )
+{
+    m_workerArguments = arguments;
+}
+
+bool
+RenderDaemon::listen()
+{
+    // A previous daemon may have left its socket behind
+    QLocalServer::removeServer( m_serverName );
+    m_server->setSocketOptions( QLocalServer::UserAccessOption );
+    if ( m_server->listen( m_serverName ) == false )
+    {
+        vlmcCritical() << "Can't listen on" << m_serverName << ':' << m_server->errorString();
+        return false;
+    }
+    vlmcDebug() << "Render daemon listening on" << m_server->fullServerName()
+                << "with up to" << m_maxJobs << "concurrent jobs";
+    return true;
+}
+
+void
+RenderDaemon::send( QLocalSocket* socket, const QJsonObject& message )
+{
+    if ( socket == nullptr || socket->state() != QLocalSocket::ConnectedState )
+        return;
+    socket->write( QJsonDocument( message ).toJson( QJsonDocument::Compact ) + '\n' );
+}
+
+void
+RenderDaemon::newConnection()
+{
+    while ( m_server->hasPendingConnections() == true )
+    {
+        auto socket = m_server->nextPendingConnection();
+        connect( socket, &QLocalSocket::readyRead, this, [this, socket]{ readMessages( socket ); } );
+        connect( socket, &QLocalSocket::disconnected, this, [this, socket]{ socketDisconnected( socket ); } );
+    }
+}
+
+void
+RenderDaemon::socketDisconnected( QLocalSocket* socket )
+{
+    auto it = m_workerSockets.find( socket );
+    if ( it != m_workerSockets.end() )
+    {
+        // A worker which can't be reached anymore is of no use, workerFinished() will
+        // report its job as failed.
+        auto w = it.value();
+        w->socket = nullptr;
+        m_workerSockets.erase( it );
+        w->process->terminate();
+    }
+    socket->deleteLater();
+}
+
+void
+RenderDaemon::readMessages( QLocalSocket* socket )
+{
+    while ( socket->canReadLine() == true )
+    {
+        QJsonParseError error;
+        auto doc = QJsonDocument::fromJson( socket->readLine(), &error );
+        if ( doc.isObject() == false )
+        {
+            send( socket, { { "type", "error" }, { "error", error.errorString() } } );
+            continue;
+        }
+        auto message = doc.object();
+        auto it = m_workerSockets.find( socket );
+        if ( it != m_workerSockets.end() )
+            handleWorkerMessage( it.value(), message );
+        else
+            handleClientMessage( socket, message );
+    }
+}
+
+void
+RenderDaemon::handleClientMessage( QLocalSocket* socket, const QJsonObject& message )
+{
+    auto type = message["type"].toString();
+    if ( type == QStringLiteral( "hello" ) )
+    {
+        // A worker we spawned is connecting back
+        auto pid = message["pid"].toVariant().toLongLong();
+        for ( auto w : m_workers )
+        {
+            if ( w->socket != nullptr || w->process->processId() != pid )
+                continue;
+            w->socket = socket;
+            m_workerSockets[socket] = w;
+            dispatch();
+            return;
+        }
+        socket->disconnectFromServer();
+    }
+    else if ( type == QStringLiteral( "submit" ) )
+    {
+        auto job = new Job{ ++m_lastJobId, message, socket };
+        // Forwarded as is to the worker, which only handles "job" messages
+        job->description["type"] = QStringLiteral( "job" );
+        job->description["job"] = job->id;
+        m_queue.enqueue( job );
+        send( socket, { { "type", "accepted" }, { "job", job->id } } );
+        dispatch();
+    }
+    else if ( type == QStringLiteral( "status" ) )
+        send( socket, status() );
+    else
+        send( socket, { { "type", "error" }, { "error", "Unknown request: " + type } } );
+}
+
+void
+RenderDaemon::handleWorkerMessage( Worker* worker, const QJsonObject& message )
+{
+    if ( worker->job == nullptr )
+        return;
+    auto type = message["type"].toString();
+    if ( type == QStringLiteral( "progress" ) )
+        send( worker->job->client, message );
+    else if ( type == QStringLiteral( "result" ) )
+        finishJob( worker, message );
+}
+
+void
+RenderDaemon::finishJob( Worker* worker, const QJsonObject& result )
+{
+    send( worker->job->client, result );
+    vlmcDebug() << "Job" << worker->job->id << ( result["success"].toBool() ? "succeeded" : "failed" );
+    delete worker->job;
+    worker->job = nullptr;
+    dispatch();
+}
+
+void
+RenderDaemon::spawnWorker()
+{
+    auto w = new Worker{ new QProcess( this ), nullptr, nullptr };
+    w->process->setProcessChannelMode( QProcess::ForwardedChannels );
+    connect( w->process, static_cast<void(QProcess::*)(int, QProcess::ExitStatus)>( &QProcess::finished ),
+             this, [this, w]{ workerFinished( w->process ); } );
+    m_workers << w;
+    w->process->start( QCoreApplication::applicationFilePath(), QStringList( m_workerArguments ) << m_serverName );
+}
+
+void
+RenderDaemon::workerFinished( QProcess* process )
+{
+    for ( int i = 0; i < m_workers.size(); ++i )
+    {
+        auto w = m_workers[i];
+        if ( w->process != process )
+            continue;
+        vlmcWarning() << "Render worker" << process->processId() << "exited";
+        if ( w->job != nullptr )
+        {
+            send( w->job->client, { { "type", "result" }, { "job", w->job->id }, { "success", false },
+                                    { "error", "The render worker exited unexpectedly" } } );
+            delete w->job;
+        }
+        if ( w->socket != nullptr )
+            m_workerSockets.remove( w->socket );
+        m_workers.removeAt( i );
+        process->deleteLater();
+        delete w;
+        break;
+    }
+    dispatch();
+}
+
+void
+RenderDaemon::dispatch()
+{
+    for ( auto w : m_workers )
+    {
+        if ( m_queue.isEmpty() == true )
+            return;
+        if ( w->socket == nullptr || w->job != nullptr )
+            continue;
+        w->job = m_queue.dequeue();
+        send( w->socket, QJsonObject( w->job->description ) );
+    }
+    // Workers are only spawned once they're needed, and kept afterward.
+    auto pending = m_queue.size();
+    for ( auto w : m_workers )
+        if ( w->socket == nullptr )
+            --pending;
+    while ( pending-- > 0 && m_workers.size() < m_maxJobs )
+        spawnWorker();
+}
+
+QJsonObject
+RenderDaemon::status() const
+{
+    QJsonArray  running;
+    QJsonArray  queued;
+    for ( auto w : m_workers )
+        if ( w->job != nullptr )
+            running.append( QJsonObject{ { "job", w->job->id }, { "project", w->job->description["project"] } } );
+    for ( auto j : m_queue )
+        queued.append( QJsonObject{ { "job", j->id }, { "project", j->description["project"] } } );
+    return {
+        { "type", "status" },
+        { "workers", m_workers.size() },
+        { "maxJobs", m_maxJobs },
+        { "running", running },
+        { "queued", queued },
+    };
+}
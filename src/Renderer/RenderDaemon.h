@@ -0,0 +1,108 @@
+/*****************************************************************************
+ * RenderDaemon.h: Long running headless render service
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef RENDERDAEMON_H
+#define RENDERDAEMON_H
+
+#include <QHash>
+#include <QJsonObject>
+#include <QList>
+#include <QObject>
+#include <QPointer>
+#include <QQueue>
+#include <QString>
+#include <QStringList>
+
+class QLocalServer;
+class QLocalSocket;
+class QProcess;
+
+/**
+ *  \brief  Accepts render jobs over a local socket and runs them on warm workers.
+ *
+ *  The daemon itself doesn't load anything. It spawns up to maxJobs worker processes
+ *  (see RenderWorker) which keep the backend and their last project loaded between
+ *  jobs, and dispatches the queued jobs to the idle ones.
+ *
+ *  Clients send JSON objects, one per line:
+ *  - { "type": "submit", ... } queues a job. The other keys are the ones described in
+ *    RenderWorker. The daemon answers with { "type": "accepted", "job": id }, then
+ *    forwards the worker's "progress" and "result" messages for this job.
+ *  - { "type": "status" } returns the queued and running jobs.
+ */
+class RenderDaemon : public QObject
+{
+    Q_OBJECT
+
+    public:
+        RenderDaemon( const QString& serverName, int maxJobs, QObject* parent = nullptr );
+        ~RenderDaemon();
+
+        bool                listen();
+
+        /**
+         *  \brief  Arguments used to start the worker processes.
+         *
+         *  The server name is appended to them.
+         */
+        void                setWorkerArguments( const QStringList& arguments );
+
+    private:
+        struct Job
+        {
+            int                     id;
+            QJsonObject             description;
+            QPointer<QLocalSocket>  client;
+        };
+
+        struct Worker
+        {
+            QProcess*               process;
+            QLocalSocket*           socket;
+            Job*                    job;
+        };
+
+        void                newConnection();
+        void                readMessages( QLocalSocket* socket );
+        void                socketDisconnected( QLocalSocket* socket );
+        void                handleClientMessage( QLocalSocket* socket, const QJsonObject& message );
+        void                handleWorkerMessage( Worker* worker, const QJsonObject& message );
+        void                spawnWorker();
+        void                workerFinished( QProcess* process );
+        void                dispatch();
+        void                finishJob( Worker* worker, const QJsonObject& result );
+        QJsonObject         status() const;
+
+        static void         send( QLocalSocket* socket, const QJsonObject& message );
+
+    private:
+        QString                         m_serverName;
+        int                             m_maxJobs;
+        QStringList                     m_workerArguments;
+        QLocalServer*                   m_server;
+        int                             m_lastJobId;
+        QQueue<Job*>                    m_queue;
+        QList<Worker*>                  m_workers;
+        QHash<QLocalSocket*, Worker*>   m_workerSockets;
+};
+
+#endif // RENDERDAEMON_H
@@ -0,0 +1,404 @@
+/*****************************************************************************
+ * RenderFarmCoordinator.cpp: Distributes an export over several render nodes
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "RenderFarmCoordinator.h"
+#include "Settings/BinarySettings.h"
+#include "Tools/VlmcDebug.h"
+#include "Workflow/MainWorkflow.h"
+
+#include <QDir>
+#include <QFileInfo>
+#include <QHostAddress>
+#include <QJsonDocument>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTimer>
+
+// A segment failing this many times is considered impossible to render.
+static const int        MaxAttempts = 3;
+// Workers report their progress every few seconds while rendering.
+static const qint64     WorkerTimeout = 60000;
+
+RenderFarmCoordinator::RenderFarmCoordinator( MainWorkflow* workflow, const QString& projectFile,
+                                              const Workflow::OutputSettings& settings,
+                                              double segmentDuration, const QString& token,
+                                              QObject* parent )
+    : QObject( parent )
+    , m_workflow( workflow )
+    , m_settings( settings )
+    , m_token( token.toUtf8() )
+    , m_render( workflow, settings, segmentDuration )
+    , m_server( new QTcpServer( this ) )
+    , m_watchdog( new QTimer( this ) )
+    , m_nbCompleted( 0 )
+    , m_finished( false )
+{
+    // Workers always receive JSON, whatever the format of the project
+    QFile   file( projectFile );
+    if ( file.open( QFile::ReadOnly ) == true )
+    {
+        if ( BinarySettings::isBinary( &file ) == true )
+            m_project = BinarySettings::toJson( &file );
+        else
+            m_project = QJsonDocument::fromJson( file.readAll() ).object();
+    }
+
+    const auto length = workflow->playableLength();
+    const auto segmentLength = m_render.segmentLength();
+    m_segments = CheckpointedRender::segments( length, segmentLength );
+    if ( QDir().mkpath( m_render.partsDirectory() ) == true )
+        m_render.loadManifest( length, segmentLength );
+    for ( const auto& s : m_segments )
+    {
+        if ( m_render.isCompleted( s ) == true )
+            ++m_nbCompleted;
+        else
+            m_pending.enqueue( s.index );
+    }
+
+    connect( m_server, &QTcpServer::newConnection, this, &RenderFarmCoordinator::newConnection );
+    connect( m_watchdog, &QTimer::timeout, this, &RenderFarmCoordinator::checkWorkers );
+}
+
+RenderFarmCoordinator::~RenderFarmCoordinator()
+{
+    for ( auto w : m_workers )
+    {
+        w->socket->disconnect( this );
+        delete w;
+    }
+}
+
+bool
+RenderFarmCoordinator::listen( const QHostAddress& address, quint16 port )
+{
+    if ( m_token.isEmpty() == true )
+    {
+        vlmcCritical() << "The render farm needs a token";
+        return false;
+    }
+    if ( m_project.isEmpty() == true )
+    {
+        vlmcCritical() << "Can't read the project file";
+        return false;
+    }
+    if ( m_segments.isEmpty() == true )
+    {
+        vlmcCritical() << "Nothing to render";
+        return false;
+    }
+    if ( CheckpointedRender::concatProgram().isEmpty() == true )
+        return false;
+    if ( m_server->listen( address, port ) == false )
+    {
+        vlmcCritical() << "Can't listen on" << address.toString() << "port" << port << ':'
+                       << m_server->errorString();
+        return false;
+    }
+    vlmcDebug() << "Render farm coordinator listening on" << address.toString() << "port"
+                << m_server->serverPort() << ':'
+                << m_pending.size() << "segments out of" << m_segments.size() << "to render";
+    m_watchdog->start( 5000 );
+    if ( m_pending.isEmpty() == true )
+        QTimer::singleShot( 0, this, [this]{ finish( true ); } );
+    return true;
+}
+
+void
+RenderFarmCoordinator::send( QTcpSocket* socket, const QJsonObject& message )
+{
+    socket->write( QJsonDocument( message ).toJson( QJsonDocument::Compact ) + '\n' );
+}
+
+// Takes the same time wherever the tokens differ
+bool
+RenderFarmCoordinator::sameToken( const QByteArray& a, const QByteArray& b )
+{
+    const auto ha = QCryptographicHash::hash( a, QCryptographicHash::Sha256 );
+    const auto hb = QCryptographicHash::hash( b, QCryptographicHash::Sha256 );
+    char diff = 0;
+    for ( int i = 0; i < ha.size(); ++i )
+        diff |= ha[i] ^ hb[i];
+    return diff == 0;
+}
+
+void
+RenderFarmCoordinator::newConnection()
+{
+    while ( m_server->hasPendingConnections() == true )
+    {
+        auto w = new Worker;
+        w->socket = m_server->nextPendingConnection();
+        w->name = w->socket->peerAddress().toString() + ':' + QString::number( w->socket->peerPort() );
+        w->authenticated = false;
+        w->ready = false;
+        w->segment = -1;
+        w->remaining = 0;
+        w->lastMessage.start();
+        m_workers << w;
+        connect( w->socket, &QTcpSocket::readyRead, this, [this, w]{ readMessages( w ); } );
+        connect( w->socket, &QTcpSocket::disconnected, this, [this, w]{ workerDisconnected( w ); } );
+    }
+}
+
+void
+RenderFarmCoordinator::readMessages( Worker* worker )
+{
+    worker->lastMessage.restart();
+    while ( m_finished == false )
+    {
+        if ( worker->remaining > 0 )
+        {
+            receiveSegmentData( worker );
+            if ( worker->remaining > 0 )
+                return;
+            continue;
+        }
+        if ( worker->socket->canReadLine() == false )
+            return;
+        auto message = QJsonDocument::fromJson( worker->socket->readLine() ).object();
+        handleMessage( worker, message );
+        // Handling the message may have closed the connection
+        if ( m_workers.contains( worker ) == false )
+            return;
+    }
+}
+
+void
+RenderFarmCoordinator::handleMessage( Worker* worker, const QJsonObject& message )
+{
+    auto type = message["type"].toString();
+    if ( worker->authenticated == false )
+    {
+        if ( type != QStringLiteral( "hello" ) ||
+             sameToken( message["token"].toString().toUtf8(), m_token ) == false )
+        {
+            vlmcWarning() << "Rejecting" << worker->name << ": wrong render farm token";
+            worker->socket->abort();
+            // abort() may not emit disconnected() for a socket which already lost its peer
+            if ( m_workers.contains( worker ) == true )
+                workerDisconnected( worker );
+            return;
+        }
+        worker->authenticated = true;
+        worker->name = message["name"].toString() + '@' + worker->name;
+        vlmcDebug() << "Render node" << worker->name << "connected";
+        send( worker->socket, {
+            { "type", "project" },
+            { "project", m_project },
+            { "length", m_workflow->playableLength() },
+            { "output", QJsonObject{
+                  // Only the extension matters, the worker picks its own file name
+                  { "fileName", QFileInfo( m_settings.fileName ).fileName() },
+                  { "width", static_cast<int>( m_settings.width ) },
+                  { "height", static_cast<int>( m_settings.height ) },
+                  { "fps", m_settings.fps },
+                  { "aspectRatio", m_settings.aspectRatio },
+                  { "videoBitrate", static_cast<int>( m_settings.videoBitrate ) },
+                  { "audioBitrate", static_cast<int>( m_settings.audioBitrate ) },
+                  { "nbChannels", static_cast<int>( m_settings.nbChannels ) },
+                  { "sampleRate", static_cast<int>( m_settings.sampleRate ) },
+              } },
+        } );
+    }
+    else if ( type == QStringLiteral( "ready" ) )
+    {
+        worker->ready = true;
+        dispatch();
+    }
+    else if ( type == QStringLiteral( "error" ) )
+    {
+        vlmcWarning() << "Render node" << worker->name << "can't render this project:"
+                      << message["error"].toString();
+        worker->socket->disconnectFromHost();
+    }
+    else if ( type == QStringLiteral( "failed" ) && worker->segment >= 0 )
+    {
+        auto index = worker->segment;
+        worker->segment = -1;
+        segmentFailed( index, worker->name + ": " + message["error"].toString() );
+        dispatch();
+    }
+    else if ( type == QStringLiteral( "segment" ) && worker->segment >= 0 )
+    {
+        worker->remaining = message["size"].toVariant().toLongLong();
+        worker->expectedHash = message["sha1"].toString().toLatin1();
+        worker->hash.reset( new QCryptographicHash( QCryptographicHash::Sha1 ) );
+        worker->file.reset( new QFile( m_render.segmentFileName( worker->segment ) + ".part" ) );
+        if ( worker->file->open( QFile::WriteOnly | QFile::Truncate ) == false )
+        {
+            vlmcCritical() << "Can't write" << worker->file->fileName();
+            finish( false );
+            return;
+        }
+        if ( worker->remaining <= 0 )
+            segmentReceived( worker );
+    }
+}
+
+void
+RenderFarmCoordinator::receiveSegmentData( Worker* worker )
+{
+    auto data = worker->socket->read( qMin( worker->remaining, worker->socket->bytesAvailable() ) );
+    if ( data.isEmpty() == true )
+        return;
+    worker->remaining -= data.size();
+    worker->hash->addData( data );
+    if ( worker->file->write( data ) != data.size() )
+    {
+        vlmcCritical() << "Can't write" << worker->file->fileName() << ':' << worker->file->errorString();
+        worker->file->close();
+        worker->file->remove();
+        worker->file.reset();
+        finish( false );
+        return;
+    }
+    if ( worker->remaining == 0 )
+        segmentReceived( worker );
+}
+
+void
+RenderFarmCoordinator::segmentReceived( Worker* worker )
+{
+    const auto index = worker->segment;
+    const auto partFileName = worker->file->fileName();
+    worker->segment = -1;
+    worker->remaining = 0;
+    bool written = worker->file->flush();
+    worker->file.reset();
+    if ( written == false || worker->hash->result().toHex() != worker->expectedHash )
+    {
+        QFile::remove( partFileName );
+        segmentFailed( index, worker->name + ": corrupted upload" );
+        dispatch();
+        return;
+    }
+    const auto fileName = m_render.segmentFileName( index );
+    QFile::remove( fileName );
+    if ( QFile::rename( partFileName, fileName ) == false ||
+         m_render.markCompleted( m_segments[index] ) == false )
+    {
+        vlmcCritical() << "Can't store segment" << index << "in" << m_render.partsDirectory();
+        finish( false );
+        return;
+    }
+    ++m_nbCompleted;
+    vlmcDebug() << "Segment" << index << "rendered by" << worker->name << '(' << m_nbCompleted
+                << '/' << m_segments.size() << ')';
+    if ( m_nbCompleted == m_segments.size() )
+        finish( true );
+    else
+        dispatch();
+}
+
+void
+RenderFarmCoordinator::segmentFailed( int index, const QString& reason )
+{
+    vlmcWarning() << "Segment" << index << "failed:" << reason;
+    if ( ++m_attempts[index] >= MaxAttempts )
+    {
+        vlmcCritical() << "Giving up on segment" << index << "after" << MaxAttempts << "attempts";
+        finish( false );
+        return;
+    }
+    m_pending.enqueue( index );
+}
+
+void
+RenderFarmCoordinator::workerDisconnected( Worker* worker )
+{
+    vlmcDebug() << "Render node" << worker->name << "disconnected";
+    m_workers.removeOne( worker );
+    worker->socket->disconnect( this );
+    worker->socket->deleteLater();
+    if ( worker->file != nullptr )
+    {
+        worker->file->close();
+        worker->file->remove();
+    }
+    auto index = worker->segment;
+    delete worker;
+    if ( index >= 0 && m_finished == false )
+    {
+        segmentFailed( index, QStringLiteral( "the render node disconnected" ) );
+        dispatch();
+    }
+}
+
+void
+RenderFarmCoordinator::checkWorkers()
+{
+    for ( auto w : QList<Worker*>( m_workers ) )
+    {
+        if ( w->segment < 0 || w->lastMessage.elapsed() < WorkerTimeout )
+            continue;
+        vlmcWarning() << "Render node" << w->name << "stopped responding";
+        w->socket->abort();
+        // abort() may not emit disconnected() for a socket which already lost its peer
+        if ( m_workers.contains( w ) == true )
+            workerDisconnected( w );
+    }
+}
+
+void
+RenderFarmCoordinator::dispatch()
+{
+    if ( m_finished == true )
+        return;
+    for ( auto w : m_workers )
+    {
+        if ( m_pending.isEmpty() == true )
+            return;
+        if ( w->ready == false || w->segment >= 0 )
+            continue;
+        w->segment = m_pending.dequeue();
+        w->lastMessage.restart();
+        const auto& s = m_segments[w->segment];
+        send( w->socket, { { "type", "render" }, { "index", s.index }, { "begin", s.begin },
+                           { "end", s.end } } );
+    }
+}
+
+void
+RenderFarmCoordinator::finish( bool success )
+{
+    if ( m_finished == true )
+        return;
+    m_finished = true;
+    m_watchdog->stop();
+    for ( auto w : m_workers )
+        send( w->socket, { { "type", "done" } } );
+    if ( success == true )
+    {
+        success = m_render.concat( m_segments.size() ) == true &&
+                QFileInfo( m_settings.fileName ).size() > 0;
+    }
+    if ( success == true )
+        vlmcDebug() << "Render farm wrote" << m_settings.fileName;
+    else
+        vlmcCritical() << "Render farm failed to render" << m_settings.fileName;
+    emit finished( success );
+}
@@ -0,0 +1,123 @@
+/*****************************************************************************
+ * RenderFarmCoordinator.h: Distributes an export over several render nodes
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef RENDERFARMCOORDINATOR_H
+#define RENDERFARMCOORDINATOR_H
+
+#include <QByteArray>
+#include <QCryptographicHash>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QHash>
+#include <QJsonObject>
+#include <QList>
+#include <QObject>
+#include <QQueue>
+
+#include <memory>
+
+#include "CheckpointedRender.h"
+
+class MainWorkflow;
+class QHostAddress;
+class QTcpServer;
+class QTcpSocket;
+class QTimer;
+
+/**
+ *  \brief  Splits an export in segments, and has them rendered by RenderFarmWorker nodes.
+ *
+ *  The segments are the ones of a CheckpointedRender, and are recorded in the same
+ *  manifest: an interrupted farm render can be resumed, by the farm or locally.
+ *  Each worker receives the project file and the output settings when it connects,
+ *  then renders the segments it's assigned one at a time and uploads them back.
+ *  Uploaded segments are checked against their size and SHA-1 before being accepted.
+ *  The segments of a worker which disconnects, fails, or stops reporting its progress
+ *  are assigned to another worker.
+ *
+ *  Messages are JSON objects, one per line. A "segment" message is followed by "size"
+ *  bytes of segment data. The first message of a worker must be a "hello" holding the
+ *  token shared by the farm: the project and the media locations are only sent to
+ *  the workers which know it.
+ */
+class RenderFarmCoordinator : public QObject
+{
+    Q_OBJECT
+
+    public:
+        RenderFarmCoordinator( MainWorkflow* workflow, const QString& projectFile,
+                               const Workflow::OutputSettings& settings, double segmentDuration,
+                               const QString& token, QObject* parent = nullptr );
+        ~RenderFarmCoordinator();
+
+        bool                listen( const QHostAddress& address, quint16 port );
+
+    signals:
+        void                finished( bool success );
+
+    private:
+        struct Worker
+        {
+            QTcpSocket*                         socket;
+            QString                             name;
+            bool                                authenticated;
+            bool                                ready;
+            int                                 segment;
+            QElapsedTimer                       lastMessage;
+            // Segment being uploaded
+            qint64                              remaining;
+            QByteArray                          expectedHash;
+            std::unique_ptr<QFile>              file;
+            std::unique_ptr<QCryptographicHash> hash;
+        };
+
+        void                newConnection();
+        void                readMessages( Worker* worker );
+        void                handleMessage( Worker* worker, const QJsonObject& message );
+        void                receiveSegmentData( Worker* worker );
+        void                segmentReceived( Worker* worker );
+        void                segmentFailed( int index, const QString& reason );
+        void                workerDisconnected( Worker* worker );
+        void                checkWorkers();
+        void                dispatch();
+        void                finish( bool success );
+
+        static void         send( QTcpSocket* socket, const QJsonObject& message );
+        static bool         sameToken( const QByteArray& a, const QByteArray& b );
+
+    private:
+        MainWorkflow*                       m_workflow;
+        Workflow::OutputSettings            m_settings;
+        QByteArray                          m_token;
+        CheckpointedRender                  m_render;
+        QJsonObject                         m_project;
+        QTcpServer*                         m_server;
+        QTimer*                             m_watchdog;
+        QList<CheckpointedRender::Segment>  m_segments;
+        QQueue<int>                         m_pending;
+        QHash<int, int>                     m_attempts;
+        int                                 m_nbCompleted;
+        QList<Worker*>                      m_workers;
+        bool                                m_finished;
+};
+
+#endif // RENDERFARMCOORDINATOR_H
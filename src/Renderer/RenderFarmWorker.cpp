@@ -0,0 +1,237 @@
+/*****************************************************************************
+ * RenderFarmWorker.cpp: Renders segments for a render farm coordinator
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "RenderFarmWorker.h"
+#include "RenderWorker.h"
+#include "Main/Core.h"
+#include "Project/Project.h"
+#include "Tools/VlmcDebug.h"
+#include "Workflow/MainWorkflow.h"
+
+#include <QCoreApplication>
+#include <QCryptographicHash>
+#include <QFile>
+#include <QFileInfo>
+#include <QHostInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QTcpSocket>
+#include <QTimer>
+#include <QUrl>
+
+RenderFarmWorker::RenderFarmWorker( const QString& host, quint16 port,
+                                    const QList<QPair<QString, QString>>& pathMapping,
+                                    const QString& token, QObject* parent )
+    : QObject( parent )
+    , m_host( host )
+    , m_port( port )
+    , m_token( token )
+    , m_socket( new QTcpSocket( this ) )
+    , m_busy( false )
+    , m_currentFrame( 0 )
+{
+    // Mapping is done on media library locations, which are encoded URLs
+    for ( const auto& p : pathMapping )
+    {
+        auto toMrl = []( const QString& path ) {
+            if ( path.contains( QStringLiteral( "://" ) ) == true )
+                return path;
+            return QUrl::fromLocalFile( path ).toString( QUrl::FullyEncoded );
+        };
+        m_pathMapping << qMakePair( toMrl( p.first ), toMrl( p.second ) );
+    }
+    connect( m_socket, &QTcpSocket::readyRead, this, &RenderFarmWorker::readMessages );
+    connect( m_socket, &QTcpSocket::disconnected, qApp, &QCoreApplication::quit, Qt::QueuedConnection );
+    connect( Core::instance()->workflow(), &MainWorkflow::frameChanged, this, [this]( qint64 frame ) {
+        m_currentFrame.store( frame, std::memory_order_relaxed );
+    }, Qt::DirectConnection );
+}
+
+bool
+RenderFarmWorker::connectToCoordinator()
+{
+    if ( m_tempDir.isValid() == false )
+    {
+        vlmcCritical() << "Can't create a temporary directory";
+        return false;
+    }
+    m_socket->connectToHost( m_host, m_port );
+    if ( m_socket->waitForConnected() == false )
+    {
+        vlmcCritical() << "Can't connect to the render farm coordinator:" << m_socket->errorString();
+        return false;
+    }
+    send( { { "type", "hello" }, { "name", QHostInfo::localHostName() }, { "token", m_token } } );
+    return true;
+}
+
+void
+RenderFarmWorker::send( const QJsonObject& message )
+{
+    m_socket->write( QJsonDocument( message ).toJson( QJsonDocument::Compact ) + '\n' );
+    m_socket->flush();
+}
+
+void
+RenderFarmWorker::mapPaths( QJsonObject& project, const QList<QPair<QString, QString>>& pathMapping )
+{
+    auto library = project["Library"].toObject();
+    auto medias = library["medias"].toArray();
+    for ( int i = 0; i < medias.size(); ++i )
+    {
+        auto media = medias[i].toObject();
+        auto mrl = media["mrl"].toString();
+        for ( const auto& p : pathMapping )
+        {
+            if ( mrl.startsWith( p.first ) == false )
+                continue;
+            media["mrl"] = p.second + mrl.mid( p.first.length() );
+            medias[i] = media;
+            break;
+        }
+    }
+    library["medias"] = medias;
+    project["Library"] = library;
+}
+
+void
+RenderFarmWorker::readMessages()
+{
+    // Rendering runs a nested event loop, the next message waits for it to complete.
+    if ( m_busy == true )
+        return;
+    while ( m_socket->canReadLine() == true )
+    {
+        auto message = QJsonDocument::fromJson( m_socket->readLine() ).object();
+        auto type = message["type"].toString();
+        m_busy = true;
+        if ( type == QStringLiteral( "project" ) )
+            loadProject( message );
+        else if ( type == QStringLiteral( "render" ) )
+            renderSegment( message["index"].toInt(), message["begin"].toVariant().toLongLong(),
+                           message["end"].toVariant().toLongLong() );
+        else if ( type == QStringLiteral( "done" ) )
+            m_socket->disconnectFromHost();
+        m_busy = false;
+    }
+}
+
+void
+RenderFarmWorker::loadProject( const QJsonObject& message )
+{
+    auto project = message["project"].toObject();
+    mapPaths( project, m_pathMapping );
+
+    QFile   file( m_tempDir.path() + QStringLiteral( "/project.vlmc" ) );
+    if ( file.open( QFile::WriteOnly | QFile::Truncate ) == false )
+    {
+        send( { { "type", "error" }, { "error", "Can't write " + file.fileName() } } );
+        return;
+    }
+    file.write( QJsonDocument( project ).toJson( QJsonDocument::Compact ) );
+    file.close();
+
+    if ( Core::instance()->project()->load( file.fileName() ) == false )
+    {
+        send( { { "type", "error" }, { "error", "Failed to load the project" } } );
+        return;
+    }
+    // A missing or different media would silently change the timeline
+    auto length = message["length"].toVariant().toLongLong();
+    if ( Core::instance()->workflow()->playableLength() != length )
+    {
+        send( { { "type", "error" }, { "error", "The timeline doesn't match the coordinator's one. "
+                                                "Check the path mapping and the media library folders." } } );
+        return;
+    }
+    if ( RenderWorker::parseOutput( message["output"].toObject(), m_settings ) == false )
+    {
+        send( { { "type", "error" }, { "error", "Invalid output description" } } );
+        return;
+    }
+    send( { { "type", "ready" } } );
+}
+
+void
+RenderFarmWorker::renderSegment( int index, qint64 begin, qint64 end )
+{
+    auto settings = m_settings;
+    auto suffix = QFileInfo( m_settings.fileName ).suffix();
+    settings.fileName = m_tempDir.path() + QStringLiteral( "/segment-%1" ).arg( index );
+    if ( suffix.isEmpty() == false )
+        settings.fileName += '.' + suffix;
+
+    // Keep the coordinator aware that this node is still alive
+    m_currentFrame = begin;
+    QTimer      progressTimer;
+    connect( &progressTimer, &QTimer::timeout, this, [this, index] {
+        send( { { "type", "progress" }, { "index", index },
+                { "frame", m_currentFrame.load( std::memory_order_relaxed ) } } );
+    } );
+    progressTimer.start( 2000 );
+    auto res = Core::instance()->workflow()->renderToFiles( { settings }, begin, end );
+    progressTimer.stop();
+
+    if ( res == false || uploadSegment( index, settings.fileName ) == false )
+        send( { { "type", "failed" }, { "index", index }, { "error", "Failed to render the segment" } } );
+    QFile::remove( settings.fileName );
+}
+
+/**
+ *  Returns false if the segment couldn't be sent at all. Once the upload started,
+ *  failures close the connection and let the coordinator reassign the segment.
+ */
+bool
+RenderFarmWorker::uploadSegment( int index, const QString& fileName )
+{
+    QFile   file( fileName );
+    if ( file.open( QFile::ReadOnly ) == false )
+        return false;
+    QCryptographicHash  hash( QCryptographicHash::Sha1 );
+    if ( hash.addData( &file ) == false )
+        return false;
+    send( { { "type", "segment" }, { "index", index }, { "size", file.size() },
+            { "sha1", QString::fromLatin1( hash.result().toHex() ) } } );
+
+    // Segments can be large, don't buffer more than a few chunks at once
+    file.seek( 0 );
+    while ( file.atEnd() == false )
+    {
+        auto chunk = file.read( 1024 * 1024 );
+        bool written = chunk.isEmpty() == false && m_socket->write( chunk ) == chunk.size();
+        while ( written == true && m_socket->bytesToWrite() > 4 * 1024 * 1024 )
+            written = m_socket->waitForBytesWritten();
+        if ( written == false )
+        {
+            // The coordinator expects the announced size, the stream can't be recovered.
+            vlmcCritical() << "Failed to upload segment" << index;
+            m_socket->abort();
+            return true;
+        }
+    }
+    m_socket->flush();
+    return true;
+}
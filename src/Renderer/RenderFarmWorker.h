@@ -0,0 +1,88 @@
+/*****************************************************************************
+ * RenderFarmWorker.h: Renders segments for a render farm coordinator
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef RENDERFARMWORKER_H
+#define RENDERFARMWORKER_H
+
+#include <QJsonObject>
+#include <QList>
+#include <QObject>
+#include <QPair>
+#include <QString>
+#include <QTemporaryDir>
+
+#include <atomic>
+
+#include "Workflow/Types.h"
+
+class QTcpSocket;
+
+/**
+ *  \brief  A render node, rendering the segments a RenderFarmCoordinator assigns it.
+ *
+ *  The project is received from the coordinator. Its media are looked up by location
+ *  in this node's media library, after applying the path mapping: media stored in
+ *  a mapped folder on the coordinator must be in the matching folder here, and this
+ *  folder must be part of the media library folders, and already indexed: a media
+ *  which isn't found there fails the project load. The path mapping is given to each
+ *  node on its command line, the coordinator knows nothing about it.
+ */
+class RenderFarmWorker : public QObject
+{
+    Q_OBJECT
+
+    public:
+        /**
+         *  \param  pathMapping     Pairs of (coordinator path, local path) prefixes
+         *  \param  token           The secret shared by the coordinator and its workers
+         */
+        RenderFarmWorker( const QString& host, quint16 port,
+                          const QList<QPair<QString, QString>>& pathMapping,
+                          const QString& token, QObject* parent = nullptr );
+
+        bool                connectToCoordinator();
+
+        /**
+         *  \brief  Rewrite the media locations of a project file.
+         */
+        static void         mapPaths( QJsonObject& project, const QList<QPair<QString, QString>>& pathMapping );
+
+    private:
+        void                readMessages();
+        void                loadProject( const QJsonObject& message );
+        void                renderSegment( int index, qint64 begin, qint64 end );
+        bool                uploadSegment( int index, const QString& fileName );
+        void                send( const QJsonObject& message );
+
+    private:
+        QString                             m_host;
+        quint16                             m_port;
+        QString                             m_token;
+        QList<QPair<QString, QString>>      m_pathMapping;
+        QTcpSocket*                         m_socket;
+        QTemporaryDir                       m_tempDir;
+        Workflow::OutputSettings            m_settings;
+        bool                                m_busy;
+        std::atomic<qint64>                 m_currentFrame;
+};
+
+#endif // RENDERFARMWORKER_H
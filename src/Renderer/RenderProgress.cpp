@@ -0,0 +1,190 @@
+/*****************************************************************************
+ * RenderProgress.cpp: Machine readable render progress
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "RenderProgress.h"
+#include "Backend/MLT/MLTPipelineProbe.h"
+#include "Tools/VlmcDebug.h"
+
+#include <QFileInfo>
+#include <QJsonDocument>
+
+using Backend::MLT::MLTPipelineProbe;
+
+RenderProgress::RenderProgress( int fd, QObject* parent )
+    : QObject( parent )
+    , m_length( 0 )
+    , m_fps( 0 )
+    , m_passBegin( 0 )
+    , m_doneFrames( 0 )
+    , m_doneBytes( 0 )
+    , m_lastFrame( -1 )
+    , m_lastTime( 0 )
+    , m_frame( -1 )
+{
+    if ( m_file.open( fd, QFile::WriteOnly | QFile::Unbuffered ) == false )
+        vlmcWarning() << "Can't write the render progress to file descriptor" << fd;
+    m_timer.setInterval( 1000 );
+    connect( &m_timer, &QTimer::timeout, this, &RenderProgress::report );
+}
+
+RenderProgress::~RenderProgress()
+{
+    MLTPipelineProbe::setEnabled( false );
+}
+
+bool
+RenderProgress::isValid() const
+{
+    return m_file.isOpen();
+}
+
+void
+RenderProgress::setInterval( int msec )
+{
+    m_timer.setInterval( msec );
+}
+
+void
+RenderProgress::setFrame( qint64 frame )
+{
+    m_frame.store( frame, std::memory_order_relaxed );
+}
+
+void
+RenderProgress::start( qint64 length, double fps )
+{
+    m_length = length;
+    m_fps = fps;
+    m_files.clear();
+    m_passBegin = 0;
+    m_doneFrames = 0;
+    m_doneBytes = 0;
+    m_lastFrame = -1;
+    m_lastTime = 0;
+    m_frame = -1;
+    MLTPipelineProbe::reset();
+    MLTPipelineProbe::setEnabled( true );
+    m_elapsed.start();
+    m_timer.start();
+}
+
+void
+RenderProgress::passStarted( const QStringList& files, qint64 begin )
+{
+    endPass();
+    m_files = files;
+    m_passBegin = begin;
+    // Each pass restarts from its own first frame, possibly before the last one reported
+    m_frame = begin - 1;
+    m_lastFrame = begin - 1;
+}
+
+qint64
+RenderProgress::passFrames() const
+{
+    if ( m_files.isEmpty() == true )
+        return 0;
+    return qMax<qint64>( 0, m_frame.load( std::memory_order_relaxed ) - m_passBegin + 1 );
+}
+
+qint64
+RenderProgress::passBytes() const
+{
+    qint64 res = 0;
+    for ( const auto& f : m_files )
+        res += QFileInfo( f ).size();
+    return res;
+}
+
+void
+RenderProgress::endPass()
+{
+    m_doneFrames += passFrames();
+    m_doneBytes += passBytes();
+    m_files.clear();
+}
+
+QJsonObject
+RenderProgress::snapshot()
+{
+    const auto frame = m_frame.load( std::memory_order_relaxed );
+    const auto time = m_elapsed.elapsed();
+    const auto nbFrames = m_doneFrames + passFrames();
+
+    const double interval = ( time - m_lastTime ) / 1000.0;
+    const double fps = interval > 0 ? qMax<qint64>( 0, frame - m_lastFrame ) / interval : 0;
+    const double avgFps = time > 0 ? nbFrames * 1000.0 / time : 0;
+    m_lastFrame = qMax( frame, m_lastFrame );
+    m_lastTime = time;
+
+    QJsonObject res{
+        { "frame", frame },
+        { "length", m_length },
+        { "progress", m_length > 0 ? qBound( 0.0, ( frame + 1.0 ) / m_length, 1.0 ) : 0.0 },
+        { "fps", fps },
+        { "avgFps", avgFps },
+        { "elapsed", time / 1000.0 },
+    };
+    if ( avgFps > 0 )
+        res["eta"] = qMax<qint64>( 0, m_length - frame - 1 ) / avgFps;
+    if ( nbFrames > 0 && m_fps > 0 )
+        res["bitrate"] = ( m_doneBytes + passBytes() ) * 8 / 1000.0 / ( nbFrames / m_fps );
+
+    const auto stats = MLTPipelineProbe::stats();
+    if ( stats.nbFrames > 0 )
+    {
+        QJsonObject stages;
+        for ( int i = 0; i < MLTPipelineProbe::NbStages; ++i )
+        {
+            auto stage = static_cast<MLTPipelineProbe::Stage>( i );
+            stages[MLTPipelineProbe::stageName( stage )] = stats.time[i] / 1e6 / stats.nbFrames;
+        }
+        res["stages"] = stages;
+    }
+    return res;
+}
+
+void
+RenderProgress::report()
+{
+    if ( m_file.isOpen() == false )
+        return;
+    m_file.write( QJsonDocument( snapshot() ).toJson( QJsonDocument::Compact ) + '\n' );
+}
+
+void
+RenderProgress::finish( bool success )
+{
+    m_timer.stop();
+    MLTPipelineProbe::setEnabled( false );
+    endPass();
+    if ( m_file.isOpen() == false )
+        return;
+    auto res = snapshot();
+    res["done"] = true;
+    res["success"] = success;
+    m_file.write( QJsonDocument( res ).toJson( QJsonDocument::Compact ) + '\n' );
+}
@@ -0,0 +1,100 @@
+/*****************************************************************************
+ * RenderProgress.h: Machine readable render progress
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef RENDERPROGRESS_H
+#define RENDERPROGRESS_H
+
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonObject>
+#include <QObject>
+#include <QStringList>
+#include <QTimer>
+
+#include <atomic>
+
+/**
+ *  \brief  Writes the progress of a render as JSON lines.
+ *
+ *  The rendering thread only stores the current frame through setFrame(); reports
+ *  are built from the event loop at a fixed interval, so reporting costs nothing
+ *  per frame. Each line holds:
+ *  - "frame", "length", "progress": the current position in the timeline
+ *  - "fps", "avgFps": the throughput over the last interval and since the start
+ *  - "bitrate": the average bitrate of the files written so far, in kbit/s
+ *  - "elapsed", "eta": in seconds
+ *  - "stages": the time spent per frame in each stage of the pipeline, in ms
+ *  A last line with "done": true is written by finish().
+ *  Only the render passes started since start() are accounted for: the segments a
+ *  resumed render skips count neither as frames nor as bytes.
+ */
+class RenderProgress : public QObject
+{
+    Q_OBJECT
+
+    public:
+        /**
+         *  \param  fd  The file descriptor to write to. 1 writes to stdout.
+         */
+        RenderProgress( int fd, QObject* parent = nullptr );
+        ~RenderProgress();
+
+        bool            isValid() const;
+        void            setInterval( int msec );
+
+        void            start( qint64 length, double fps );
+        void            finish( bool success );
+
+        /**
+         *  \brief  Starts accounting for a render pass, see MainWorkflow::renderStarted
+         *
+         *  \param  files   The files written by this pass, used to compute the bitrate
+         *  \param  begin   The first frame of this pass
+         */
+        void            passStarted( const QStringList& files, qint64 begin );
+
+        /// Can be called from any thread
+        void            setFrame( qint64 frame );
+
+    private:
+        void            report();
+        QJsonObject     snapshot();
+        qint64          passFrames() const;
+        qint64          passBytes() const;
+        void            endPass();
+
+    private:
+        QFile                   m_file;
+        QTimer                  m_timer;
+        QElapsedTimer           m_elapsed;
+        QStringList             m_files;
+        qint64                  m_length;
+        double                  m_fps;
+        qint64                  m_passBegin;
+        qint64                  m_doneFrames;
+        qint64                  m_doneBytes;
+        qint64                  m_lastFrame;
+        qint64                  m_lastTime;
+        std::atomic<qint64>     m_frame;
+};
+
+#endif // RENDERPROGRESS_H
@@ -0,0 +1,230 @@
+/*****************************************************************************
+ * RenderWorker.cpp: Renders the jobs dispatched by the render daemon
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "RenderWorker.h"
+#include "CheckpointedRender.h"
+#include "Main/Core.h"
+#include "Project/Project.h"
+#include "Tools/VlmcDebug.h"
+#include "Workflow/MainWorkflow.h"
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QLocalSocket>
+#include <QTimer>
+
+RenderWorker::RenderWorker( const QString& serverName, QObject* parent )
+    : QObject( parent )
+    , m_serverName( serverName )
+    , m_socket( new QLocalSocket( this ) )
+    , m_currentJob( -1 )
+    , m_begin( 0 )
+    , m_end( 0 )
+    , m_currentFrame( 0 )
+{
+    connect( m_socket, &QLocalSocket::readyRead, this, &RenderWorker::readMessages );
+    // Without its daemon, a worker has nothing left to do
+    connect( m_socket, &QLocalSocket::disconnected, qApp, &QCoreApplication::quit, Qt::QueuedConnection );
+    // Only keep the latest position, progress is reported at a fixed pace
+    connect( Core::instance()->workflow(), &MainWorkflow::frameChanged, this, [this]( qint64 frame ) {
+        m_currentFrame.store( frame, std::memory_order_relaxed );
+    }, Qt::DirectConnection );
+}
+
+bool
+RenderWorker::connectToDaemon()
+{
+    m_socket->connectToServer( m_serverName );
+    if ( m_socket->waitForConnected() == false )
+    {
+        vlmcCritical() << "Can't connect to the render daemon:" << m_socket->errorString();
+        return false;
+    }
+    send( { { "type", "hello" }, { "pid", QCoreApplication::applicationPid() } } );
+    return true;
+}
+
+void
+RenderWorker::send( const QJsonObject& message )
+{
+    m_socket->write( QJsonDocument( message ).toJson( QJsonDocument::Compact ) + '\n' );
+    m_socket->flush();
+}
+
+void
+RenderWorker::sendProgress()
+{
+    if ( m_currentJob < 0 )
+        return;
+    auto frame = qBound( m_begin, m_currentFrame.load( std::memory_order_relaxed ), m_end );
+    send( {
+        { "type", "progress" },
+        { "job", m_currentJob },
+        { "frame", frame },
+        { "begin", m_begin },
+        { "end", m_end },
+        { "progress", static_cast<double>( frame - m_begin + 1 ) / ( m_end - m_begin + 1 ) },
+    } );
+}
+
+void
+RenderWorker::readMessages()
+{
+    // Rendering runs a nested event loop, don't start another job from there.
+    if ( m_currentJob >= 0 )
+        return;
+    while ( m_socket->canReadLine() == true )
+    {
+        auto message = QJsonDocument::fromJson( m_socket->readLine() ).object();
+        if ( message["type"].toString() != QStringLiteral( "job" ) )
+            continue;
+        QElapsedTimer   timer;
+        QString         error;
+        timer.start();
+        m_currentJob = message["job"].toInt();
+        auto res = render( message, error );
+        m_currentJob = -1;
+        QJsonObject result{
+            { "type", "result" },
+            { "job", message["job"] },
+            { "success", res },
+            { "elapsed", timer.elapsed() / 1000.0 },
+        };
+        if ( res == false )
+            result["error"] = error;
+        send( result );
+    }
+}
+
+bool
+RenderWorker::loadProject( const QString& path, QString& error )
+{
+    QFileInfo   info( path );
+    if ( info.exists() == false )
+    {
+        error = QStringLiteral( "No such project: " ) + path;
+        return false;
+    }
+    // Keep the project loaded between jobs, unless it changed on disk since then
+    if ( info.absoluteFilePath() == m_projectPath && info.lastModified() == m_projectModified )
+        return true;
+    m_projectPath.clear();
+    if ( Core::instance()->project()->load( info.absoluteFilePath() ) == false )
+    {
+        error = QStringLiteral( "Failed to load project " ) + path;
+        return false;
+    }
+    m_projectPath = info.absoluteFilePath();
+    m_projectModified = info.lastModified();
+    return true;
+}
+
+bool
+RenderWorker::parseOutput( const QJsonObject& object, Workflow::OutputSettings& settings )
+{
+    auto fileName = object["fileName"].toString();
+    if ( fileName.isEmpty() == true )
+        return false;
+    settings = Core::instance()->project()->outputSettings( fileName );
+    settings.width = object["width"].toInt( settings.width );
+    settings.height = object["height"].toInt( settings.height );
+    settings.fps = object["fps"].toDouble( settings.fps );
+    settings.aspectRatio = object["aspectRatio"].toString( settings.aspectRatio );
+    settings.videoBitrate = object["videoBitrate"].toInt( settings.videoBitrate );
+    settings.audioBitrate = object["audioBitrate"].toInt( settings.audioBitrate );
+    settings.nbChannels = object["nbChannels"].toInt( settings.nbChannels );
+    settings.sampleRate = object["sampleRate"].toInt( settings.sampleRate );
+    return true;
+}
+
+bool
+RenderWorker::render( const QJsonObject& job, QString& error )
+{
+    if ( loadProject( job["project"].toString(), error ) == false )
+        return false;
+
+    auto workflow = Core::instance()->workflow();
+    QList<Workflow::OutputSettings>     outputs;
+    for ( const auto& o : job["outputs"].toArray() )
+    {
+        Workflow::OutputSettings    settings;
+        if ( parseOutput( o.toObject(), settings ) == false )
+        {
+            error = QStringLiteral( "Invalid output description" );
+            return false;
+        }
+        outputs << settings;
+    }
+    if ( outputs.isEmpty() == true )
+    {
+        error = QStringLiteral( "No output to render to" );
+        return false;
+    }
+
+    const auto length = workflow->playableLength();
+    m_begin = job["begin"].toVariant().toLongLong();
+    m_end = job.contains( "end" ) ? job["end"].toVariant().toLongLong() : length - 1;
+    if ( m_begin < 0 || m_end < m_begin || m_end >= length )
+    {
+        error = QStringLiteral( "Invalid range" );
+        return false;
+    }
+    auto segmentDuration = job["segmentDuration"].toDouble();
+    if ( segmentDuration > 0 && ( m_begin != 0 || m_end != length - 1 ) )
+    {
+        error = QStringLiteral( "Checkpointed renders can't be restricted to a range" );
+        return false;
+    }
+
+    m_currentFrame = m_begin;
+    QTimer      progressTimer;
+    connect( &progressTimer, &QTimer::timeout, this, &RenderWorker::sendProgress );
+    progressTimer.start( 500 );
+
+    bool res = true;
+    if ( segmentDuration > 0 )
+    {
+        for ( const auto& settings : outputs )
+        {
+            CheckpointedRender render( workflow, settings, segmentDuration );
+            res = render.run();
+            if ( res == false )
+                break;
+        }
+    }
+    else
+        res = workflow->renderToFiles( outputs, m_begin, m_end );
+
+    progressTimer.stop();
+    m_currentFrame = m_end;
+    sendProgress();
+    if ( res == false )
+        error = QStringLiteral( "Render failed" );
+    return res;
+}
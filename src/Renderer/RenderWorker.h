@@ -0,0 +1,92 @@
+/*****************************************************************************
+ * RenderWorker.h: Renders the jobs dispatched by the render daemon
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef RENDERWORKER_H
+#define RENDERWORKER_H
+
+#include <QDateTime>
+#include <QJsonObject>
+#include <QObject>
+#include <QString>
+
+#include <atomic>
+
+#include "Workflow/Types.h"
+
+class QLocalSocket;
+
+/**
+ *  \brief  A render process kept alive between jobs.
+ *
+ *  The worker connects back to the daemon which spawned it, and renders the jobs it
+ *  receives one at a time. The backend, the media library and the last loaded project
+ *  stay in memory, so only the first job pays for the initialization.
+ *
+ *  Messages are JSON objects, one per line.
+ *  The daemon sends { "type": "job", "job": id, "project": path, "outputs": [...],
+ *  "begin": frame, "end": frame, "segmentDuration": seconds }. Only "job", "project" and
+ *  "outputs" are mandatory. Each output is an object with a mandatory "fileName" and
+ *  optional "width", "height", "fps", "aspectRatio", "videoBitrate", "audioBitrate",
+ *  "nbChannels" & "sampleRate" which default to the project settings.
+ *  The worker answers with "progress" messages, followed by one "result" message.
+ */
+class RenderWorker : public QObject
+{
+    Q_OBJECT
+
+    public:
+        explicit RenderWorker( const QString& serverName, QObject* parent = nullptr );
+
+        bool                connectToDaemon();
+
+        /**
+         *  \brief  Renders a job synchronously.
+         *  \param  error   Set to a description of the failure, if any
+         *  \return true if the job was rendered successfully
+         */
+        bool                render( const QJsonObject& job, QString& error );
+
+        /**
+         *  \brief  Fill an output description with the values of a JSON object
+         *
+         *  Missing values are taken from the current project.
+         */
+        static bool         parseOutput( const QJsonObject& object, Workflow::OutputSettings& settings );
+
+    private:
+        bool                loadProject( const QString& path, QString& error );
+        void                send( const QJsonObject& message );
+        void                sendProgress();
+        void                readMessages();
+
+    private:
+        QString             m_serverName;
+        QLocalSocket*       m_socket;
+        QString             m_projectPath;
+        QDateTime           m_projectModified;
+        int                 m_currentJob;
+        qint64              m_begin;
+        qint64              m_end;
+        std::atomic<qint64> m_currentFrame;
+};
+
+#endif // RENDERWORKER_H
@@ -0,0 +1,252 @@
+/*****************************************************************************
+ * BinarySettings.cpp: Chunked binary storage of the settings
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "BinarySettings.h"
+#include "Tools/VlmcDebug.h"
+
+#include <QHash>
+#include <QIODevice>
+#include <QList>
+#include <QPair>
+
+namespace
+{
+
+// "VLMB"
+const quint32   Magic = 0x564C4D42;
+const quint32   Version = 1;
+// Pinned so that files don't depend on the Qt version which wrote them
+const QDataStream::Version  StreamVersion = QDataStream::Qt_5_0;
+
+enum ChunkType : quint32
+{
+    Section = 1,
+    Values = 2,
+};
+
+typedef QList<QPair<QStringList, QVariantList>>    SectionList;
+
+void
+extractSections( const QStringList& prefix, QVariantMap& values, SectionList& sections )
+{
+    for ( auto it = values.begin(); it != values.end(); )
+    {
+        const auto type = it.value().type();
+        if ( type == QVariant::List )
+        {
+            sections.append( qMakePair( prefix + QStringList{ it.key() }, it.value().toList() ) );
+            it = values.erase( it );
+            continue;
+        }
+        if ( type == QVariant::Map || type == QVariant::Hash )
+        {
+            auto map = it.value().toMap();
+            extractSections( prefix + QStringList{ it.key() }, map, sections );
+            it.value() = map;
+        }
+        ++it;
+    }
+}
+
+void
+insertAt( QVariantMap& values, const QStringList& path, int depth, const QVariant& value )
+{
+    const auto& key = path[depth];
+    if ( depth == path.size() - 1 )
+    {
+        values.insert( key, value );
+        return;
+    }
+    auto map = values.value( key ).toMap();
+    insertAt( map, path, depth + 1, value );
+    values.insert( key, map );
+}
+
+}
+
+bool
+BinarySettings::isBinary( QIODevice* device )
+{
+    auto header = device->peek( sizeof( Magic ) );
+    if ( header.size() != sizeof( Magic ) )
+        return false;
+    QDataStream stream( header );
+    quint32 magic;
+    stream >> magic;
+    return magic == Magic;
+}
+
+BinarySettings::Writer::Writer( QIODevice* device )
+    : m_device( device )
+    , m_stream( device )
+    , m_chunkStart( -1 )
+{
+    m_stream.setVersion( StreamVersion );
+    m_stream << Magic << Version;
+}
+
+void
+BinarySettings::Writer::writeGroup( const QString& name, QVariantMap values )
+{
+    SectionList sections;
+    extractSections( QStringList(), values, sections );
+    for ( const auto& s : sections )
+    {
+        beginChunk( Section );
+        m_stream << name << s.first << static_cast<quint32>( s.second.size() );
+        for ( const auto& record : s.second )
+            m_stream << record;
+        endChunk();
+    }
+    beginChunk( Values );
+    m_stream << name << values;
+    endChunk();
+}
+
+bool
+BinarySettings::Writer::isValid() const
+{
+    return m_stream.status() == QDataStream::Ok;
+}
+
+void
+BinarySettings::Writer::beginChunk( quint32 type )
+{
+    m_stream << type;
+    m_chunkStart = m_device->pos();
+    // Patched by endChunk(), once the payload is written
+    m_stream << static_cast<quint64>( 0 );
+}
+
+void
+BinarySettings::Writer::endChunk()
+{
+    const auto end = m_device->pos();
+    const auto size = end - m_chunkStart - static_cast<qint64>( sizeof( quint64 ) );
+    if ( m_device->seek( m_chunkStart ) == false )
+    {
+        m_stream.setStatus( QDataStream::WriteFailed );
+        return;
+    }
+    m_stream << static_cast<quint64>( size );
+    if ( m_device->seek( end ) == false )
+        m_stream.setStatus( QDataStream::WriteFailed );
+}
+
+BinarySettings::Reader::Reader( QIODevice* device )
+    : m_device( device )
+{
+}
+
+bool
+BinarySettings::Reader::read( HandlerLookup handlerFor, GroupHandler groupLoaded )
+{
+    QDataStream stream( m_device );
+    stream.setVersion( StreamVersion );
+
+    quint32 magic;
+    quint32 version;
+    stream >> magic >> version;
+    if ( stream.status() != QDataStream::Ok || magic != Magic )
+        return false;
+    if ( version > Version )
+    {
+        vlmcWarning() << "Unsupported settings file version" << version;
+        return false;
+    }
+
+    // The sections nobody streamed, until the values of their group are read
+    QHash<QString, SectionList> pending;
+    while ( m_device->atEnd() == false )
+    {
+        quint32 type;
+        quint64 size;
+        stream >> type >> size;
+        if ( stream.status() != QDataStream::Ok )
+            return false;
+        const auto end = m_device->pos() + static_cast<qint64>( size );
+
+        if ( type == Section )
+        {
+            QString group;
+            QStringList path;
+            quint32 count;
+            stream >> group >> path >> count;
+            if ( stream.status() != QDataStream::Ok || path.isEmpty() == true )
+                return false;
+            auto handler = handlerFor( group, path );
+            QVariantList list;
+            for ( quint32 i = 0; i < count; ++i )
+            {
+                QVariant record;
+                stream >> record;
+                if ( stream.status() != QDataStream::Ok )
+                    return false;
+                if ( handler )
+                    handler( record );
+                else
+                    list.append( record );
+            }
+            if ( !handler )
+                pending[group].append( qMakePair( path, list ) );
+        }
+        else if ( type == Values )
+        {
+            QString group;
+            QVariantMap values;
+            stream >> group >> values;
+            if ( stream.status() != QDataStream::Ok )
+                return false;
+            for ( const auto& s : pending.take( group ) )
+                insertAt( values, s.first, 0, s.second );
+            groupLoaded( group, values );
+        }
+
+        // Skip whatever this version doesn't know about
+        if ( m_device->pos() != end && m_device->seek( end ) == false )
+            return false;
+    }
+    return true;
+}
+
+QJsonObject
+BinarySettings::toJson( QIODevice* device )
+{
+    QJsonObject res;
+    QJsonObject root;
+    Reader reader( device );
+    reader.read( []( const QString&, const QStringList& ) {
+        return RecordHandler();
+    }, [&res, &root]( const QString& group, const QVariantMap& values ) {
+        if ( group.isEmpty() == true )
+            root = QJsonObject::fromVariantMap( values );
+        else
+            res.insert( group, QJsonObject::fromVariantMap( values ) );
+    } );
+    for ( auto it = root.constBegin(); it != root.constEnd(); ++it )
+        res.insert( it.key(), it.value() );
+    return res;
+}
@@ -0,0 +1,103 @@
+/*****************************************************************************
+ * BinarySettings.h: Chunked binary storage of the settings
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef BINARYSETTINGS_H
+#define BINARYSETTINGS_H
+
+#include <QDataStream>
+#include <QJsonObject>
+#include <QString>
+#include <QStringList>
+#include <QVariant>
+
+#include <functional>
+
+class QIODevice;
+
+/**
+ *  \brief  Stores groups of settings as a sequence of length-prefixed chunks.
+ *
+ *  A file starts with a magic number and a version, followed by chunks made of a
+ *  quint32 type, a quint64 payload size and the payload. Each group of settings is
+ *  written as:
+ *  - one Section chunk per list found in its values, directly or in a nested map,
+ *    holding the group name, the path of the list and its elements one by one;
+ *  - a Values chunk holding the group name and the remaining values, which ends the
+ *    group.
+ *  Elements of a section can thus be handed over as they're read, instead of building
+ *  the whole document first. Chunks of an unknown type are skipped. All the payloads
+ *  are serialized with QDataStream.
+ */
+namespace BinarySettings
+{
+    /// Receives an element of a section while it's read
+    using RecordHandler = std::function<void( const QVariant& record )>;
+    /// Returns the handler of the section found at \a path in \a group, if any
+    using HandlerLookup = std::function<RecordHandler( const QString& group, const QStringList& path )>;
+    /// Receives the values of a group once its Values chunk is read
+    using GroupHandler = std::function<void( const QString& group, const QVariantMap& values )>;
+
+    bool        isBinary( QIODevice* device );
+
+    class Writer
+    {
+        public:
+            explicit Writer( QIODevice* device );
+
+            void    writeGroup( const QString& name, QVariantMap values );
+            bool    isValid() const;
+
+        private:
+            void    beginChunk( quint32 type );
+            void    endChunk();
+
+        private:
+            QIODevice*      m_device;
+            QDataStream     m_stream;
+            qint64          m_chunkStart;
+    };
+
+    class Reader
+    {
+        public:
+            explicit Reader( QIODevice* device );
+
+            /**
+             *  \brief  Read the whole device.
+             *
+             *  Sections without a handler are inserted back in the values of their group.
+             *  \return false if the device isn't a valid settings file, in which case
+             *          the groups read so far have been handed over already.
+             */
+            bool    read( HandlerLookup handlerFor, GroupHandler groupLoaded );
+
+        private:
+            QIODevice*      m_device;
+    };
+
+    /**
+     *  \brief  Convert a binary settings file to the JSON document Settings would save.
+     */
+    QJsonObject toJson( QIODevice* device );
+}
+
+#endif // BINARYSETTINGS_H
@@ -0,0 +1,72 @@
+/*****************************************************************************
+ * SettingHandle.h: Cached typed access to a setting
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef SETTINGHANDLE_H
+#define SETTINGHANDLE_H
+
+#include "SettingValue.h"
+
+#include <atomic>
+#include <memory>
+#include <type_traits>
+
+/**
+ *  \brief  Reads a setting without going through Settings.
+ *
+ *  The SettingValue is resolved once, when the handle is created. Its value is then
+ *  converted and cached each time it changes, so that get() is a single atomic load:
+ *  no lock, no lookup by key and no QVariant conversion. It can be called from any
+ *  thread. Copies of a handle share the same cache, which lives as long as the value.
+ */
+template <typename T>
+class SettingHandle
+{
+    static_assert( std::is_arithmetic<T>::value, "Only arithmetic values can be cached atomically" );
+
+    public:
+        SettingHandle() = default;
+
+        explicit SettingHandle( SettingValue* value )
+            : m_cache( std::make_shared<std::atomic<T>>( value->get().value<T>() ) )
+        {
+            auto cache = m_cache;
+            // Direct, so that the cache is up to date once set() returns
+            QObject::connect( value, &SettingValue::changed, value, [cache]( const QVariant& var ) {
+                cache->store( var.value<T>(), std::memory_order_release );
+            }, Qt::DirectConnection );
+        }
+
+        T       get() const
+        {
+            return m_cache->load( std::memory_order_acquire );
+        }
+
+        bool    isValid() const
+        {
+            return m_cache != nullptr;
+        }
+
+    private:
+        std::shared_ptr<std::atomic<T>>     m_cache;
+};
+
+#endif // SETTINGHANDLE_H
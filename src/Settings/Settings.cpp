@@ -30,6 +30,7 @@
 
 #include <QByteArray>
 #include <QFile>
+#include <QSaveFile>
 #include <QWriteLocker>
 #include <QReadLocker>
 #include <QStringList>
@@ -40,20 +41,45 @@
 #include <QJsonDocument>
 #include <QJsonObject>
 
+struct Settings::Snapshot
+{
+    QString                             path;
+    Format                              format;
+    QJsonObject                         base;
+    QVariantMap                         values;
+    QList<QPair<QString, QVariantMap>>  children;
+};
+
 Settings::Settings()
     : m_settingsFile( nullptr )
+    , m_format( Json )
+    , m_writing( false )
+    , m_stopWriter( false )
 {
 
 }
 
 Settings::Settings( const QString &settingsFile )
     : m_settingsFile( nullptr )
+    , m_format( Json )
+    , m_writing( false )
+    , m_stopWriter( false )
 {
     setSettingsFile( settingsFile );
 }
 
 Settings::~Settings()
 {
+    if ( m_writer.joinable() == true )
+    {
+        // Let the pending saves complete, they may be all that's left of the project
+        {
+            std::lock_guard<std::mutex> lock( m_writerLock );
+            m_stopWriter = true;
+        }
+        m_writerCond.notify_all();
+        m_writer.join();
+    }
     qDeleteAll( m_settings );
 }
 
@@ -95,13 +121,46 @@ Settings::readSettingsFromFile()
     return doc;
 }
 
+void
+Settings::setFormat( Format format )
+{
+    m_format = format;
+}
+
+Settings::Format
+Settings::format() const
+{
+    return m_format;
+}
+
+void
+Settings::setRecordHandler( const QStringList& path, BinarySettings::RecordHandler handler )
+{
+    m_recordHandlers.insert( path.join( '/' ), handler );
+}
+
 bool
 Settings::load()
 {
     if ( m_settingsFile == nullptr )
         return false;
 
+    if ( m_settingsFile->open( QFile::ReadOnly ) == true )
+    {
+        bool binary = BinarySettings::isBinary( m_settingsFile.get() );
+        if ( binary == true )
+        {
+            m_format = Binary;
+            auto res = loadBinary();
+            m_settingsFile->close();
+            return res;
+        }
+        m_settingsFile->close();
+    }
+    m_format = Json;
+
     QJsonObject top = readSettingsFromFile().object();
+    m_document = top;
 
     loadJsonFrom( top );
 
@@ -113,36 +172,196 @@ Settings::load()
     return true;
 }
 
+bool
+Settings::loadBinary()
+{
+    QVariantMap root;
+    BinarySettings::Reader reader( m_settingsFile.get() );
+    auto res = reader.read( [this]( const QString& group, const QStringList& path ) -> BinarySettings::RecordHandler {
+        auto s = group.isEmpty() == true ? this : child( group );
+        if ( s == nullptr )
+            return BinarySettings::RecordHandler();
+        return s->m_recordHandlers.value( path.join( '/' ) );
+    }, [this, &root]( const QString& group, const QVariantMap& values ) {
+        if ( group.isEmpty() == true )
+        {
+            root = values;
+            loadValues( values );
+            return;
+        }
+        auto s = child( group );
+        if ( s == nullptr )
+        {
+            vlmcWarning() << "Loaded invalid settings group:" << group;
+            return;
+        }
+        s->loadValues( values );
+    } );
+    if ( res == false )
+        vlmcWarning() << "Failed to load settings file" << m_settingsFile->fileName();
+    m_document = QJsonObject::fromVariantMap( root );
+    return res;
+}
+
 bool
 Settings::save()
 {
-    if ( m_settingsFile == nullptr )
+    auto s = snapshot();
+    if ( s == nullptr )
         return false;
+    // Don't let a pending save overwrite this one
+    waitForSaves();
+    return write( *s );
+}
 
-    QReadLocker lock( &m_rwLock );
+void
+Settings::saveAsync()
+{
+    auto s = snapshot();
+    if ( s == nullptr )
+    {
+        emit saved( false, QString() );
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock( m_writerLock );
+        m_pendingSaves.push_back( std::move( s ) );
+        if ( m_writer.joinable() == false )
+            m_writer = std::thread( &Settings::runWriter, this );
+    }
+    m_writerCond.notify_all();
+}
 
-    QJsonDocument doc = readSettingsFromFile();
-    QJsonObject top = doc.object();
+std::unique_ptr<Settings::Snapshot>
+Settings::snapshot()
+{
+    if ( m_settingsFile == nullptr )
+        return nullptr;
 
-    saveJsonTo( top );
+    std::unique_ptr<Snapshot> res( new Snapshot );
+    res->path = m_settingsFile->fileName();
+    res->format = m_format;
+    // Keep what was loaded rather than parsing the previous file again
+    res->base = m_document;
 
+    QReadLocker lock( &m_rwLock );
+    res->values = snapshotValues();
     for ( const auto& child : m_settingsChildren )
+        res->children.append( qMakePair( child.first, child.second->snapshotValues() ) );
+    return res;
+}
+
+QVariantMap
+Settings::snapshotValues()
+{
+    emit preSave();
+    QVariantMap res;
+    for ( const auto& val : m_settings )
+    {
+        if ( ( val->flags() & SettingValue::Runtime ) != 0 )
+            continue ;
+        // The values are implicitly shared, the writer converts them to JSON
+        if ( val->type() == SettingValue::ByteArray )
+            res.insert( val->key(), QString( val->get().toByteArray().toBase64() ) );
+        else
+            res.insert( val->key(), val->get() );
+    }
+    return res;
+}
+
+bool
+Settings::write( const Snapshot& snapshot )
+{
+    // Written next to the previous file, which is only replaced once the new one is
+    // complete: commit() syncs it to the disk before renaming it over the previous one.
+    QSaveFile file( snapshot.path );
+    bool res = file.open( QFile::WriteOnly );
+    if ( res == true )
+        res = snapshot.format == Binary ? writeBinary( snapshot, &file ) : writeJson( snapshot, &file );
+    if ( res == false || file.commit() == false )
     {
-        QJsonObject object;
-        child.second->saveJsonTo( object );
-        top.insert( child.first, QJsonValue( object ) );
+        vlmcWarning() << "Failed to save settings to" << snapshot.path << ':' << file.errorString();
+        return false;
     }
+    return true;
+}
 
-    doc.setObject( top );
+bool
+Settings::writeJson( const Snapshot& snapshot, QIODevice* device )
+{
+    QJsonObject top = snapshot.base;
+    for ( auto it = snapshot.values.constBegin(); it != snapshot.values.constEnd(); ++it )
+        top.insert( it.key(), QJsonValue::fromVariant( it.value() ) );
+    for ( const auto& child : snapshot.children )
+        top.insert( child.first, QJsonObject::fromVariantMap( child.second ) );
 
-    m_settingsFile->open( QFile::WriteOnly );
+    QJsonDocument doc( top );
 #ifdef NDEBUG
-    m_settingsFile->write( doc.toJson( QJsonDocument::Compact ) );
+    const auto data = doc.toJson( QJsonDocument::Compact );
 #else
-    m_settingsFile->write( doc.toJson( QJsonDocument::Indented ) );
+    const auto data = doc.toJson( QJsonDocument::Indented );
 #endif
-    m_settingsFile->close();
-    return true;
+    return device->write( data ) == data.size();
+}
+
+bool
+Settings::writeBinary( const Snapshot& snapshot, QIODevice* device )
+{
+    BinarySettings::Writer writer( device );
+    // Keep the keys nobody claimed, as the JSON files do
+    QVariantMap root;
+    for ( auto it = snapshot.base.constBegin(); it != snapshot.base.constEnd(); ++it )
+    {
+        bool isChild = false;
+        for ( const auto& child : snapshot.children )
+            isChild = isChild || child.first == it.key();
+        if ( isChild == false )
+            root.insert( it.key(), it.value().toVariant() );
+    }
+    for ( auto it = snapshot.values.constBegin(); it != snapshot.values.constEnd(); ++it )
+        root.insert( it.key(), it.value() );
+    // Children are written in the order they were added, which is the one they're loaded in
+    writer.writeGroup( QString(), root );
+    for ( const auto& child : snapshot.children )
+        writer.writeGroup( child.first, child.second );
+    return writer.isValid();
+}
+
+void
+Settings::waitForSaves()
+{
+    // The emergency backup can be saved from a crash of the writer itself
+    if ( std::this_thread::get_id() == m_writer.get_id() )
+        return;
+    std::unique_lock<std::mutex> lock( m_writerLock );
+    m_writerCond.wait( lock, [this]() {
+        return m_pendingSaves.empty() == true && m_writing == false;
+    } );
+}
+
+void
+Settings::runWriter()
+{
+    std::unique_lock<std::mutex> lock( m_writerLock );
+    while ( true )
+    {
+        m_writerCond.wait( lock, [this]() {
+            return m_pendingSaves.empty() == false || m_stopWriter == true;
+        } );
+        if ( m_pendingSaves.empty() == true )
+            return;
+        auto s = std::move( m_pendingSaves.front() );
+        m_pendingSaves.pop_front();
+        m_writing = true;
+        lock.unlock();
+
+        auto res = write( *s );
+        emit saved( res, s->path );
+
+        lock.lock();
+        m_writing = false;
+        m_writerCond.notify_all();
+    }
 }
 
 void
@@ -165,34 +384,42 @@ Settings::loadJsonFrom( const QJsonObject &object )
         if ( isChildSettings == true )
             continue;
 
-        SettingValue* val = value( it.key() );
-        if ( val == nullptr )
-        {
-            vlmcWarning() << "Loaded invalid project setting:" << it.key();
-            continue;
-        }
-
-        if ( val->type() == SettingValue::ByteArray )
-            val->set( QByteArray::fromBase64( (*it).toVariant().toByteArray() ) );
-        else
-            val->set( (*it).toVariant() );
+        loadValue( it.key(), (*it).toVariant() );
     }
     emit postLoad();
 }
 
 void
-Settings::saveJsonTo( QJsonObject &object )
+Settings::loadValues( const QVariantMap& values )
 {
-    emit preSave();
-    for ( const auto& val : m_settings )
+    for ( auto it = values.constBegin(); it != values.constEnd(); ++it )
+        loadValue( it.key(), it.value() );
+    emit postLoad();
+}
+
+void
+Settings::loadValue( const QString& key, const QVariant& value )
+{
+    SettingValue* val = this->value( key );
+    if ( val == nullptr )
     {
-        if ( ( val->flags() & SettingValue::Runtime ) != 0 )
-            continue ;
-        if ( val->type() == SettingValue::ByteArray )
-            object.insert( val->key(), QJsonValue( QString( val->get().toByteArray().toBase64() ) ) );
-        else
-            object.insert( val->key(), QJsonValue::fromVariant( val->get() ) );
+        vlmcWarning() << "Loaded invalid project setting:" << key;
+        return;
     }
+
+    if ( val->type() == SettingValue::ByteArray )
+        val->set( QByteArray::fromBase64( value.toByteArray() ) );
+    else
+        val->set( value );
+}
+
+Settings*
+Settings::child( const QString& name ) const
+{
+    for ( const auto& pair : m_settingsChildren )
+        if ( pair.first == name )
+            return pair.second;
+    return nullptr;
 }
 
 void
@@ -25,11 +25,17 @@
 
 #include "Main/Core.h"
 #include "Project/Project.h"
+#include "BinarySettings.h"
 #include "SettingValue.h"
 
+#include <condition_variable>
+#include <deque>
 #include <memory>
+#include <mutex>
+#include <thread>
 
 #include <QString>
+#include <QHash>
 #include <QMap>
 #include <QPair>
 #include <QObject>
@@ -111,6 +117,13 @@ class   Settings: public QObject
         typedef QList<SettingValue*>                SettingList;
         typedef QMap<QString, SettingValue*>        SettingMap;
 
+        enum Format
+        {
+            Json,
+            /// See BinarySettings
+            Binary,
+        };
+
         Settings();
         Settings( const QString& settingsFile );
         ~Settings();
@@ -119,24 +132,76 @@ class   Settings: public QObject
         SettingValue*               createVar( SettingValue::Type type, const QString &key, const QVariant &defaultValue, const char *name, const char *desc, SettingValue::Flags flags );
         SettingList                 group( const QString &groupName ) const;
         bool                        load();
+        /**
+         *  \brief Save the settings, and wait for them to be written.
+         */
         bool                        save();
+        /**
+         *  \brief Save the settings from a background thread.
+         *
+         *  Only the values are copied from the calling thread, converting them to JSON
+         *  and writing the file is left to a worker, which emits saved() once done.
+         *  Saves are written in the order they were requested.
+         */
+        void                        saveAsync();
         void                        addSettings( const QString& name, Settings& settings );
         void                        restoreDefaultValues();
         void                        setSettingsFile( const QString& settingsFile );
+        /**
+         *  \brief The format of the next saves. load() sets it to the one of the file it read.
+         */
+        void                        setFormat( Format format );
+        Format                      format() const;
+        /**
+         *  \brief Hand the elements of a list value over while a binary file is loaded.
+         *
+         *  \param path    The key of the list, followed by the keys leading to it if
+         *                  it's nested in a map value.
+         *  The list is then left out of the value, which only gets the rest of it. Lists
+         *  read from JSON files are always loaded as part of their value.
+         */
+        void                        setRecordHandler( const QStringList& path,
+                                                      BinarySettings::RecordHandler handler );
 
     private:
+        struct Snapshot;
+
         SettingMap                  m_settings;
         mutable QReadWriteLock      m_rwLock;
         std::unique_ptr<QFile>      m_settingsFile;
+        /// The last loaded file, so that the keys nobody claimed are saved back
+        QJsonObject                 m_document;
+        Format                      m_format;
+        QHash<QString, BinarySettings::RecordHandler>   m_recordHandlers;
 
         QList<QPair<QString, Settings*>>                 m_settingsChildren;
 
+        std::thread                 m_writer;
+        std::mutex                  m_writerLock;
+        std::condition_variable     m_writerCond;
+        std::deque<std::unique_ptr<Snapshot>>   m_pendingSaves;
+        bool                        m_writing;
+        bool                        m_stopWriter;
+
         QJsonDocument               readSettingsFromFile();
         void                        loadJsonFrom( const QJsonObject& object );
-        void                        saveJsonTo( QJsonObject& object );
+        bool                        loadBinary();
+        void                        loadValues( const QVariantMap& values );
+        void                        loadValue( const QString& key, const QVariant& value );
+        Settings*                   child( const QString& name ) const;
+        QVariantMap                 snapshotValues();
+        std::unique_ptr<Snapshot>   snapshot();
+        static bool                 write( const Snapshot& snapshot );
+        static bool                 writeJson( const Snapshot& snapshot, QIODevice* device );
+        static bool                 writeBinary( const Snapshot& snapshot, QIODevice* device );
+        void                        waitForSaves();
+        void                        runWriter();
     signals:
         void                        postLoad();
+        /// Emitted from the thread saving, the values must be up to date once it returns
         void                        preSave();
+        /// Emitted from the writer thread when a saveAsync() completes
+        void                        saved( bool success, const QString& path );
 };
 
 #endif
@@ -0,0 +1,74 @@
+/*****************************************************************************
+ * FrameMailbox.h: Lock-free single slot mailbox
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef FRAMEMAILBOX_H
+#define FRAMEMAILBOX_H
+
+#include <atomic>
+#include <memory>
+
+/**
+ *  \brief  Hands the latest value over from one thread to another.
+ *
+ *  Publishing replaces the value which wasn't taken yet, so the reader always gets the
+ *  most recent one and the writer never waits for it.
+ */
+template <typename T>
+class FrameMailbox
+{
+    public:
+        FrameMailbox()
+            : m_slot( nullptr )
+        {
+        }
+
+        ~FrameMailbox()
+        {
+            delete m_slot.load();
+        }
+
+        FrameMailbox( const FrameMailbox& ) = delete;
+        FrameMailbox& operator=( const FrameMailbox& ) = delete;
+
+        void    publish( std::unique_ptr<T> value )
+        {
+            delete m_slot.exchange( value.release(), std::memory_order_acq_rel );
+        }
+
+        /**
+         *  \return The last published value, or nullptr if it was already taken.
+         */
+        std::unique_ptr<T>  take()
+        {
+            return std::unique_ptr<T>( m_slot.exchange( nullptr, std::memory_order_acq_rel ) );
+        }
+
+        bool    isEmpty() const
+        {
+            return m_slot.load( std::memory_order_acquire ) == nullptr;
+        }
+
+    private:
+        std::atomic<T*>     m_slot;
+};
+
+#endif // FRAMEMAILBOX_H
@@ -0,0 +1,180 @@
+/*****************************************************************************
+ * LogRing.cpp: Lock-free queue of log messages
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "LogRing.h"
+
+#include <chrono>
+#include <cstdio>
+
+namespace
+{
+
+const size_t    Mask = LogRing::NbSlots - 1;
+static_assert( ( LogRing::NbSlots & Mask ) == 0, "The number of slots must be a power of 2" );
+
+// Producers never wake the writer up, it polls the ring at this interval once it's empty
+const std::chrono::milliseconds     PollInterval( 10 );
+
+inline int64_t
+steadyNow()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now().time_since_epoch() ).count();
+}
+
+}
+
+LogRing::LogRing( Writer writer )
+    : m_writer( std::move( writer ) )
+    , m_slots( new Slot[NbSlots] )
+    , m_enqueuePos( 0 )
+    , m_dequeuePos( 0 )
+    , m_dropped( 0 )
+    , m_reportedDrops( 0 )
+    , m_stop( false )
+{
+    for ( size_t i = 0; i < NbSlots; ++i )
+        m_slots[i].sequence.store( i, std::memory_order_relaxed );
+    // Messages are stamped with the monotonic clock, and shown with the wall clock
+    m_wallBase = std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::system_clock::now().time_since_epoch() ).count();
+    m_steadyBase = steadyNow();
+    m_thread = std::thread( &LogRing::run, this );
+}
+
+LogRing::~LogRing()
+{
+    {
+        std::lock_guard<std::mutex> lock( m_lock );
+        m_stop = true;
+    }
+    m_cond.notify_all();
+    m_thread.join();
+}
+
+LogRing::Message*
+LogRing::claim()
+{
+    auto pos = m_enqueuePos.load( std::memory_order_relaxed );
+    while ( true )
+    {
+        auto& slot = m_slots[pos & Mask];
+        const auto seq = slot.sequence.load( std::memory_order_acquire );
+        const auto diff = static_cast<intptr_t>( seq ) - static_cast<intptr_t>( pos );
+        if ( diff < 0 )
+        {
+            // The writer is still busy with this slot
+            m_dropped.fetch_add( 1, std::memory_order_relaxed );
+            return nullptr;
+        }
+        if ( diff > 0 )
+        {
+            pos = m_enqueuePos.load( std::memory_order_relaxed );
+            continue;
+        }
+        // Read before the position is claimed, so that the claims order the timestamps
+        const auto time = steadyNow();
+        if ( m_enqueuePos.compare_exchange_weak( pos, pos + 1, std::memory_order_relaxed ) == true )
+        {
+            slot.message.time = ( m_wallBase + time - m_steadyBase ) / 1000;
+            slot.message.position = pos;
+            return &slot.message;
+        }
+    }
+}
+
+void
+LogRing::publish( Message* message )
+{
+    m_slots[message->position & Mask].sequence.store( message->position + 1, std::memory_order_release );
+}
+
+uint64_t
+LogRing::dropped() const
+{
+    return m_dropped.load( std::memory_order_relaxed );
+}
+
+void
+LogRing::flush()
+{
+    const auto target = m_enqueuePos.load( std::memory_order_acquire );
+    for ( int i = 0; i < 1000; ++i )
+    {
+        if ( m_dequeuePos.load( std::memory_order_acquire ) >= target )
+            return;
+        std::this_thread::sleep_for( std::chrono::milliseconds( 1 ) );
+    }
+}
+
+bool
+LogRing::writePending()
+{
+    bool res = false;
+    auto pos = m_dequeuePos.load( std::memory_order_relaxed );
+    while ( true )
+    {
+        auto& slot = m_slots[pos & Mask];
+        // Also stops at a claimed slot which isn't published yet, to keep the order
+        if ( slot.sequence.load( std::memory_order_acquire ) != pos + 1 )
+            break;
+        m_writer( slot.message );
+        slot.sequence.store( pos + NbSlots, std::memory_order_release );
+        m_dequeuePos.store( ++pos, std::memory_order_release );
+        res = true;
+    }
+
+    const auto dropped = m_dropped.load( std::memory_order_relaxed );
+    if ( dropped != m_reportedDrops )
+    {
+        Message m;
+        m.time = ( m_wallBase + steadyNow() - m_steadyBase ) / 1000;
+        m.level = -1;
+        m.console = true;
+        m.showTime = true;
+        snprintf( m.text, sizeof( m.text ), "%llu log messages were dropped",
+                  static_cast<unsigned long long>( dropped - m_reportedDrops ) );
+        m_writer( m );
+        m_reportedDrops = dropped;
+    }
+    return res;
+}
+
+void
+LogRing::run()
+{
+    std::unique_lock<std::mutex> lock( m_lock );
+    while ( m_stop == false )
+    {
+        lock.unlock();
+        auto written = writePending();
+        lock.lock();
+        if ( written == false )
+            m_cond.wait_for( lock, PollInterval );
+    }
+    lock.unlock();
+    writePending();
+}
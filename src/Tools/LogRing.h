@@ -0,0 +1,113 @@
+/*****************************************************************************
+ * LogRing.h: Lock-free queue of log messages
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef LOGRING_H
+#define LOGRING_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+/**
+ *  \brief  Hands log messages over from any thread to a single writer thread.
+ *
+ *  Messages are formatted in place in the slots of a fixed ring, so logging never
+ *  allocates nor locks. When the writer doesn't keep up, the ring fills up and new
+ *  messages are dropped and counted rather than waited for: the writer reports how
+ *  many were lost once it catches up.
+ *  Messages are written in the order their slots were claimed, and each one is
+ *  stamped when its slot is claimed, so timestamps never go backward.
+ */
+class LogRing
+{
+    public:
+        static const size_t     NbSlots = 1024;
+        static const size_t     MessageSize = 1024;
+
+        struct Message
+        {
+            /// Milliseconds since the epoch
+            int64_t     time;
+            int         level;
+            /// Whether the message passed the console log level
+            bool        console;
+            /// Whether the writer should prefix the text with the time
+            bool        showTime;
+            char        text[MessageSize];
+            /// Used by publish()
+            size_t      position;
+        };
+        using Writer = std::function<void( const Message& message )>;
+
+        /**
+         *  \param  writer  Called from the writer thread for each message. It's also
+         *                  called with a level of -1 to report dropped messages.
+         */
+        explicit LogRing( Writer writer );
+        ~LogRing();
+
+        LogRing( const LogRing& ) = delete;
+        LogRing& operator=( const LogRing& ) = delete;
+
+        /**
+         *  \return A message to fill and publish, or nullptr if the ring is full.
+         */
+        Message*    claim();
+        void        publish( Message* message );
+
+        /**
+         *  \brief  Wait for the messages published so far to be written, up to a second.
+         */
+        void        flush();
+        uint64_t    dropped() const;
+
+    private:
+        struct Slot
+        {
+            std::atomic<size_t>     sequence;
+            Message                 message;
+        };
+
+        bool        writePending();
+        void        run();
+
+    private:
+        Writer                      m_writer;
+        std::unique_ptr<Slot[]>     m_slots;
+        std::atomic<size_t>         m_enqueuePos;
+        std::atomic<size_t>         m_dequeuePos;
+        std::atomic<uint64_t>       m_dropped;
+        uint64_t                    m_reportedDrops;
+        int64_t                     m_wallBase;
+        int64_t                     m_steadyBase;
+        std::mutex                  m_lock;
+        std::condition_variable     m_cond;
+        bool                        m_stop;
+        std::thread                 m_thread;
+};
+
+#endif // LOGRING_H
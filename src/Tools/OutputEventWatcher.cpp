@@ -54,3 +54,9 @@ OutputEventWatcher::onErrorEncountered()
 {
     emit errorEncountered();
 }
+
+void
+OutputEventWatcher::onPlaybackStats( int64_t droppedFrames, int64_t lateFrames )
+{
+    emit playbackStatsChanged( droppedFrames, lateFrames );
+}
@@ -38,12 +38,14 @@ private:
     virtual void    onStopped();
     virtual void    onVolumeChanged();
     virtual void    onErrorEncountered();
+    virtual void    onPlaybackStats( int64_t droppedFrames, int64_t lateFrames );
 
 signals:
     void            playing();
     void            stopped();
     void            volumeChanged();
     void            errorEncountered();
+    void            playbackStatsChanged( qint64 droppedFrames, qint64 lateFrames );
 };
 
 #endif // OUTPUTEVENTWATCHER_H
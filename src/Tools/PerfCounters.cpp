@@ -0,0 +1,96 @@
+/*****************************************************************************
+ * PerfCounters.cpp: Live performance counters
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "PerfCounters.h"
+
+#include <QDir>
+#include <QStringList>
+
+#include <chrono>
+
+std::atomic<int64_t>    PerfCounters::s_counters[PerfCounters::NbCounters];
+std::atomic_int         PerfCounters::s_timingUsers( 0 );
+
+static int64_t
+openFiles()
+{
+#ifdef Q_OS_LINUX
+    QDir fds( QStringLiteral( "/proc/self/fd" ) );
+    if ( fds.exists() == true )
+    {
+        // Listing the directory holds one of them
+        return fds.entryList( QDir::AllEntries | QDir::System | QDir::NoDotAndDotDot ).size() - 1;
+    }
+#endif
+    return -1;
+}
+
+void
+PerfCounters::setTimingEnabled( bool enabled )
+{
+    s_timingUsers.fetch_add( enabled == true ? 1 : -1, std::memory_order_relaxed );
+}
+
+PerfCounters::Snapshot
+PerfCounters::snapshot()
+{
+    Snapshot res;
+    res.time = std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::steady_clock::now().time_since_epoch() ).count();
+    for ( int i = 0; i < NbCounters; ++i )
+        res.values[i] = value( static_cast<Counter>( i ) );
+    res.openFiles = openFiles();
+    return res;
+}
+
+QString
+PerfCounters::report( const Snapshot& from, const Snapshot& to )
+{
+    auto delta = [&from, &to]( Counter c ) { return to.values[c] - from.values[c]; };
+    const auto nbFrames = delta( FramesShown );
+    const auto elapsed = to.time - from.time;
+
+    QStringList res;
+    res << QStringLiteral( "shown fps: %1" ).arg( elapsed > 0 ? nbFrames * 1000.0 / elapsed : 0, 0, 'f', 1 );
+    if ( isTimingEnabled() == true )
+        res << QStringLiteral( "composite: %1 ms/frame" )
+               .arg( nbFrames > 0 ? delta( CompositeTime ) / 1e6 / nbFrames : 0, 0, 'f', 2 );
+    res << QStringLiteral( "dropped frames: %1" ).arg( delta( DroppedFrames ) );
+    const auto nbPresented = delta( FramesPresented );
+    if ( nbPresented > 0 )
+        res << QStringLiteral( "present latency: %1 ms" )
+               .arg( delta( PresentLatency ) / 1e3 / nbPresented, 0, 'f', 1 );
+    const auto nbPrefetches = delta( PrefetchHits ) + delta( PrefetchMisses );
+    if ( nbPrefetches > 0 )
+        res << QStringLiteral( "prefetch hit rate: %1%" ).arg( delta( PrefetchHits ) * 100 / nbPrefetches );
+    res << QStringLiteral( "producers: %1" ).arg( to.values[Producers] );
+    if ( to.openFiles >= 0 )
+        res << QStringLiteral( "open files: %1" ).arg( to.openFiles );
+    res << QStringLiteral( "queued seeks: %1" ).arg( to.values[PendingSeeks] );
+    res << QStringLiteral( "frame memory: %1 MiB" ).arg( to.values[FrameMemory] / 1048576.0, 0, 'f', 1 );
+    res << QStringLiteral( "cache memory: %1 MiB" ).arg( to.values[CacheMemory] / 1048576.0, 0, 'f', 1 );
+    return res.join( '\n' );
+}
@@ -0,0 +1,153 @@
+/*****************************************************************************
+ * PerfCounters.h: Live performance counters
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef PERFCOUNTERS_H
+#define PERFCOUNTERS_H
+
+#include <QString>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+/**
+ *  \brief  Counters updated by the pipeline as it runs, cheap enough to always be on.
+ *
+ *  Updating a counter is a relaxed atomic add, so any thread, including the rendering
+ *  ones, can do it. Readers take snapshots, and derive the rates from two of them.
+ *  The counters are process wide, the class is only a namespace for them.
+ */
+class PerfCounters
+{
+    public:
+        enum Counter
+        {
+            /// Frames delivered by the outputs, to the screen or to the encoder. This is
+            /// what the outputs show, not what the producers decoded.
+            FramesShown,
+            /// Time spent compositing the tracks, in nanoseconds, while timing is enabled
+            CompositeTime,
+            /// Frames a realtime output skipped to keep up
+            DroppedFrames,
+            /// Frames painted by the native preview, and the total time between their
+            /// production by the output and their painting, in microseconds
+            FramesPresented,
+            PresentLatency,
+            /// Clips the playhead reached after, or before, the Prefetcher prepared them
+            PrefetchHits,
+            PrefetchMisses,
+            /// Live inputs, including the tracks and the cuts of the clips
+            Producers,
+            /// Scrubbing seeks waiting for the previous one to be served
+            PendingSeeks,
+            /// Bytes held by the frames copied out of the outputs
+            FrameMemory,
+            /// Bytes held by the keyframe indexes
+            CacheMemory,
+            NbCounters
+        };
+
+        struct Snapshot
+        {
+            /// When it was taken, in ms of a monotonic clock
+            int64_t     time;
+            int64_t     values[NbCounters];
+            /// Open file descriptors, or -1 where they can't be counted
+            int64_t     openFiles;
+        };
+
+        static void     add( Counter counter, int64_t value = 1 )
+        {
+            s_counters[counter].fetch_add( value, std::memory_order_relaxed );
+        }
+
+        static int64_t  value( Counter counter )
+        {
+            return s_counters[counter].load( std::memory_order_relaxed );
+        }
+
+        /**
+         *  \brief  Requests the counters which need the pipeline to be timed.
+         *
+         *  Timing the MLT callbacks costs two clock reads per callback, so the
+         *  compositing time is only counted while a reader asked for it. Calls are
+         *  counted, each reader enables it once and disables it once.
+         */
+        static void     setTimingEnabled( bool enabled );
+        static bool     isTimingEnabled()
+        {
+            return s_timingUsers.load( std::memory_order_relaxed ) > 0;
+        }
+
+        static Snapshot snapshot();
+
+        /**
+         *  \brief  Describes the activity between two snapshots, one counter per line.
+         *
+         *  Rates and averages are computed over the interval, gauges are read from \a to.
+         */
+        static QString  report( const Snapshot& from, const Snapshot& to );
+
+        /**
+         *  \brief  Accounts the memory it allocates in a counter.
+         */
+        template <typename T, Counter C>
+        class Allocator
+        {
+            public:
+                typedef T   value_type;
+
+                template <typename U>
+                struct rebind
+                {
+                    typedef Allocator<U, C> other;
+                };
+
+                Allocator() = default;
+                template <typename U>
+                Allocator( const Allocator<U, C>& ) {}
+
+                T*      allocate( size_t n )
+                {
+                    add( C, n * sizeof( T ) );
+                    return std::allocator<T>().allocate( n );
+                }
+
+                void    deallocate( T* p, size_t n )
+                {
+                    add( C, -static_cast<int64_t>( n * sizeof( T ) ) );
+                    std::allocator<T>().deallocate( p, n );
+                }
+
+                template <typename U>
+                bool    operator==( const Allocator<U, C>& ) const { return true; }
+                template <typename U>
+                bool    operator!=( const Allocator<U, C>& ) const { return false; }
+        };
+
+    private:
+        static std::atomic<int64_t>     s_counters[NbCounters];
+        static std::atomic_int          s_timingUsers;
+};
+
+#endif // PERFCOUNTERS_H
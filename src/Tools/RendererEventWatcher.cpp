@@ -28,8 +28,62 @@
 #include "Tools/RendererEventWatcher.h"
 
 RendererEventWatcher::RendererEventWatcher(QObject *parent) :
-    QObject(parent)
+    QObject(parent),
+    m_position( 0 ),
+    m_positionPending( false ),
+    m_positionEvents( 0 ),
+    m_positionDispatches( 0 )
 {
+    m_dispatchTimer.setTimerType( Qt::PreciseTimer );
+    setDispatchRate( DefaultDispatchRate );
+    connect( &m_dispatchTimer, &QTimer::timeout, this, &RendererEventWatcher::dispatchPosition );
+}
+
+void
+RendererEventWatcher::setDispatchRate( double hz )
+{
+    if ( hz <= 0 )
+        hz = DefaultDispatchRate;
+    m_dispatchTimer.setInterval( qMax( 1, qRound( 1000.0 / hz ) ) );
+}
+
+qint64
+RendererEventWatcher::positionEvents() const
+{
+    return m_positionEvents.load( std::memory_order_relaxed );
+}
+
+qint64
+RendererEventWatcher::coalescedPositionEvents() const
+{
+    const auto events = m_positionEvents.load( std::memory_order_relaxed );
+    // A position still pending isn't coalesced yet
+    const auto pending = m_positionPending.load( std::memory_order_relaxed ) == true ? 1 : 0;
+    return qMax<qint64>( 0, events - m_positionDispatches.load( std::memory_order_relaxed ) - pending );
+}
+
+void
+RendererEventWatcher::startDispatch()
+{
+    // Already ticking, the next tick picks the position up
+    if ( m_dispatchTimer.isActive() == true )
+        return;
+    // Emit right away after an idle period, so that seeking doesn't wait for a tick
+    dispatchPosition();
+    m_dispatchTimer.start();
+}
+
+void
+RendererEventWatcher::dispatchPosition()
+{
+    if ( m_positionPending.exchange( false, std::memory_order_acq_rel ) == false )
+    {
+        // Nothing happened during a whole refresh, stop ticking until the next position
+        m_dispatchTimer.stop();
+        return;
+    }
+    m_positionDispatches.fetch_add( 1, std::memory_order_relaxed );
+    emit positionChanged( m_position.load( std::memory_order_relaxed ) );
 }
 
 void
@@ -47,6 +101,8 @@ RendererEventWatcher::onPaused()
 void
 RendererEventWatcher::onStopped()
 {
+    // Don't move the cursors back to a position reported before stopping
+    m_positionPending = false;
     emit stopped();
 }
 
@@ -65,7 +121,11 @@ RendererEventWatcher::onVolumeChanged()
 void
 RendererEventWatcher::onPositionChanged( int64_t pos )
 {
-    emit positionChanged( pos );
+    // Called from the rendering threads
+    m_position.store( pos, std::memory_order_relaxed );
+    m_positionEvents.fetch_add( 1, std::memory_order_relaxed );
+    if ( m_positionPending.exchange( true, std::memory_order_acq_rel ) == false )
+        QMetaObject::invokeMethod( this, "startDispatch", Qt::QueuedConnection );
 }
 
 void
@@ -79,3 +139,9 @@ RendererEventWatcher::onErrorEncountered()
 {
     emit errorEncountered();
 }
+
+void
+RendererEventWatcher::onPlaybackStats( int64_t droppedFrames, int64_t lateFrames )
+{
+    emit playbackStatsChanged( droppedFrames, lateFrames );
+}
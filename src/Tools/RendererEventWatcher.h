@@ -25,16 +25,40 @@
 #define RENDEREREVENTWATCHER_H
 
 #include <QObject>
+#include <QTimer>
 
 #include "Backend/IOutput.h"
 #include "Backend/IInput.h"
 
+#include <atomic>
+
+/**
+ *  \brief Converts the events of an output and an input to signals.
+ *
+ *  Positions are reported by the rendering threads for every frame, which is more than
+ *  anything in the GUI can display. Only the latest one is kept, and positionChanged()
+ *  is emitted from the watcher's thread at most once per display refresh, the events
+ *  received in between being coalesced.
+ */
 class RendererEventWatcher : public QObject, public Backend::IOutputEventCb, public Backend::IInputEventCb
 {
     Q_OBJECT
 public:
     explicit RendererEventWatcher(QObject *parent = 0);
 
+    /**
+     *  \brief Set how often positionChanged() may be emitted, usually the refresh
+     *          rate of the screen. Defaults to DefaultDispatchRate.
+     */
+    void            setDispatchRate( double hz );
+
+    /// Number of positions reported by the renderer
+    qint64          positionEvents() const;
+    /// Number of positions which were superseded before being emitted
+    qint64          coalescedPositionEvents() const;
+
+    static const int    DefaultDispatchRate = 60;
+
 private:
     virtual void    onPlaying();
     virtual void    onPaused();
@@ -44,6 +68,18 @@ private:
     virtual void    onPositionChanged( int64_t );
     virtual void    onLengthChanged( int64_t );
     virtual void    onErrorEncountered();
+    virtual void    onPlaybackStats( int64_t droppedFrames, int64_t lateFrames );
+
+private slots:
+    void            startDispatch();
+    void            dispatchPosition();
+
+private:
+    QTimer                  m_dispatchTimer;
+    std::atomic<int64_t>    m_position;
+    std::atomic_bool        m_positionPending;
+    std::atomic<int64_t>    m_positionEvents;
+    std::atomic<int64_t>    m_positionDispatches;
 
 signals:
     void            playing();
@@ -54,6 +90,7 @@ signals:
     void            positionChanged( qint64 );
     void            lengthChanged( qint64 );
     void            errorEncountered();
+    void            playbackStatsChanged( qint64 droppedFrames, qint64 lateFrames );
 };
 
 #endif // RENDEREREVENTWATCHER_H
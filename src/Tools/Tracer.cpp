@@ -0,0 +1,315 @@
+/*****************************************************************************
+ * Tracer.cpp: Records the pipeline activity in the Chrome trace format
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "Tracer.h"
+#include "Tools/VlmcDebug.h"
+
+#include <QFile>
+#include <QFileInfo>
+#include <QThread>
+
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <utility>
+#include <vector>
+
+std::atomic_bool    Tracer::s_enabled( false );
+
+namespace
+{
+
+struct Event
+{
+    const char*     name;
+    const char*     category;
+    int64_t         begin;
+    int64_t         duration;
+};
+
+// Blocks are allocated as needed, and kept for the next sessions
+const size_t        BlockSize = 16384;
+// Up to 4M events per thread and session, which is hours of rendering
+const size_t        MaxBlocks = 256;
+
+struct ThreadBuffer
+{
+    ThreadBuffer( int id )
+        : id( id )
+        , nativeId( 0 )
+        , generation( -1 )
+        , count( 0 )
+        , dropped( 0 )
+        , orphaned( false )
+    {
+        for ( auto& b : blocks )
+            b = nullptr;
+    }
+
+    ~ThreadBuffer()
+    {
+        for ( auto b : blocks )
+            delete[] b;
+    }
+
+    const int                   id;
+    quintptr                    nativeId;
+    // The session the events belong to, only written by the owning thread
+    std::atomic<int>            generation;
+    // Published once the event is written, so that write() can read up to it
+    std::atomic<size_t>         count;
+    std::atomic<uint64_t>       dropped;
+    // Set once the thread is gone, the buffer can then be reused by a new one
+    std::atomic_bool            orphaned;
+    Event*                      blocks[MaxBlocks];
+};
+
+/*
+ * Releases the buffer of a thread when it exits. MLT starts new threads each time a
+ * consumer starts, their buffers would otherwise pile up.
+ */
+struct BufferOwner
+{
+    BufferOwner() : buffer( nullptr ) {}
+    ~BufferOwner()
+    {
+        if ( buffer != nullptr )
+            buffer->orphaned = true;
+    }
+    ThreadBuffer*   buffer;
+};
+
+std::mutex                                      s_lock;
+std::vector<std::unique_ptr<ThreadBuffer>>      s_buffers;
+std::set<std::string>                           s_names;
+QString                                         s_output;
+int                                             s_depth = 0;
+int                                             s_nbSessions = 0;
+std::atomic<int64_t>                            s_sessionStart( 0 );
+std::atomic<int>                                s_generation( 0 );
+
+thread_local BufferOwner                        t_owner;
+
+ThreadBuffer*
+threadBuffer()
+{
+    if ( t_owner.buffer != nullptr )
+        return t_owner.buffer;
+    // Buffers outlive their thread, as the events must still be written at the end of
+    // the session. They are only reused once they don't hold any event of the current one.
+    std::lock_guard<std::mutex> lock( s_lock );
+    const auto generation = s_generation.load();
+    for ( const auto& b : s_buffers )
+    {
+        if ( b->orphaned == true && b->generation != generation )
+        {
+            t_owner.buffer = b.get();
+            break;
+        }
+    }
+    if ( t_owner.buffer == nullptr )
+    {
+        s_buffers.emplace_back( new ThreadBuffer( static_cast<int>( s_buffers.size() ) + 1 ) );
+        t_owner.buffer = s_buffers.back().get();
+    }
+    t_owner.buffer->orphaned = false;
+    t_owner.buffer->nativeId = reinterpret_cast<quintptr>( QThread::currentThreadId() );
+    return t_owner.buffer;
+}
+
+void
+appendEscaped( QByteArray& out, const char* str )
+{
+    for ( ; *str != 0; ++str )
+    {
+        if ( *str == '"' || *str == '\\' )
+            out += '\\';
+        if ( static_cast<unsigned char>( *str ) >= 0x20 )
+            out += *str;
+    }
+}
+
+}
+
+void
+Tracer::setOutput( const QString& path )
+{
+    s_output = path;
+    s_nbSessions = 0;
+}
+
+void
+Tracer::beginSession()
+{
+    if ( s_depth++ > 0 || s_output.isEmpty() == true )
+        return;
+    // Threads drop what they recorded for the previous sessions on their next event
+    ++s_generation;
+    s_sessionStart = now();
+    s_enabled = true;
+}
+
+void
+Tracer::endSession()
+{
+    Q_ASSERT( s_depth > 0 );
+    if ( --s_depth > 0 || s_enabled == false )
+        return;
+    s_enabled = false;
+    if ( s_output.isEmpty() == true )
+        return;
+
+    auto path = s_output;
+    if ( ++s_nbSessions > 1 )
+    {
+        QFileInfo info( s_output );
+        path = info.path() + '/' + info.completeBaseName() + '-' + QString::number( s_nbSessions );
+        if ( info.suffix().isEmpty() == false )
+            path += '.' + info.suffix();
+    }
+    write( path );
+}
+
+int64_t
+Tracer::now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch() ).count();
+}
+
+int64_t
+Tracer::sessionStart()
+{
+    return s_sessionStart.load( std::memory_order_relaxed );
+}
+
+void
+Tracer::record( const char* name, const char* category, int64_t begin, int64_t end )
+{
+    auto buffer = threadBuffer();
+    const auto generation = s_generation.load( std::memory_order_relaxed );
+    if ( buffer->generation.load( std::memory_order_relaxed ) != generation )
+    {
+        buffer->count.store( 0, std::memory_order_relaxed );
+        buffer->dropped.store( 0, std::memory_order_relaxed );
+        buffer->generation.store( generation, std::memory_order_release );
+    }
+    const auto n = buffer->count.load( std::memory_order_relaxed );
+    const auto block = n / BlockSize;
+    if ( block >= MaxBlocks )
+    {
+        buffer->dropped.fetch_add( 1, std::memory_order_relaxed );
+        return;
+    }
+    if ( buffer->blocks[block] == nullptr )
+        buffer->blocks[block] = new Event[BlockSize];
+    buffer->blocks[block][n % BlockSize] = Event{ name, category, begin, end - begin };
+    buffer->count.store( n + 1, std::memory_order_release );
+}
+
+const char*
+Tracer::intern( const std::string& name )
+{
+    std::lock_guard<std::mutex> lock( s_lock );
+    return s_names.insert( name ).first->c_str();
+}
+
+void
+Tracer::write( const QString& path )
+{
+    QFile file( path );
+    if ( file.open( QFile::WriteOnly | QFile::Truncate ) == false )
+    {
+        vlmcWarning() << "Can't write the trace to" << path << ':' << file.errorString();
+        return;
+    }
+
+    // Only the list of buffers is read under the lock, the threads starting meanwhile
+    // must not wait for the trace to be written. The buffers holding events of this
+    // session can't be reused by another thread until the next one starts.
+    const auto generation = s_generation.load();
+    std::vector<std::pair<const ThreadBuffer*, size_t>> buffers;
+    uint64_t nbDropped = 0;
+    {
+        std::lock_guard<std::mutex> lock( s_lock );
+        for ( const auto& b : s_buffers )
+        {
+            if ( b->generation.load( std::memory_order_acquire ) != generation )
+                continue;
+            const auto count = b->count.load( std::memory_order_acquire );
+            if ( count == 0 )
+                continue;
+            nbDropped += b->dropped.load( std::memory_order_relaxed );
+            buffers.emplace_back( b.get(), count );
+        }
+    }
+
+    size_t nbEvents = 0;
+    QByteArray out( "{\"traceEvents\":[\n" );
+    char buffer[128];
+    bool first = true;
+    for ( const auto& p : buffers )
+    {
+        const auto b = p.first;
+        const auto count = p.second;
+
+        snprintf( buffer, sizeof( buffer ), "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,"
+                  "\"args\":{\"name\":\"Thread 0x%llx\"}}", first == true ? "" : ",\n", b->id,
+                  static_cast<unsigned long long>( b->nativeId ) );
+        out += buffer;
+        first = false;
+
+        for ( size_t i = 0; i < count; ++i )
+        {
+            const auto& e = b->blocks[i / BlockSize][i % BlockSize];
+            out += ",\n{\"name\":\"";
+            appendEscaped( out, e.name != nullptr ? e.name : "" );
+            out += "\",\"cat\":\"";
+            appendEscaped( out, e.category );
+            // Microseconds, as the format expects
+            snprintf( buffer, sizeof( buffer ), "\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+                      b->id, ( e.begin - s_sessionStart ) / 1000.0, e.duration / 1000.0 );
+            out += buffer;
+            if ( out.size() > 1024 * 1024 )
+            {
+                file.write( out );
+                out.clear();
+            }
+        }
+        nbEvents += count;
+    }
+    out += "\n]}\n";
+    if ( file.write( out ) != out.size() )
+    {
+        vlmcWarning() << "Failed to write the trace to" << path << ':' << file.errorString();
+        return;
+    }
+    vlmcDebug() << "Wrote" << nbEvents << "trace events to" << path;
+    if ( nbDropped > 0 )
+        vlmcWarning() << nbDropped << "trace events were dropped, the per thread buffers are full";
+}
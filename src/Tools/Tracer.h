@@ -0,0 +1,125 @@
+/*****************************************************************************
+ * Tracer.h: Records the pipeline activity in the Chrome trace format
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef TRACER_H
+#define TRACER_H
+
+#include <QString>
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+/**
+ *  \brief  Records timed events while previewing or rendering, for chrome://tracing
+ *          or Perfetto.
+ *
+ *  Each thread appends its events to a buffer of its own, so recording is a couple of
+ *  clock reads and a store, without any lock. A session starts when a renderer starts
+ *  and the events are written to the output file once it ends, as a Chrome trace JSON
+ *  document. Sessions after the first one are written next to it, suffixed with their
+ *  number. Nothing is recorded unless an output file is set.
+ *
+ *  The MLT services are instrumented by Backend::MLT::MLTPipelineProbe.
+ */
+class Tracer
+{
+    public:
+        /// An empty path disables the tracing
+        static void         setOutput( const QString& path );
+
+        /**
+         *  \brief  Nested sessions are part of the outer one.
+         *
+         *  Must be called from the main thread.
+         */
+        static void         beginSession();
+        static void         endSession();
+
+        static bool         isEnabled()
+        {
+            return s_enabled.load( std::memory_order_relaxed );
+        }
+
+        /// Nanoseconds, from a monotonic clock
+        static int64_t      now();
+        /// The now() value when the current, or last, session started
+        static int64_t      sessionStart();
+
+        /**
+         *  \brief  Record an event which happened on the calling thread.
+         *
+         *  \param  name        Must outlive the session, use intern() if it doesn't.
+         *  \param  category    Must outlive the session.
+         */
+        static void         record( const char* name, const char* category, int64_t begin, int64_t end );
+        /// Returns a copy of \a name which lives as long as the application
+        static const char*  intern( const std::string& name );
+
+        /**
+         *  \brief  Records the lifetime of the scope, if tracing.
+         */
+        class Scope
+        {
+            public:
+                Scope( const char* name, const char* category )
+                    : m_name( name )
+                    , m_category( category )
+                    , m_begin( isEnabled() == true ? now() : -1 )
+                {
+                }
+
+                ~Scope()
+                {
+                    if ( m_begin >= 0 )
+                        record( m_name, m_category, m_begin, now() );
+                }
+
+                Scope( const Scope& ) = delete;
+                Scope& operator=( const Scope& ) = delete;
+
+            private:
+                const char*     m_name;
+                const char*     m_category;
+                int64_t         m_begin;
+        };
+
+        /**
+         *  \brief  Holds a session for the lifetime of the scope.
+         */
+        class Session
+        {
+            public:
+                Session() { beginSession(); }
+                ~Session() { endSession(); }
+                Session( const Session& ) = delete;
+                Session& operator=( const Session& ) = delete;
+        };
+
+    private:
+        static void         write( const QString& path );
+
+    private:
+        static std::atomic_bool     s_enabled;
+};
+
+#endif // TRACER_H
@@ -0,0 +1,94 @@
+/*****************************************************************************
+ * TripleBuffer.h: Lock-free triple buffer
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef TRIPLEBUFFER_H
+#define TRIPLEBUFFER_H
+
+#include <atomic>
+
+/**
+ *  \brief  Hands values over from one thread to another without allocating or waiting.
+ *
+ *  The writer fills writeBuffer() and publishes it, the reader picks the latest
+ *  published buffer up with update() and reads it from readBuffer() for as long as it
+ *  needs. Neither ever waits for the other: a published buffer the reader didn't pick
+ *  up yet is handed back to the writer to be filled again. The three buffers are
+ *  reused over and over, so values owning memory keep it allocated.
+ */
+template <typename T>
+class TripleBuffer
+{
+    public:
+        TripleBuffer()
+            : m_middle( 1 )
+            , m_write( 0 )
+            , m_read( 2 )
+        {
+        }
+
+        TripleBuffer( const TripleBuffer& ) = delete;
+        TripleBuffer& operator=( const TripleBuffer& ) = delete;
+
+        /// Only call from the writer thread
+        T&      writeBuffer()
+        {
+            return m_buffers[m_write];
+        }
+
+        /// Only call from the writer thread
+        void    publish()
+        {
+            auto previous = m_middle.exchange( m_write | Fresh, std::memory_order_acq_rel );
+            m_write = previous & IndexMask;
+        }
+
+        /**
+         *  \brief  Switch to the last published buffer. Only call from the reader thread.
+         *  \return false if nothing was published since the last update
+         */
+        bool    update()
+        {
+            if ( ( m_middle.load( std::memory_order_relaxed ) & Fresh ) == 0 )
+                return false;
+            auto previous = m_middle.exchange( m_read, std::memory_order_acq_rel );
+            m_read = previous & IndexMask;
+            return true;
+        }
+
+        /// Only call from the reader thread
+        const T&    readBuffer() const
+        {
+            return m_buffers[m_read];
+        }
+
+    private:
+        static const int    IndexMask = 3;
+        static const int    Fresh = 4;
+
+        T                   m_buffers[3];
+        // The buffer between the writer and the reader, flagged Fresh once published
+        std::atomic<int>    m_middle;
+        int                 m_write;
+        int                 m_read;
+};
+
+#endif // TRIPLEBUFFER_H
@@ -33,11 +33,19 @@ inline QDebug operator<<( QDebug& qdbg, const std::string& str )
     return qdbg;
 }
 
-inline QDebug vlmcDebug()
+/// Whether debug messages are shown or logged to a file, see VlmcLogger
+bool vlmcDebugEnabled();
+
+inline QDebug vlmcDebugStream()
 {
     return (qDebug().nospace() << '[' << qPrintable(QTime::currentTime().toString("hh:mm:ss.zzz")) << "] T #" << QThread::currentThreadId() << " D:").space();
 }
 
+/// Doesn't even format the message when it would be discarded
+#define vlmcDebug() \
+    for ( bool vlmcDebugOn = vlmcDebugEnabled(); vlmcDebugOn == true; vlmcDebugOn = false ) \
+        vlmcDebugStream()
+
 inline QDebug vlmcWarning()
 {
     return (qWarning().nospace() << '[' << qPrintable(QTime::currentTime().toString("hh:mm:ss.zzz")) << "] T #" << QThread::currentThreadId() << " W:").space();
@@ -26,6 +26,7 @@
 #endif
 
 #include <QCoreApplication>
+#include <QDateTime>
 #include <QStringList>
 #include <QThread>
 
@@ -34,9 +35,20 @@
 #include "Tools/VlmcLogger.h"
 #include "Tools/VlmcDebug.h"
 
+#include <cstring>
+
+// Until the logger is set up, everything goes to Qt's default handler
+static std::atomic_bool     s_debugEnabled( true );
+
+bool
+vlmcDebugEnabled()
+{
+    return s_debugEnabled.load( std::memory_order_relaxed );
+}
 
 VlmcLogger::VlmcLogger()
     : m_logFile( nullptr )
+    , m_currentLogLevel( Quiet )
     , m_backendLogLevel( Backend::IBackend::None )
 {
 }
@@ -44,6 +56,10 @@ VlmcLogger::VlmcLogger()
 VlmcLogger::~VlmcLogger()
 {
     qInstallMessageHandler( 0 );
+    // The backend's messages go through the ring as well
+    Backend::instance()->setLogHandler( nullptr );
+    // Writes what's still queued
+    m_ring.reset();
     if ( m_logFile )
         fclose( m_logFile );
 }
@@ -62,7 +78,7 @@ VlmcLogger::setup()
         m_currentLogLevel = VlmcLogger::Verbose;
     else
         m_currentLogLevel = VlmcLogger::Quiet;
-	logLevel->set( m_currentLogLevel );
+	logLevel->set( m_currentLogLevel.load() );
 	connect( logLevel, SIGNAL( changed(QVariant) ), this, SLOT( logLevelChanged( QVariant ) ) );
 
     int pos = args.indexOf( QRegExp( "--logfile=.*" ) );
@@ -103,8 +119,13 @@ VlmcLogger::setup()
                 vlmcWarning() << tr("Invalid value supplied for argument --backendverbose" );
         }
     }
+    m_ring.reset( new LogRing( [this]( const LogRing::Message& message ) {
+        write( message );
+    } ) );
+    updateLogLevels();
+
     auto* backend = Backend::instance();
-    backend->setLogHandler( [this]( Backend::IBackend::LogLevel lvl, const QString& msg ) {
+    backend->setLogHandler( [this]( Backend::IBackend::LogLevel lvl, const char* msg ) {
         backendLogHandler( lvl, msg );
     } );
 
@@ -118,13 +139,62 @@ VlmcLogger::logLevelChanged( const QVariant &logLevel )
     Q_ASSERT_X(logLevel.toInt() >= (int)VlmcLogger::Debug &&
                logLevel.toInt() <= (int)VlmcLogger::Quiet,
                "Setting log level", "Invalid value for log level");
-    m_currentLogLevel = (VlmcLogger::LogLevel)logLevel.toInt();
+    m_currentLogLevel = logLevel.toInt();
+    updateLogLevels();
+}
+
+void
+VlmcLogger::updateLogLevels()
+{
+    // The log file gets everything, whatever the console shows
+    s_debugEnabled = m_logFile != nullptr || m_currentLogLevel.load() <= Debug;
+    // It used to get the backend warnings with MLT's default level, keep it that way
+    auto backendLevel = m_backendLogLevel;
+    if ( m_logFile != nullptr && backendLevel > Backend::IBackend::Warning )
+        backendLevel = Backend::IBackend::Warning;
+    Backend::instance()->setLogLevel( backendLevel );
 }
 
 /*********************************************************************
 * Don't use anything which might use qDebug/qWarning/... below here. *
 *********************************************************************/
 
+void
+VlmcLogger::log( int level, bool console, const char* prefix, const char* msg )
+{
+    auto message = m_ring->claim();
+    // Counted as dropped by the ring, waiting for room would stall the calling thread
+    if ( message == nullptr )
+        return;
+    message->level = level;
+    message->console = console;
+    message->showTime = prefix != nullptr;
+    if ( prefix != nullptr )
+        snprintf( message->text, sizeof( message->text ), "%s%s", prefix, msg );
+    else
+        snprintf( message->text, sizeof( message->text ), "%s", msg );
+    m_ring->publish( message );
+}
+
+void
+VlmcLogger::write( const LogRing::Message& message )
+{
+    // Called from the ring's thread
+    const int level = message.level < 0 ? (int)QtWarningMsg : message.level;
+    QByteArray stamped;
+    const char* msg = message.text;
+    if ( message.showTime == true )
+    {
+        stamped = '[' + QDateTime::fromMSecsSinceEpoch( message.time ).toString( "hh:mm:ss.zzz" ).toLatin1()
+                + "] " + message.text;
+        msg = stamped.constData();
+    }
+    if ( m_logFile != nullptr )
+        writeToFile( msg );
+    if ( message.console == true )
+        outputToConsole( level, msg );
+}
+
 void
 VlmcLogger::writeToFile(const char *msg)
 {
@@ -137,22 +207,30 @@ VlmcLogger::writeToFile(const char *msg)
 void
 VlmcLogger::vlmcMessageHandler( QtMsgType type, const QMessageLogContext&, const QString& str )
 {
+    VlmcLogger* self = Core::instance()->logger();
+    const bool console = (int)type >= self->m_currentLogLevel.load( std::memory_order_relaxed );
+    if ( console == false && self->m_logFile == nullptr )
+        return;
+
     const QByteArray byteArray = str.toLocal8Bit();
     const char* msg = byteArray.constData();
 
-    VlmcLogger* self = Core::instance()->logger();
-    if ( self->m_logFile != nullptr )
+    if ( type == QtFatalMsg )
     {
-        //FIXME: Messages are not guaranteed to arrive in order
-        self->writeToFile(msg);
+        // Let the queued messages out first, nothing is written once aborted
+        self->m_ring->flush();
+        if ( self->m_logFile != nullptr )
+            self->writeToFile( msg );
+        self->outputToConsole( (int)type, msg );
+        return;
     }
-    self->outputToConsole( (int)type, msg );
+    self->log( (int)type, console, nullptr, msg );
 }
 
 void
 VlmcLogger::outputToConsole( int level, const char *msg )
 {
-    if ( level < (int)m_currentLogLevel )
+    if ( level < m_currentLogLevel.load( std::memory_order_relaxed ) )
         return ;
     switch ( (QtMsgType)level )
     {
@@ -171,33 +249,31 @@ VlmcLogger::outputToConsole( int level, const char *msg )
 }
 
 void
-VlmcLogger::backendLogHandler( Backend::IBackend::LogLevel logLevel, const QString& msg )
+VlmcLogger::backendLogHandler( Backend::IBackend::LogLevel logLevel, const char* msg )
 {
-    char* newMsg = nullptr;
-    if ( asprintf( &newMsg, "[%s] T #%p [Backend] %s", qPrintable( QTime::currentTime().toString( "hh:mm:ss.zzz" ) ),
-              QThread::currentThreadId(), qPrintable( msg ) ) < 0 )
-        return ;
-
-    if ( m_logFile != nullptr )
-        writeToFile( newMsg );
-    if ( logLevel < m_backendLogLevel )
-    {
-        free( newMsg );
-        return ;
-    }
+    // Called from the backend threads
+    int level;
     switch ( logLevel )
     {
         case Backend::IBackend::Debug:
-            outputToConsole( Debug, newMsg );
+            level = Debug;
             break;
         case Backend::IBackend::Warning:
-            outputToConsole( Verbose, newMsg );
+            level = Verbose;
             break;
         case Backend::IBackend::Error:
-            outputToConsole( Quiet, newMsg );
+            level = Quiet;
             break;
         default:
             Q_ASSERT(false);
+            return;
     }
-    free( newMsg );
+    const bool console = logLevel >= m_backendLogLevel &&
+            level >= m_currentLogLevel.load( std::memory_order_relaxed );
+    if ( console == false && m_logFile == nullptr )
+        return;
+
+    char prefix[64];
+    snprintf( prefix, sizeof( prefix ), "T #%p [Backend] ", reinterpret_cast<void*>( QThread::currentThreadId() ) );
+    log( level, console, prefix, msg );
 }
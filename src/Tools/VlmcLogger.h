@@ -24,13 +24,19 @@
 #define VLMCDEBUG_H
 
 #include <QObject>
+#include <atomic>
 #include <cstdio>
+#include <memory>
 
 #include "Backend/IBackend.h"
+#include "Tools/LogRing.h"
 
 /**
  *  \warning    Do not use qDebug() qWarning() etc... from here, unless you know exactly what you're doing
  *              Chances are very high that you end up with a stack overflow !!
+ *
+ *  Once setup() is called, messages are filtered on the calling thread, then queued
+ *  in a LogRing and written to the console and the log file by its thread.
  */
 class   VlmcLogger : public QObject
 {
@@ -50,16 +56,21 @@ class   VlmcLogger : public QObject
         };
 
         static void     vlmcMessageHandler(QtMsgType type, const QMessageLogContext& context, const QString& str );
-        void            backendLogHandler( Backend::IBackend::LogLevel logLevel, const QString& msg );
+        void            backendLogHandler( Backend::IBackend::LogLevel logLevel, const char* msg );
 
         void            setup();
     private:
+        /// Queue a message, the prefix is only used for the backend messages
+        void            log( int level, bool console, const char* prefix, const char* msg );
+        void            write( const LogRing::Message& message );
         void            writeToFile(const char* msg);
         void            outputToConsole( int level, const char* msg );
+        void            updateLogLevels();
 
         FILE*                           m_logFile;
-        LogLevel                        m_currentLogLevel;
+        std::atomic<int>                m_currentLogLevel;
         Backend::IBackend::LogLevel     m_backendLogLevel;
+        std::unique_ptr<LogRing>        m_ring;
 
     private slots:
         void            logLevelChanged( const QVariant& logLevel );
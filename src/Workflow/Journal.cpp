@@ -0,0 +1,402 @@
+/*****************************************************************************
+ * Journal.cpp: Write-ahead journal of the timeline edits
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "Journal.h"
+#include "SequenceWorkflow.h"
+#include "EffectsEngine/EffectHelper.h"
+#include "Library/Library.h"
+#include "Main/Core.h"
+#include "Media/Clip.h"
+#include "Media/Media.h"
+#include "Settings/Settings.h"
+#include "Settings/SettingValue.h"
+#include "Tools/VlmcDebug.h"
+#include "Transition/Transition.h"
+
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QSaveFile>
+
+Journal::Journal( SequenceWorkflow* sequence, Settings* settings, QObject* parent )
+    : QObject( parent )
+    , m_sequence( sequence )
+    , m_hasEdits( false )
+{
+    m_checkpoint = settings->createVar( SettingValue::String, "journalCheckpoint", QString(), "", "",
+                                        SettingValue::Private );
+
+    auto touchClip = [this]( const QString& uuid ) { touch( true, uuid ); };
+    auto touchClips = [this]( const QString& uuidA, const QString& uuidB )
+    {
+        touch( true, uuidA );
+        touch( true, uuidB );
+    };
+    auto touchTransition = [this]( const QString& uuid ) { touch( false, uuid ); };
+    connect( sequence, &SequenceWorkflow::clipAdded, this, touchClip );
+    connect( sequence, &SequenceWorkflow::clipRemoved, this, touchClip );
+    connect( sequence, &SequenceWorkflow::clipMoved, this, touchClip );
+    connect( sequence, &SequenceWorkflow::clipResized, this, touchClip );
+    connect( sequence, &SequenceWorkflow::clipLinked, this, touchClips );
+    connect( sequence, &SequenceWorkflow::clipUnlinked, this, touchClips );
+    connect( sequence, &SequenceWorkflow::transitionAdded, this, touchTransition );
+    connect( sequence, &SequenceWorkflow::transitionMoved, this, touchTransition );
+    connect( sequence, &SequenceWorkflow::transitionRemoved, this, touchTransition );
+}
+
+int
+Journal::open( const QString& path )
+{
+    if ( m_file.isOpen() == true )
+        m_file.close();
+    m_markers.clear();
+    m_touched.clear();
+    m_touchedSet.clear();
+    m_hasEdits = false;
+    m_file.setFileName( path );
+
+    const auto checkpoint = m_checkpoint->get().toString();
+    QList<QJsonObject> records;
+    qint64 markerOffset = -1;
+    qint64 end = 0;
+    if ( m_file.open( QFile::ReadOnly ) == true )
+    {
+        while ( m_file.atEnd() == false )
+        {
+            const auto offset = m_file.pos();
+            QJsonParseError error;
+            const auto doc = QJsonDocument::fromJson( m_file.readLine(), &error );
+            // The last line may have been cut by a crash
+            if ( error.error != QJsonParseError::NoError || doc.isObject() == false )
+                break;
+            end = m_file.pos();
+            const auto record = doc.object();
+            if ( record.contains( "checkpoint" ) == true )
+            {
+                if ( record["checkpoint"].toString() == checkpoint )
+                {
+                    markerOffset = offset;
+                    records.clear();
+                }
+                continue;
+            }
+            if ( markerOffset >= 0 )
+                records.append( record );
+        }
+        m_file.close();
+    }
+
+    // The edits are replayed before journaling again, so they aren't journaled twice
+    for ( const auto& record : records )
+        replay( record );
+    m_hasEdits = records.isEmpty() == false;
+    if ( m_hasEdits == true )
+        vlmcDebug() << "Replayed" << records.size() << "edits from" << path;
+
+    if ( markerOffset >= 0 )
+    {
+        // Carry on with the loaded checkpoint, dropping what a crash may have cut
+        if ( m_file.open( QFile::ReadWrite | QFile::Append ) == false || m_file.resize( end ) == false )
+        {
+            vlmcWarning() << "Can't write the journal" << path << ':' << m_file.errorString();
+            m_file.close();
+            return records.size();
+        }
+        m_markers.enqueue( qMakePair( checkpoint, markerOffset ) );
+        return records.size();
+    }
+
+    // The journal, if any, doesn't belong to the loaded save
+    if ( m_file.open( QFile::ReadWrite | QFile::Truncate | QFile::Append ) == false )
+    {
+        vlmcWarning() << "Can't write the journal" << path << ':' << m_file.errorString();
+        return 0;
+    }
+    appendMarker();
+    return 0;
+}
+
+void
+Journal::discard()
+{
+    if ( m_file.isOpen() == false )
+        return;
+    m_file.close();
+    m_file.remove();
+    m_markers.clear();
+    m_touched.clear();
+    m_touchedSet.clear();
+    m_hasEdits = false;
+}
+
+bool
+Journal::isOpen() const
+{
+    return m_file.isOpen();
+}
+
+bool
+Journal::hasEdits() const
+{
+    return m_hasEdits;
+}
+
+QString
+Journal::checkpoint()
+{
+    // The snapshot is taken after this, so it includes the edits of the pending command
+    if ( m_touched.isEmpty() == false )
+        commandDone();
+    m_checkpoint->set( QUuid::createUuid().toString() );
+    if ( m_file.isOpen() == true )
+        appendMarker();
+    m_hasEdits = false;
+    return m_checkpoint->get().toString();
+}
+
+void
+Journal::compact( const QString& checkpoint )
+{
+    // Saves complete in order, the markers of the previous ones are obsolete anyway
+    while ( m_markers.isEmpty() == false && m_markers.head().first != checkpoint )
+        m_markers.dequeue();
+    if ( m_markers.isEmpty() == true || m_file.isOpen() == false )
+        return;
+    const auto offset = m_markers.head().second;
+    if ( offset == 0 )
+        return;
+
+    if ( m_file.seek( offset ) == false )
+        return;
+    const auto tail = m_file.readAll();
+    QSaveFile file( m_file.fileName() );
+    if ( file.open( QFile::WriteOnly ) == false || file.write( tail ) != tail.size() ||
+         file.commit() == false )
+    {
+        vlmcWarning() << "Can't compact the journal" << m_file.fileName() << ':' << file.errorString();
+        return;
+    }
+    // The journal was replaced, write to the new one
+    m_file.close();
+    if ( m_file.open( QFile::ReadWrite | QFile::Append ) == false )
+    {
+        vlmcWarning() << "Can't write the journal" << m_file.fileName() << ':' << m_file.errorString();
+        m_markers.clear();
+        return;
+    }
+    for ( auto& marker : m_markers )
+        marker.second -= offset;
+}
+
+void
+Journal::commandDone()
+{
+    if ( m_file.isOpen() == false )
+        return;
+    if ( m_touched.isEmpty() == true )
+    {
+        // The command changed something the journal doesn't cover, such as an effect
+        emit compactionRequired();
+        return;
+    }
+
+    QJsonArray clips;
+    QJsonArray transitions;
+    for ( const auto& t : m_touched )
+    {
+        if ( t.first == true )
+            clips.append( clipState( t.second ) );
+        else
+            transitions.append( transitionState( t.second ) );
+    }
+    m_touched.clear();
+    m_touchedSet.clear();
+
+    if ( append( QJsonObject{ { "clips", clips }, { "transitions", transitions } } ) == false )
+        return;
+    m_hasEdits = true;
+    if ( m_file.size() > MaxSize )
+        emit compactionRequired();
+}
+
+void
+Journal::touch( bool isClip, const QString& uuid )
+{
+    if ( m_file.isOpen() == false )
+        return;
+    // The state is only read once the command is done, so each object is written once
+    QUuid u( uuid );
+    if ( m_touchedSet.contains( u ) == true )
+        return;
+    m_touchedSet.insert( u );
+    m_touched.append( qMakePair( isClip, u ) );
+}
+
+QJsonObject
+Journal::clipState( const QUuid& uuid ) const
+{
+    auto c = m_sequence->clip( uuid );
+    if ( c == nullptr )
+        return QJsonObject{ { "uuid", uuid.toString() }, { "removed", true } };
+
+    QJsonArray linkedClips;
+    for ( const auto& linkedClipUuid : c->linkedClips )
+        linkedClips.append( linkedClipUuid.toString() );
+    QJsonObject res{
+        { "uuid", uuid.toString() },
+        { "clipUuid", c->clip->uuid().toString() },
+        { "begin", c->clip->begin() },
+        { "end", c->clip->end() },
+        { "position", c->pos },
+        { "trackId", static_cast<qint64>( c->trackId ) },
+        { "isAudio", c->isAudio },
+        { "linkedClips", linkedClips },
+        { "filters", QJsonValue::fromVariant( EffectHelper::toVariant( c->clip->input() ) ) },
+    };
+    // Cuts made by resizing are only saved with the library, fall back to their media
+    auto baseClip = c->clip->media()->baseClip();
+    if ( baseClip != nullptr )
+        res["baseClipUuid"] = baseClip->uuid().toString();
+    return res;
+}
+
+QJsonObject
+Journal::transitionState( const QUuid& uuid ) const
+{
+    auto t = m_sequence->transition( uuid );
+    if ( t == nullptr )
+        return QJsonObject{ { "uuid", uuid.toString() }, { "removed", true } };
+    return QJsonObject::fromVariantHash( t->toVariant().toHash() );
+}
+
+bool
+Journal::append( const QJsonObject& record )
+{
+    // One write per line, so that a crash can only cut the last one
+    const auto line = QJsonDocument( record ).toJson( QJsonDocument::Compact ) + '\n';
+    if ( m_file.write( line ) != line.size() || m_file.flush() == false )
+    {
+        vlmcWarning() << "Can't write the journal" << m_file.fileName() << ':' << m_file.errorString();
+        return false;
+    }
+    return true;
+}
+
+bool
+Journal::appendMarker()
+{
+    const auto checkpoint = m_checkpoint->get().toString();
+    const auto offset = m_file.size();
+    if ( append( QJsonObject{ { "checkpoint", checkpoint } } ) == false )
+        return false;
+    m_markers.enqueue( qMakePair( checkpoint, offset ) );
+    return true;
+}
+
+void
+Journal::replay( const QJsonObject& record )
+{
+    // Take everything the edit touched out first, so that putting it back in its final
+    // state can't overlap a clip which hasn't moved yet.
+    QHash<QUuid, QSharedPointer<Clip>> removedClips;
+    const auto clips = record["clips"].toArray();
+    for ( const auto& v : clips )
+    {
+        const QUuid uuid( v.toObject()["uuid"].toString() );
+        if ( m_sequence->clip( uuid ) != nullptr )
+            removedClips[uuid] = m_sequence->removeClip( uuid )->clip;
+    }
+    const auto transitions = record["transitions"].toArray();
+    for ( const auto& v : transitions )
+    {
+        const QUuid uuid( v.toObject()["uuid"].toString() );
+        if ( m_sequence->transition( uuid ) != nullptr )
+            m_sequence->removeTransition( uuid );
+    }
+
+    auto library = Core::instance()->library();
+    for ( const auto& v : clips )
+    {
+        const auto state = v.toObject();
+        if ( state["removed"].toBool() == true )
+            continue;
+        const QUuid uuid( state["uuid"].toString() );
+        auto clip = removedClips.value( uuid );
+        const bool isNew = clip == nullptr;
+        if ( clip == nullptr )
+            clip = library->clip( QUuid( state["clipUuid"].toString() ) );
+        if ( clip == nullptr )
+            clip = library->clip( QUuid( state["baseClipUuid"].toString() ) );
+        if ( clip == nullptr )
+        {
+            vlmcWarning() << "Can't restore clip" << uuid << ": its media is missing";
+            continue;
+        }
+        const auto begin = state["begin"].toVariant().toLongLong();
+        const auto end = state["end"].toVariant().toLongLong();
+        const auto pos = state["position"].toVariant().toLongLong();
+        if ( m_sequence->addClip( clip, state["trackId"].toVariant().toUInt(), pos, uuid,
+                                  state["isAudio"].toBool() ).isNull() == true )
+        {
+            vlmcWarning() << "Can't restore clip" << uuid;
+            continue;
+        }
+        if ( clip->begin() != begin || clip->end() != end )
+            m_sequence->resizeClip( uuid, begin, end, pos );
+        auto instance = m_sequence->clip( uuid );
+        if ( isNew == true )
+            EffectHelper::loadFromVariant( state["filters"].toVariant(), instance->clip->input() );
+        for ( const auto& linked : state["linkedClips"].toArray() )
+        {
+            const QUuid linkedUuid( linked.toString() );
+            if ( instance->linkedClips.contains( linkedUuid ) == true )
+                continue;
+            auto other = m_sequence->clip( linkedUuid );
+            // The other clip keeps its side of a link when this one is put back
+            if ( other != nullptr && other->linkedClips.contains( uuid ) == false )
+                m_sequence->linkClips( uuid, linkedUuid );
+            else
+                instance->linkedClips.append( linkedUuid );
+        }
+    }
+
+    for ( const auto& v : transitions )
+    {
+        const auto state = v.toObject();
+        if ( state["removed"].toBool() == true )
+            continue;
+        const auto type = state["audio"].toBool() == true ? Workflow::AudioTrack : Workflow::VideoTrack;
+        auto transition = QSharedPointer<Transition>::create( state["identifier"].toString(),
+                                                              state["begin"].toVariant().toLongLong(),
+                                                              state["end"].toVariant().toLongLong(), type );
+        transition->setUuid( QUuid( state["uuid"].toString() ) );
+        const bool isInTrack = state["isInTrack"].toBool();
+        const auto trackAId = state[isInTrack == true ? "trackId" : "trackAId"].toVariant().toUInt();
+        const auto trackBId = state["trackBId"].toVariant().toUInt();
+        m_sequence->addTransition( QSharedPointer<SequenceWorkflow::TransitionInstance>::create(
+                                       transition, trackAId, trackBId, isInTrack ) );
+    }
+}
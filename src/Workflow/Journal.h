@@ -0,0 +1,118 @@
+/*****************************************************************************
+ * Journal.h: Write-ahead journal of the timeline edits
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include <QFile>
+#include <QJsonObject>
+#include <QObject>
+#include <QPair>
+#include <QQueue>
+#include <QSet>
+#include <QString>
+#include <QUuid>
+#include <QVector>
+
+class SequenceWorkflow;
+class SettingValue;
+class Settings;
+
+/**
+ *  \brief  Appends the timeline edits to a file, to recover them after a crash.
+ *
+ *  Each command pushed, undone or redone on the undo stack appends one line to the
+ *  journal, holding the final state of the clips and transitions it touched. Lines
+ *  are written at once and flushed, so a crash loses at most the edit being written.
+ *
+ *  Every full save is a checkpoint: a unique id is saved along with the project, and
+ *  appended to the journal as a marker. Once the save is written, what precedes the
+ *  marker is dropped. Loading a project replays the lines following the marker of
+ *  its checkpoint, if the journal has one.
+ */
+class Journal : public QObject
+{
+    Q_OBJECT
+
+    public:
+        /// Past this size, the journal asks to be compacted into a full save
+        static const qint64     MaxSize = 4 * 1024 * 1024;
+
+        /**
+         *  \param  settings    The settings in which the checkpoint is saved
+         */
+        Journal( SequenceWorkflow* sequence, Settings* settings, QObject* parent = nullptr );
+
+        /**
+         *  \brief  Replay the edits following the loaded save, and journal the next ones.
+         *
+         *  Must be called once the project is loaded.
+         *  \return The number of edits replayed
+         */
+        int             open( const QString& path );
+        /**
+         *  \brief  Stop journaling and remove the journal, when the project is closed.
+         */
+        void            discard();
+        bool            isOpen() const;
+        /// true if edits were journaled since the last checkpoint
+        bool            hasEdits() const;
+
+        /**
+         *  \brief  Start a new checkpoint, before taking a snapshot of the project.
+         *  \return The id of the checkpoint
+         */
+        QString         checkpoint();
+        /**
+         *  \brief  The save of \p checkpoint was written, the previous edits can go.
+         */
+        void            compact( const QString& checkpoint );
+
+    public slots:
+        /// Connected to the undo stack, appends the edits of the command
+        void            commandDone();
+
+    signals:
+        /// The journal grew large, the project should be saved
+        void            compactionRequired();
+
+    private:
+        void            touch( bool isClip, const QString& uuid );
+        QJsonObject     clipState( const QUuid& uuid ) const;
+        QJsonObject     transitionState( const QUuid& uuid ) const;
+        bool            append( const QJsonObject& record );
+        void            replay( const QJsonObject& record );
+        bool            appendMarker();
+
+    private:
+        SequenceWorkflow*       m_sequence;
+        SettingValue*           m_checkpoint;
+        QFile                   m_file;
+        // The checkpoints of the saves being written, and the offset of their marker
+        QQueue<QPair<QString, qint64>>  m_markers;
+        // The clips (true) & transitions (false) touched by the current command, in order
+        QVector<QPair<bool, QUuid>>     m_touched;
+        QSet<QUuid>             m_touchedSet;
+        bool                    m_hasEdits;
+};
+
+#endif // JOURNAL_H
@@ -43,24 +43,34 @@
 #include "Media/Media.h"
 #include "Library/Library.h"
 #include "MainWorkflow.h"
+#include "Journal.h"
+#include "Prefetcher.h"
 #include "Project/Project.h"
 #include "SequenceWorkflow.h"
 #include "Settings/Settings.h"
 #include "Tools/VlmcDebug.h"
 #include "Tools/RendererEventWatcher.h"
 #include "Tools/OutputEventWatcher.h"
+#include "Tools/Tracer.h"
 #include "Transition/Transition.h"
 #include "Workflow/Types.h"
 
+#include <QCryptographicHash>
+#include <QEventLoop>
 #include <QJsonArray>
+#include <QJsonDocument>
 #include <QMutex>
+#include <QStringList>
+#include <QTimer>
 
 MainWorkflow::MainWorkflow( Settings* projectSettings, int trackCount ) :
         m_trackCount( trackCount ),
         m_settings( new Settings ),
         m_renderer( new AbstractRenderer ),
         m_undoStack( new Commands::AbstractUndoStack ),
-        m_sequenceWorkflow( new SequenceWorkflow( trackCount ) )
+        m_sequenceWorkflow( new SequenceWorkflow( trackCount ) ),
+        m_prefetcher( new Prefetcher( m_sequenceWorkflow.get(), m_renderer ) ),
+        m_editCount( 0 )
 {
     connect( m_sequenceWorkflow.get(), &SequenceWorkflow::clipAdded, this, &MainWorkflow::clipAdded );
     connect( m_sequenceWorkflow.get(), &SequenceWorkflow::clipRemoved, this, &MainWorkflow::clipRemoved );
@@ -71,7 +81,28 @@ MainWorkflow::MainWorkflow( Settings* projectSettings, int trackCount ) :
     connect( m_sequenceWorkflow.get(), &SequenceWorkflow::transitionAdded, this, &MainWorkflow::transitionAdded );
     connect( m_sequenceWorkflow.get(), &SequenceWorkflow::transitionMoved, this, &MainWorkflow::transitionMoved );
     connect( m_sequenceWorkflow.get(), &SequenceWorkflow::transitionRemoved, this, &MainWorkflow::transitionRemoved );
+    connect( m_sequenceWorkflow.get(), &SequenceWorkflow::clipAdded, m_prefetcher.get(), &Prefetcher::reset );
+    connect( m_sequenceWorkflow.get(), &SequenceWorkflow::clipRemoved, m_prefetcher.get(), &Prefetcher::reset );
+    connect( m_sequenceWorkflow.get(), &SequenceWorkflow::clipMoved, m_prefetcher.get(), &Prefetcher::reset );
+    connect( m_sequenceWorkflow.get(), &SequenceWorkflow::clipResized, m_prefetcher.get(), &Prefetcher::reset );
     m_renderer->setInput( m_sequenceWorkflow->input() );
+    // The timeline has no keyframes of its own, use those of the video clip shown under
+    // the playhead: the tractor shows the highest track which isn't blank.
+    m_renderer->setKeyframeLookup( [this]( qint64 frame ) -> qint64
+    {
+        QSharedPointer<SequenceWorkflow::ClipInstance> top;
+        for ( const auto& c : m_sequenceWorkflow->clipsAt( frame ) )
+        {
+            if ( c->isAudio == false && ( top == nullptr || c->trackId > top->trackId ) )
+                top = c;
+        }
+        if ( top == nullptr )
+            return -1;
+        auto keyframe = top->clip->input()->keyframeBefore( frame - top->pos );
+        if ( keyframe < 0 )
+            return -1;
+        return top->pos + keyframe;
+    } );
 
     connect( m_renderer->eventWatcher().data(), &RendererEventWatcher::lengthChanged, this, &MainWorkflow::lengthChanged );
     connect( m_renderer->eventWatcher().data(), &RendererEventWatcher::endReached, this, &MainWorkflow::mainWorkflowEndReached );
@@ -79,13 +110,29 @@ MainWorkflow::MainWorkflow( Settings* projectSettings, int trackCount ) :
     {
         emit frameChanged( pos, m_sequenceWorkflow->input()->playableLength(), Vlmc::Renderer );
     }, Qt::DirectConnection );
+    connect( m_renderer->eventWatcher().data(), &RendererEventWatcher::positionChanged,
+             m_prefetcher.get(), &Prefetcher::positionChanged );
 
     m_settings->createVar( SettingValue::List, "tracks", QVariantList(), "", "", SettingValue::Nothing );
     connect( m_settings, &Settings::postLoad, this, &MainWorkflow::postLoad, Qt::DirectConnection );
     connect( m_settings, &Settings::preSave, this, &MainWorkflow::preSave, Qt::DirectConnection );
+    // Binary projects build the timeline while they're read, the rest goes through postLoad()
+    m_settings->setRecordHandler( { QStringLiteral( "tracks" ), QStringLiteral( "clips" ) },
+                                  [this]( const QVariant& var ) {
+        m_sequenceWorkflow->loadClip( var.toMap() );
+    } );
+    m_settings->setRecordHandler( { QStringLiteral( "tracks" ), QStringLiteral( "transitions" ) },
+                                  [this]( const QVariant& var ) {
+        m_sequenceWorkflow->loadTransition( var.toMap() );
+    } );
     projectSettings->addSettings( QStringLiteral( "Workspace" ), *m_settings );
 
     connect( m_undoStack.get(), &Commands::AbstractUndoStack::cleanChanged, this, &MainWorkflow::cleanChanged );
+
+    m_journal.reset( new Journal( m_sequenceWorkflow.get(), m_settings ) );
+    connect( m_undoStack.get(), &Commands::AbstractUndoStack::indexChanged,
+             m_journal.get(), &Journal::commandDone );
+    connect( m_undoStack.get(), &Commands::AbstractUndoStack::indexChanged, this, [this]{ ++m_editCount; } );
 }
 
 MainWorkflow::~MainWorkflow()
@@ -113,10 +160,21 @@ MainWorkflow::unmuteClip( const QUuid& uuid, unsigned int trackId )
     // TODO
 }
 
-void
+bool
 MainWorkflow::trigger( Commands::Generic* command )
 {
+    // Commands targeting an unknown clip or transition are invalid as soon as built
+    if ( command->isValid() == false )
+    {
+        delete command;
+        return false;
+    }
+    // The command is deleted by the push when it's merged into the previous one
+    bool valid = true;
+    auto connection = connect( command, &Commands::Generic::invalidated, [&valid]{ valid = false; } );
     m_undoStack->push( command );
+    disconnect( connection );
+    return valid;
 }
 
 void
@@ -138,6 +196,24 @@ MainWorkflow::setPosition( qint64 newFrame )
     m_renderer->setPosition( newFrame );
 }
 
+void
+MainWorkflow::beginScrub()
+{
+    m_renderer->beginScrub();
+}
+
+void
+MainWorkflow::scrub( qint64 newFrame )
+{
+    m_renderer->scrub( newFrame );
+}
+
+void
+MainWorkflow::endScrub( qint64 newFrame )
+{
+    m_renderer->endScrub( newFrame );
+}
+
 void
 MainWorkflow::setFps( double fps )
 {
@@ -179,12 +255,30 @@ MainWorkflow::renderer()
     return m_renderer;
 }
 
+Backend::IInput*
+MainWorkflow::input()
+{
+    return m_sequenceWorkflow->input();
+}
+
+quint64
+MainWorkflow::editCount() const
+{
+    return m_editCount;
+}
+
 Commands::AbstractUndoStack*
 MainWorkflow::undoStack()
 {
     return m_undoStack.get();
 }
 
+Journal*
+MainWorkflow::journal()
+{
+    return m_journal.get();
+}
+
 int
 MainWorkflow::getTrackCount() const
 {
@@ -197,12 +291,12 @@ MainWorkflow::trackCount() const
     return m_trackCount;
 }
 
-void
+bool
 MainWorkflow::addClip( const QString& uuid, quint32 trackId, qint32 pos )
 {
     vlmcDebug() << "Adding clip:" << uuid;
     auto command = new Commands::Clip::Add( m_sequenceWorkflow, uuid, trackId, pos );
-    trigger( command );
+    return trigger( command );
 }
 
 QJsonObject
@@ -257,40 +351,40 @@ MainWorkflow::transitionInfo( const QString& uuid )
     return QJsonObject::fromVariantHash( t->toVariant().toHash() );
 }
 
-void
+bool
 MainWorkflow::moveClip( const QString& uuid, quint32 trackId, qint64 startFrame )
 {
-    trigger( new Commands::Clip::Move( m_sequenceWorkflow, uuid, trackId, startFrame ) );
+    return trigger( new Commands::Clip::Move( m_sequenceWorkflow, uuid, trackId, startFrame ) );
 }
 
-void
+bool
 MainWorkflow::resizeClip( const QString& uuid, qint64 newBegin, qint64 newEnd, qint64 newPos )
 {
-    trigger( new Commands::Clip::Resize( m_sequenceWorkflow, uuid, newBegin, newEnd, newPos ) );
+    return trigger( new Commands::Clip::Resize( m_sequenceWorkflow, uuid, newBegin, newEnd, newPos ) );
 }
 
-void
+bool
 MainWorkflow::removeClip( const QString& uuid )
 {
-    trigger( new Commands::Clip::Remove( m_sequenceWorkflow, uuid ) );
+    return trigger( new Commands::Clip::Remove( m_sequenceWorkflow, uuid ) );
 }
 
-void
+bool
 MainWorkflow::splitClip( const QUuid& uuid, qint64 newClipPos, qint64 newClipBegin )
 {
-    trigger( new Commands::Clip::Split( m_sequenceWorkflow, uuid, newClipPos, newClipBegin ) );
+    return trigger( new Commands::Clip::Split( m_sequenceWorkflow, uuid, newClipPos, newClipBegin ) );
 }
 
-void
+bool
 MainWorkflow::linkClips( const QString& uuidA, const QString& uuidB )
 {
-    trigger( new Commands::Clip::Link( m_sequenceWorkflow, uuidA, uuidB ) );
+    return trigger( new Commands::Clip::Link( m_sequenceWorkflow, uuidA, uuidB ) );
 }
 
-void
+bool
 MainWorkflow::unlinkClips( const QString& uuidA, const QString& uuidB )
 {
-    trigger( new Commands::Clip::Unlink( m_sequenceWorkflow, uuidA, uuidB ) );
+    return trigger( new Commands::Clip::Unlink( m_sequenceWorkflow, uuidA, uuidB ) );
 }
 
 QString
@@ -337,87 +431,231 @@ MainWorkflow::addTransitionBetweenTracks( const QString& identifier, qint64 begi
     return command->uuid().toString();
 }
 
-void
+bool
 MainWorkflow::moveTransition( const QUuid& uuid, qint64 begin, qint64 end )
 {
-    trigger( new Commands::Transition::Move( m_sequenceWorkflow, uuid, begin, end ) );
+    return trigger( new Commands::Transition::Move( m_sequenceWorkflow, uuid, begin, end ) );
 }
 
-void
+bool
 MainWorkflow::moveTransitionBetweenTracks( const QUuid& uuid, quint32 trackAId, quint32 trackBId )
 {
-    trigger( new Commands::Transition::MoveBetweenTracks( m_sequenceWorkflow, uuid, trackAId, trackBId ) );
+    return trigger( new Commands::Transition::MoveBetweenTracks( m_sequenceWorkflow, uuid, trackAId, trackBId ) );
 }
 
-void
+bool
 MainWorkflow::removeTransition( const QUuid& uuid )
 {
-    trigger( new Commands::Transition::Remove( m_sequenceWorkflow, uuid ) );
+    return trigger( new Commands::Transition::Remove( m_sequenceWorkflow, uuid ) );
 }
 
 bool
 MainWorkflow::startRenderToFile( const QString &outputFileName, quint32 width, quint32 height,
                                  double fps, const QString &ar, quint32 vbitrate, quint32 abitrate,
                                  quint32 nbChannels, quint32 sampleRate )
+{
+    Workflow::OutputSettings    settings;
+    settings.fileName = outputFileName;
+    settings.width = width;
+    settings.height = height;
+    settings.fps = fps;
+    settings.aspectRatio = ar;
+    settings.videoBitrate = vbitrate;
+    settings.audioBitrate = abitrate;
+    settings.nbChannels = nbChannels;
+    settings.sampleRate = sampleRate;
+    return startRenderToFiles( { settings } );
+}
+
+static void
+configureOutput( Backend::MLT::MLTFFmpegOutput& output, const Workflow::OutputSettings& settings )
+{
+    output.setTarget( qPrintable( settings.fileName ) );
+    output.setWidth( settings.width );
+    output.setHeight( settings.height );
+    output.setFrameRate( settings.fps * 100, 100 );
+    auto temp = settings.aspectRatio.split( "/" );
+    if ( temp.size() == 2 )
+        output.setAspectRatio( temp[0].toInt(), temp[1].toInt() );
+    output.setVideoBitrate( settings.videoBitrate );
+    output.setAudioBitrate( settings.audioBitrate );
+    output.setChannels( settings.nbChannels );
+    output.setAudioSampleRate( settings.sampleRate );
+}
+
+std::unique_ptr<Backend::MLT::MLTOutput>
+MainWorkflow::createOutput( const QList<Workflow::OutputSettings>& outputs ) const
+{
+    if ( outputs.isEmpty() == true )
+        return {};
+    for ( const auto& settings : outputs )
+    {
+        // Nested encoders are all fed at the timeline pace, they can't resample time.
+        if ( qFuzzyCompare( settings.fps, outputs.first().fps ) == false )
+        {
+            vlmcWarning() << "Can't render" << settings.fileName << "at" << settings.fps
+                          << "fps along with outputs at" << outputs.first().fps << "fps";
+            return {};
+        }
+    }
+
+    if ( outputs.size() == 1 )
+    {
+        auto ffmpegOutput = new Backend::MLT::MLTFFmpegOutput;
+        configureOutput( *ffmpegOutput, outputs.first() );
+        return std::unique_ptr<Backend::MLT::MLTOutput>( ffmpegOutput );
+    }
+    auto multiOutput = new Backend::MLT::MLTMultiOutput;
+    for ( const auto& settings : outputs )
+    {
+        Backend::MLT::MLTFFmpegOutput   ffmpegOutput;
+        configureOutput( ffmpegOutput, settings );
+        multiOutput->addOutput( ffmpegOutput );
+    }
+    return std::unique_ptr<Backend::MLT::MLTOutput>( multiOutput );
+}
+
+bool
+MainWorkflow::startRenderToFiles( const QList<Workflow::OutputSettings>& outputs )
 {
     m_renderer->stop();
 
     if ( canRender() == false )
         return false;
 
-    Backend::MLT::MLTFFmpegOutput output;
+    auto output = createOutput( outputs );
+    if ( output == nullptr )
+        return false;
+
     auto input = m_sequenceWorkflow->input();
+    Tracer::Session               traceSession;
     OutputEventWatcher            cEventWatcher;
-    output.setCallback( &cEventWatcher );
-    output.setTarget( qPrintable( outputFileName ) );
-    output.setWidth( width );
-    output.setHeight( height );
-    output.setFrameRate( fps * 100, 100 );
-    auto temp = ar.split( "/" );
-    output.setAspectRatio( temp[0].toInt(), temp[1].toInt() );
-    output.setVideoBitrate( vbitrate );
-    output.setAudioBitrate( abitrate );
-    output.setChannels( nbChannels );
-    output.setAudioSampleRate( sampleRate );
-    output.connect( *input );
+    output->setCallback( &cEventWatcher );
+    output->connect( *input );
 
 #ifdef HAVE_GUI
+    QStringList     fileNames;
+    for ( const auto& settings : outputs )
+        fileNames << settings.fileName;
+    // The preview shows the first output, the others only differ by their encoding.
+    // Frames are copied by the output once encoded, nothing is pulled from the timeline.
+    const auto scale = qMin( 1.0, 480.0 / outputs.first().width );
+    const int width = qRound( outputs.first().width * scale );
+    const int height = qRound( outputs.first().height * scale );
+    FrameMailbox<Backend::VideoFrame>   previewTap;
+    output->setFrameTap( &previewTap, width, height, 1000 );
     WorkflowFileRendererDialog  dialog( width, height );
     dialog.setModal( true );
-    dialog.setOutputFileName( outputFileName );
+    dialog.setOutputFileName( fileNames.join( QStringLiteral( ", " ) ) );
     connect( this, &MainWorkflow::frameChanged, &dialog, &WorkflowFileRendererDialog::frameChanged );
-    connect( &dialog, &WorkflowFileRendererDialog::stop, this, [&output]{ output.stop(); } );
-    connect( m_renderer->eventWatcher().data(), &RendererEventWatcher::positionChanged, &dialog,
-             [this, input, &dialog, width, height]( qint64 pos )
-    {
-        // Update the preview per five seconds
-        if ( pos % qRound( input->fps() * 5 ) == 0 )
-        {
-            dialog.updatePreview( input->image( width, height ) );
-        }
-    });
+    connect( &dialog, &WorkflowFileRendererDialog::stop, this, [&output]{ output->stop(); } );
+    QTimer          previewTimer;
+    connect( &previewTimer, &QTimer::timeout, &dialog, [&previewTap, &dialog]{
+        auto frame = previewTap.take();
+        if ( frame == nullptr )
+            return;
+        auto f = frame.release();
+        dialog.updatePreview( QImage( f->pixels.data(), f->width, f->height, QImage::Format_RGBA8888,
+                                      []( void* p ) { delete static_cast<Backend::VideoFrame*>( p ); }, f ) );
+    } );
+    previewTimer.start( 1000 );
     connect( &cEventWatcher, &OutputEventWatcher::stopped, &dialog, &WorkflowFileRendererDialog::accept );
 #endif
 
     input->setPosition( 0 );
-    output.start();
+    output->start();
 
 #ifdef HAVE_GUI
-    if ( dialog.exec() == QDialog::Rejected )
+    auto res = dialog.exec();
+    // The preview mailbox goes away with this scope, before the output does. Stopping
+    // is a no-op unless the dialog was rejected.
+    output->stop();
+    output->setFrameTap( nullptr, 0, 0, 0 );
+    if ( res == QDialog::Rejected )
         return false;
 #else
-    while ( output.isStopped() == false )
+    while ( output->isStopped() == false )
         SleepS( 1 );
 #endif
     return true;
 }
 
+bool
+MainWorkflow::renderToFiles( const QList<Workflow::OutputSettings>& outputs, qint64 begin, qint64 end )
+{
+    m_renderer->stop();
+
+    auto input = m_sequenceWorkflow->input();
+    if ( begin < 0 || end < begin || end >= input->playableLength() )
+        return false;
+
+    auto output = createOutput( outputs );
+    if ( output == nullptr )
+        return false;
+
+    // Render through a cut so the timeline boundaries are left untouched. Positions are
+    // still reported by the timeline itself, in absolute frames.
+    auto range = input->cut( begin, end );
+    QStringList files;
+    for ( const auto& settings : outputs )
+        files << settings.fileName;
+    emit renderStarted( files, begin, end );
+    Tracer::Session               traceSession;
+    OutputEventWatcher            cEventWatcher;
+    QEventLoop                    loop;
+    bool                          error = false;
+    connect( &cEventWatcher, &OutputEventWatcher::stopped, &loop, &QEventLoop::quit, Qt::QueuedConnection );
+    connect( &cEventWatcher, &OutputEventWatcher::errorEncountered, &loop, [&loop, &error]{
+        error = true;
+        loop.quit();
+    }, Qt::QueuedConnection );
+    output->setCallback( &cEventWatcher );
+    output->connect( *range );
+
+    range->setPosition( 0 );
+    output->start();
+    if ( output->isStopped() == false )
+        loop.exec();
+    output->stop();
+    return error == false && input->frame() >= end;
+}
+
+QByteArray
+MainWorkflow::graphHash() const
+{
+    QCryptographicHash  hash( QCryptographicHash::Sha1 );
+    // The sequence only refers to library clips by uuid, so include what they point to
+    auto sequence = m_sequenceWorkflow->toVariant().toHash();
+    QVariantList clips;
+    for ( const auto& c : sequence["clips"].toList() )
+    {
+        auto h = c.toHash();
+        auto clip = Core::instance()->library()->clip( h["clipUuid"].toUuid() );
+        if ( clip != nullptr )
+        {
+            h["mrl"] = clip->media()->mrl();
+            h["begin"] = clip->begin();
+            h["end"] = clip->end();
+        }
+        clips << h;
+    }
+    sequence["clips"] = clips;
+    hash.addData( QJsonDocument::fromVariant( sequence ).toJson( QJsonDocument::Compact ) );
+    return hash.result().toHex();
+}
+
 bool
 MainWorkflow::canRender()
 {
     return m_sequenceWorkflow->input()->playableLength() > 0;
 }
 
+qint64
+MainWorkflow::playableLength() const
+{
+    return m_sequenceWorkflow->input()->playableLength();
+}
+
 void
 MainWorkflow::preSave()
 {
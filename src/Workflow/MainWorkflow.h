@@ -37,7 +37,9 @@
 class   Clip;
 class   EffectsEngine;
 class   Effect;
+class   Journal;
 class   AbstractRenderer;
+class   Prefetcher;
 class   SequenceWorkflow;
 
 namespace Commands
@@ -50,13 +52,19 @@ namespace Backend
 {
 class IMultiTrack;
 class IInput;
+namespace MLT
+{
+class MLTOutput;
+}
 }
 
 class   Settings;
 
 #include <QObject>
 #include <QUuid>
+#include <QList>
 #include <QMap>
+#include <QStringList>
 
 /**
  *  \class  Represent the Timeline backend.
@@ -120,7 +128,7 @@ class   MainWorkflow : public QObject
         quint32                 trackCount() const;
 
         Q_INVOKABLE
-        void                    addClip( const QString& uuid, quint32 trackId, qint32 pos );
+        bool                    addClip( const QString& uuid, quint32 trackId, qint32 pos );
 
         Q_INVOKABLE
         QJsonObject             clipInfo( const QString& uuid );
@@ -132,23 +140,23 @@ class   MainWorkflow : public QObject
         QJsonObject             transitionInfo( const QString& uuid );
 
         Q_INVOKABLE
-        void                    moveClip( const QString& uuid, quint32 trackId, qint64 startFrame );
+        bool                    moveClip( const QString& uuid, quint32 trackId, qint64 startFrame );
 
         Q_INVOKABLE
-        void                    resizeClip( const QString& uuid, qint64 newBegin,
+        bool                    resizeClip( const QString& uuid, qint64 newBegin,
                                             qint64 newEnd, qint64 newPos );
 
         Q_INVOKABLE
-        void                    removeClip( const QString& uuid );
+        bool                    removeClip( const QString& uuid );
 
         Q_INVOKABLE
-        void                    splitClip( const QUuid& uuid, qint64 newClipPos, qint64 newClipBegin );
+        bool                    splitClip( const QUuid& uuid, qint64 newClipPos, qint64 newClipBegin );
 
         Q_INVOKABLE
-        void                    linkClips( const QString& uuidA, const QString& uuidB );
+        bool                    linkClips( const QString& uuidA, const QString& uuidB );
 
         Q_INVOKABLE
-        void                    unlinkClips( const QString& uuidA, const QString& uuidB );
+        bool                    unlinkClips( const QString& uuidA, const QString& uuidB );
 
         Q_INVOKABLE
         QString                 addEffect( const QString& clipUuid, const QString& effectId );
@@ -162,27 +170,88 @@ class   MainWorkflow : public QObject
                                                quint32 trackAId, quint32 trackBId, const QString& type );
 
         Q_INVOKABLE
-        void                    moveTransition( const QUuid& uuid, qint64 begin, qint64 end );
+        bool                    moveTransition( const QUuid& uuid, qint64 begin, qint64 end );
 
         Q_INVOKABLE
-        void                    moveTransitionBetweenTracks( const QUuid& uuid, quint32 trackAId, quint32 trackBId );
+        bool                    moveTransitionBetweenTracks( const QUuid& uuid, quint32 trackAId, quint32 trackBId );
 
         Q_INVOKABLE
-        void                    removeTransition( const QUuid& uuid );
+        bool                    removeTransition( const QUuid& uuid );
 
         bool                    startRenderToFile( const QString& outputFileName, quint32 width, quint32 height,
                                                    double fps, const QString& ar, quint32 vbitrate, quint32 abitrate,
                                                    quint32 nbChannels, quint32 sampleRate );
 
+        /**
+         *  \brief      Render the timeline to several files at once.
+         *
+         *  The timeline is decoded and composited once, and every frame is then handed
+         *  to one encoder per output, each of them scaling it to its own size.
+         *  All outputs must share the same frame rate.
+         *  \param  outputs     The files to render. Must not be empty.
+         *  \return             true if the render completed.
+         */
+        bool                    startRenderToFiles( const QList<Workflow::OutputSettings>& outputs );
+
+        /**
+         *  \brief      Synchronously render a range of the timeline, without any UI.
+         *
+         *  \param  outputs     The files to render. Must not be empty.
+         *  \param  begin       The first frame to render
+         *  \param  end         The last frame to render (included)
+         *  \return             true if the whole range was rendered, false if the render
+         *                      failed or was interrupted.
+         */
+        bool                    renderToFiles( const QList<Workflow::OutputSettings>& outputs,
+                                               qint64 begin, qint64 end );
+
+        /**
+         *  \brief      Returns a hash identifying the rendered content of the timeline.
+         *
+         *  Two timelines with the same hash produce the same frames. This covers the
+         *  clips, their boundaries and media, the transitions and the effects.
+         */
+        QByteArray              graphHash() const;
+
         bool                    canRender();
 
-        void                    trigger( Commands::Generic* command );
+        /**
+         *  \brief      Returns the length of the timeline, in frames.
+         */
+        qint64                  playableLength() const;
+
+        /**
+         *  \brief     Push the command to the undo stack, which applies it.
+         *
+         *  A command which is invalid already is deleted instead of being pushed.
+         *  \return    false if the command couldn't be applied
+         */
+        bool                    trigger( Commands::Generic* command );
 
         AbstractRenderer*       renderer();
 
+        /**
+         *  \brief      The whole timeline, as rendered by the renderer and the outputs
+         */
+        Backend::IInput*        input();
+
         Commands::AbstractUndoStack*       undoStack();
+        /**
+         *  \brief      Counts the commands pushed, undone and redone so far.
+         *
+         *  Tells whether the timeline changed since a given time, including when a
+         *  command was merged into the previous one, which leaves the index as it was.
+         */
+        quint64                 editCount() const;
+
+        /**
+         *  \brief      The journal of the timeline edits, see Project
+         */
+        Journal*                journal();
 
     private:
+        std::unique_ptr<Backend::MLT::MLTOutput>    createOutput(
+                                            const QList<Workflow::OutputSettings>& outputs ) const;
 
         void                    preSave();
         void                    postLoad();
@@ -196,6 +265,9 @@ class   MainWorkflow : public QObject
 
         std::unique_ptr<Commands::AbstractUndoStack> m_undoStack;
         std::shared_ptr<SequenceWorkflow>            m_sequenceWorkflow;
+        std::unique_ptr<Prefetcher>                  m_prefetcher;
+        std::unique_ptr<Journal>                     m_journal;
+        quint64                                      m_editCount;
     public slots:
         /**
          *  \brief      Clear the workflow.
@@ -212,6 +284,13 @@ class   MainWorkflow : public QObject
 
         void                            setPosition( qint64 newFrame );
 
+        /**
+         *  \brief      Drag the playhead, see AbstractRenderer::beginScrub()
+         */
+        void                            beginScrub();
+        void                            scrub( qint64 newFrame );
+        void                            endScrub( qint64 newFrame );
+
         void                            setFps( double fps );
 
         // FIXME: We can't use #ifdef HAVE_GUI here because qml files can't find them
@@ -258,6 +337,13 @@ class   MainWorkflow : public QObject
 
         void                    fpsChanged( double fps );
 
+        /**
+         *  \brief  Emitted by renderToFiles() before it renders a range of the timeline.
+         *
+         *  \param  files   The files this pass writes
+         */
+        void                    renderStarted( const QStringList& files, qint64 begin, qint64 end );
+
         void                    cleanChanged( bool isClean );
 
         void                    clipAdded( const QString& uuid );
@@ -0,0 +1,174 @@
+/*****************************************************************************
+ * Prefetcher.cpp: Opens the upcoming clips ahead of the playhead
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "Prefetcher.h"
+#include "SequenceWorkflow.h"
+#include "Backend/IBackend.h"
+#include "Backend/IInput.h"
+#include "Backend/IProfile.h"
+#include "Media/Clip.h"
+#include "Media/Media.h"
+#include "Renderer/AbstractRenderer.h"
+#include "Tools/PerfCounters.h"
+
+#include <QHash>
+#include <QMutexLocker>
+
+// How far ahead of the playhead clips get prefetched, in seconds
+static const int        LookAhead = 5;
+// Enough to cover the read ahead of the consumer when the clip starts
+static const int64_t    NbPrefetchedFrames = 5;
+
+Prefetcher::Prefetcher( SequenceWorkflow* sequence, AbstractRenderer* renderer, QObject* parent )
+    : QThread( parent )
+    , m_sequence( sequence )
+    , m_renderer( renderer )
+    , m_lastPosition( -1 )
+    , m_stop( false )
+{
+    start( QThread::LowPriority );
+}
+
+Prefetcher::~Prefetcher()
+{
+    {
+        QMutexLocker lock( &m_mutex );
+        m_stop = true;
+        m_jobs.clear();
+    }
+    m_cond.wakeAll();
+    wait();
+}
+
+void
+Prefetcher::positionChanged( qint64 position )
+{
+    const auto fps = Backend::instance()->profile().fps();
+    // Seeking back, or far ahead, invalidates what was decoded so far
+    const bool seeked = m_lastPosition < 0 || position < m_lastPosition ||
+            position - m_lastPosition > fps * LookAhead;
+    if ( seeked == true )
+        m_prefetched.clear();
+    // There's no need to look for new clips on every frame
+    else if ( m_lastPosition >= 0 && position - m_lastPosition < fps / 2 )
+        return;
+    m_lastPosition = position;
+
+    // Seeking a source which is being played would only make the playback stall
+    QSet<Media*> playing;
+    QSet<QPair<Media*, qint64>> reached;
+    for ( const auto& c : m_sequence->clipsAt( position ) )
+    {
+        auto media = c->clip->media().data();
+        const auto key = qMakePair( media, c->clip->input()->begin() );
+        playing.insert( media );
+        reached.insert( key );
+        // Clips the playback reached since the last check, rather than landed on by seeking
+        if ( seeked == false && m_reached.contains( key ) == false )
+            PerfCounters::add( m_prefetched.contains( key ) == true ?
+                                   PerfCounters::PrefetchHits : PerfCounters::PrefetchMisses );
+    }
+    m_reached = std::move( reached );
+
+    std::deque<Job> jobs;
+    const auto clips = m_sequence->clipsStartingBetween( position + 1, position + qRound64( fps * LookAhead ) );
+    // Seeking a source once the playback reached it would stall it as well
+    QHash<Media*, qint64> firstStart;
+    for ( const auto& c : clips )
+    {
+        auto media = c->clip->media().data();
+        auto it = firstStart.find( media );
+        if ( it == firstStart.end() || c->pos < it.value() )
+            firstStart[media] = c->pos;
+    }
+    const auto size = m_renderer->frameSize();
+    for ( const auto& c : clips )
+    {
+        auto media = c->clip->media().data();
+        auto input = c->clip->input();
+        // Linked audio & video clips share their source
+        const auto key = qMakePair( media, input->begin() );
+        if ( playing.contains( media ) == true || m_prefetched.contains( key ) == true )
+            continue;
+        m_prefetched.insert( key );
+        // Use a separate cut, so the position of the one in the track isn't altered
+        Job job;
+        job.input = input->cut( input->begin(), input->end() );
+        job.size = size;
+        job.from = position;
+        job.until = firstStart[media];
+        jobs.push_back( std::move( job ) );
+    }
+    if ( jobs.empty() == true )
+        return;
+
+    QMutexLocker lock( &m_mutex );
+    for ( auto& j : jobs )
+        m_jobs.push_back( std::move( j ) );
+    m_cond.wakeAll();
+}
+
+void
+Prefetcher::reset()
+{
+    m_prefetched.clear();
+    m_reached.clear();
+    m_lastPosition = -1;
+}
+
+void
+Prefetcher::run()
+{
+    QMutexLocker lock( &m_mutex );
+    while ( m_stop == false )
+    {
+        if ( m_jobs.empty() == true )
+        {
+            m_cond.wait( &m_mutex );
+            continue;
+        }
+        auto job = std::move( m_jobs.front() );
+        m_jobs.pop_front();
+        lock.unlock();
+        job.input->prefetch( NbPrefetchedFrames, job.size.width(), job.size.height(),
+                             *m_sequence->input(), [this, &job]{ return isCancelled( job ); } );
+        job.input.reset();
+        lock.relock();
+    }
+}
+
+// Called while holding the sequence, so its position can't change meanwhile
+bool
+Prefetcher::isCancelled( const Job& job )
+{
+    {
+        QMutexLocker lock( &m_mutex );
+        if ( m_stop == true )
+            return true;
+    }
+    const auto position = m_sequence->input()->position();
+    return position < job.from || position >= job.until;
+}
@@ -0,0 +1,98 @@
+/*****************************************************************************
+ * Prefetcher.h: Opens the upcoming clips ahead of the playhead
+ *****************************************************************************
+ * Copyright (C) 2008-2016 VideoLAN
+ *
+ * Authors: Hugo Beauzée-Luyssen <hugo@beauzee.fr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef PREFETCHER_H
+#define PREFETCHER_H
+
+#include <QMutex>
+#include <QPair>
+#include <QSet>
+#include <QSize>
+#include <QThread>
+#include <QWaitCondition>
+
+#include <deque>
+#include <memory>
+
+class AbstractRenderer;
+class Media;
+class SequenceWorkflow;
+
+namespace Backend
+{
+class IInput;
+}
+
+/**
+ *  \brief  Prepares the clips the playhead is about to reach.
+ *
+ *  The producer of a clip is only opened and seeked once the playlist reaches it,
+ *  which stalls the playback at cuts between different files. While the sequence
+ *  plays, the clips starting in the next few seconds are opened, seeked and get
+ *  their first frames decoded on a worker thread, so they're ready when needed.
+ *  The frames are decoded at the size the preview asks for, between two of its frames,
+ *  and only until the playhead reaches a clip of the same source, or moves back.
+ */
+class Prefetcher : public QThread
+{
+    Q_OBJECT
+
+    public:
+        Prefetcher( SequenceWorkflow* sequence, AbstractRenderer* renderer, QObject* parent = nullptr );
+        ~Prefetcher();
+
+    public slots:
+        void            positionChanged( qint64 position );
+        /// Forgets which clips were prefetched, after the sequence changed
+        void            reset();
+
+    protected:
+        virtual void    run() override;
+
+    private:
+        struct Job
+        {
+            std::unique_ptr<Backend::IInput>    input;
+            QSize                               size;
+            // The prefetch is useless once the playhead leaves [from, until[
+            qint64                              from;
+            qint64                              until;
+        };
+
+        bool            isCancelled( const Job& job );
+
+    private:
+        SequenceWorkflow*       m_sequence;
+        AbstractRenderer*       m_renderer;
+        // Only used from the thread the prefetcher belongs to
+        qint64                  m_lastPosition;
+        QSet<QPair<Media*, qint64>>     m_prefetched;
+        // The clips under the playhead at the last check
+        QSet<QPair<Media*, qint64>>     m_reached;
+
+        QMutex                  m_mutex;
+        QWaitCondition          m_cond;
+        std::deque<Job>         m_jobs;
+        bool                    m_stop;
+};
+
+#endif // PREFETCHER_H
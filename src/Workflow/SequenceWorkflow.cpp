@@ -37,6 +37,37 @@
 #include "Media/Media.h"
 #include "Transition/Transition.h"
 
+namespace
+{
+
+/*
+ * Edits the tracks while the preview may be playing them. The consumer gets its frames
+ * either before or after the edit, never from a half-applied one. Signals must be
+ * emitted once the edit is over, as they may run for a while.
+ */
+class GraphEdit
+{
+public:
+    explicit GraphEdit( Backend::IMultiTrack& multitrack )
+        : m_multitrack( multitrack )
+    {
+        m_multitrack.beginEdit();
+    }
+
+    ~GraphEdit()
+    {
+        m_multitrack.endEdit();
+    }
+
+    GraphEdit( const GraphEdit& ) = delete;
+    GraphEdit& operator=( const GraphEdit& ) = delete;
+
+private:
+    Backend::IMultiTrack&   m_multitrack;
+};
+
+}
+
 SequenceWorkflow::SequenceWorkflow( size_t trackCount )
     : m_multitrack( new Backend::MLT::MLTMultiTrack )
     , m_trackCount( trackCount )
@@ -70,7 +101,11 @@ SequenceWorkflow::addClip( QSharedPointer<::Clip> clip, quint32 trackId, qint64
     auto c = QSharedPointer<ClipInstance>::create( clip,
                                            uuid.isNull() == true ? QUuid::createUuid() : uuid,
                                            trackId, pos, isAudioClip );
-    auto ret = t->addClip( c, pos );
+    bool ret;
+    {
+        GraphEdit edit( *m_multitrack );
+        ret = t->addClip( c, pos );
+    }
     if ( ret == false )
         return {};
     vlmcDebug() << "adding" << (isAudioClip ? "audio" : "video") <<  "clip instance:" << c->uuid;
@@ -99,14 +134,16 @@ SequenceWorkflow::moveClip( const QUuid& uuid, quint32 trackId, qint64 pos )
     {
         // Don't call removeClip/addClip as they would destroy & recreate clip instances for nothing.
         // Simply fiddle with the track to move the clip around
-        t->removeClip( uuid );
         auto newTrack = track( trackId, c->isAudio );
+        GraphEdit edit( *m_multitrack );
+        t->removeClip( uuid );
         if ( newTrack->addClip( c, pos ) == false )
             return false;
         c->trackId = trackId;
     }
     else
     {
+        GraphEdit edit( *m_multitrack );
         bool ret = t->moveClip( c->uuid, pos );
         if ( ret == false )
             return false;
@@ -135,11 +172,15 @@ SequenceWorkflow::resizeClip( const QUuid& uuid, qint64 newBegin, qint64 newEnd,
     if ( c->duplicateClipForResize( newBegin, newEnd ) == true )
     {
         vlmcDebug() << "Duplicating clip for resize" << c->uuid << "is now using" << c->clip->uuid();
+        GraphEdit edit( *m_multitrack );
         t->removeClip( uuid );
         ret = t->addClip( c, position );
     }
     else
+    {
+        GraphEdit edit( *m_multitrack );
         ret = t->resizeClip( uuid, newBegin, newEnd, newPos );
+    }
     if ( ret == false )
         return false;
     c->pos = newPos;
@@ -161,7 +202,10 @@ SequenceWorkflow::removeClip( const QUuid& uuid )
     auto clip = c->clip;
     auto trackId = c->trackId;
     auto t = track( trackId, c->isAudio );
-    t->removeClip( uuid );
+    {
+        GraphEdit edit( *m_multitrack );
+        t->removeClip( uuid );
+    }
     m_clips.erase( it );
     clip->disconnect( this );
     bool onTimeline = false;
@@ -223,7 +267,10 @@ SequenceWorkflow::addTransition( const QString& identifier, qint64 begin, qint64
 {
     auto t = track( trackId, type == Workflow::AudioTrack );
     auto transition = QSharedPointer<Transition>::create( identifier, begin, end, type );
-    t->addTransition( transition );
+    {
+        GraphEdit edit( *m_multitrack );
+        t->addTransition( transition );
+    }
     m_transitions.insert( transition->uuid(), QSharedPointer<TransitionInstance>::create( transition, trackId, 0, true ) );
     emit transitionAdded( transition->uuid().toString() );
     return transition->uuid();
@@ -236,7 +283,10 @@ SequenceWorkflow::addTransitionBetweenTracks( const QString& identifier, qint64
 {
     auto transition = QSharedPointer<Transition>::create( identifier, begin, end, type );
     m_transitions.insert( transition->uuid(), QSharedPointer<TransitionInstance>::create( transition, trackAId, trackBId, false ) );
-    transition->apply( *m_multitrack, trackAId, trackBId );
+    {
+        GraphEdit edit( *m_multitrack );
+        transition->apply( *m_multitrack, trackAId, trackBId );
+    }
     emit transitionAdded( transition->uuid().toString() );
     return transition->uuid();
 }
@@ -245,10 +295,20 @@ bool
 SequenceWorkflow::addTransition( QSharedPointer<TransitionInstance> transitionInstance )
 {
     auto transition = transitionInstance->transition;
-    auto t = track( transitionInstance->trackAId, transition->type() == Workflow::AudioTrack );
     m_transitions.insert( transition->uuid(), transitionInstance );
+    bool ret = true;
+    {
+        GraphEdit edit( *m_multitrack );
+        if ( transitionInstance->isInTrack == true )
+        {
+            auto t = track( transitionInstance->trackAId, transition->type() == Workflow::AudioTrack );
+            ret = t->addTransition( transition );
+        }
+        else
+            transition->apply( *m_multitrack, transitionInstance->trackAId, transitionInstance->trackBId );
+    }
     emit transitionAdded( transition->uuid().toString() );
-    return t->addTransition( transition );
+    return ret;
 }
 
 bool
@@ -261,18 +321,19 @@ SequenceWorkflow::moveTransition( const QUuid& uuid, qint64 begin, qint64 end )
     auto transition = transitionInstance->transition;
     if ( transition->begin() == begin && transition->end() == end )
         return true;
-    if ( transitionInstance->isInTrack == true )
-    {
-        auto t = track( transitionInstance->trackAId, transition->type() == Workflow::AudioTrack );
-        emit transitionMoved( uuid.toString() );
-        return t->moveTransition( uuid, begin, end );
-    }
-    else
+    bool ret = true;
     {
-        transition->setBoundaries( begin, end );
-        emit transitionMoved( uuid.toString() );
-        return true;
+        GraphEdit edit( *m_multitrack );
+        if ( transitionInstance->isInTrack == true )
+        {
+            auto t = track( transitionInstance->trackAId, transition->type() == Workflow::AudioTrack );
+            ret = t->moveTransition( uuid, begin, end );
+        }
+        else
+            transition->setBoundaries( begin, end );
     }
+    emit transitionMoved( uuid.toString() );
+    return ret;
 }
 
 bool
@@ -287,7 +348,10 @@ SequenceWorkflow::moveTransitionBetweenTracks( const QUuid& uuid, quint32 trackA
     auto transition = transitionInstance->transition;
     if ( transitionInstance->trackAId == trackAId && transitionInstance->trackBId == trackBId )
         return true;
-    transition->setTracks( trackAId, trackBId );
+    {
+        GraphEdit edit( *m_multitrack );
+        transition->setTracks( trackAId, trackBId );
+    }
     transitionInstance->trackAId = trackAId;
     transitionInstance->trackBId = trackBId;
     emit transitionMoved( uuid.toString() );
@@ -305,6 +369,7 @@ SequenceWorkflow::removeTransition( const QUuid& uuid )
     {
         auto transition = transitionInstance->transition;
         auto t = track( transitionInstance->trackAId, transition->type() == Workflow::AudioTrack );
+        GraphEdit edit( *m_multitrack );
         t->removeTransition( uuid );
     }
     m_transitions.erase( it );
@@ -346,49 +411,55 @@ void
 SequenceWorkflow::loadFromVariant( const QVariant& variant )
 {
     for ( auto& var : variant.toMap()["transitions"].toList() )
-    {
-        auto m = var.toMap();
-        bool inTrack = m["isInTrack"].toBool();
-        if ( inTrack == true )
-            addTransition( m["identifier"].toString(), m["begin"].toLongLong(), m["end"].toLongLong(),
-                    m["trackId"].toUInt(), m["audio"].toBool() ? Workflow::AudioTrack : Workflow::VideoTrack );
-        else
-            addTransitionBetweenTracks( m["identifier"].toString(), m["begin"].toLongLong(), m["end"].toLongLong(),
-                    m["trackAId"].toUInt(), m["trackBId"].toUInt(), m["audio"].toBool() ? Workflow::AudioTrack : Workflow::VideoTrack );
-    }
+        loadTransition( var.toMap() );
 
     for ( auto& var : variant.toMap()["clips"].toList() )
-    {
-        auto m = var.toMap();
-        auto clip = Core::instance()->library()->clip( m["clipUuid"].toUuid() );
+        loadClip( var.toMap() );
+    EffectHelper::loadFromVariant( variant.toMap()["filters"], m_multitrack.get() );
+}
 
-        if ( clip == nullptr )
-        {
-            vlmcCritical() << "Couldn't find an acceptable library clip to be added.";
-            continue;
-        }
+void
+SequenceWorkflow::loadTransition( const QVariantMap& m )
+{
+    bool inTrack = m["isInTrack"].toBool();
+    if ( inTrack == true )
+        addTransition( m["identifier"].toString(), m["begin"].toLongLong(), m["end"].toLongLong(),
+                m["trackId"].toUInt(), m["audio"].toBool() ? Workflow::AudioTrack : Workflow::VideoTrack );
+    else
+        addTransitionBetweenTracks( m["identifier"].toString(), m["begin"].toLongLong(), m["end"].toLongLong(),
+                m["trackAId"].toUInt(), m["trackBId"].toUInt(), m["audio"].toBool() ? Workflow::AudioTrack : Workflow::VideoTrack );
+}
 
-        Q_ASSERT( m.contains( "uuid" ) && m.contains( "isAudio" ) );
+void
+SequenceWorkflow::loadClip( const QVariantMap& m )
+{
+    auto clip = Core::instance()->library()->clip( m["clipUuid"].toUuid() );
 
-        auto uuid = m["uuid"].toUuid();
-        auto isAudio = m["isAudio"].toBool();
-        //FIXME: Add missing clip type handling. We don't know if we're adding an audio clip or not
-        addClip( clip, m["trackId"].toUInt(), m["position"].toLongLong(), uuid, isAudio );
-        auto c = m_clips[uuid];
+    if ( clip == nullptr )
+    {
+        vlmcCritical() << "Couldn't find an acceptable library clip to be added.";
+        return;
+    }
 
-        auto linkedClipsList = m["linkedClips"].toList();
-        for ( const auto& uuidVar : linkedClipsList )
-        {
-            auto linkedClipUuid = uuidVar.toUuid();
-            c->linkedClips.append( linkedClipUuid );
-            auto it = m_clips.find( linkedClipUuid );
-            if ( it != m_clips.end() )
-                emit clipLinked( uuid.toString(), linkedClipUuid.toString() );
-        }
+    Q_ASSERT( m.contains( "uuid" ) && m.contains( "isAudio" ) );
+
+    auto uuid = m["uuid"].toUuid();
+    auto isAudio = m["isAudio"].toBool();
+    //FIXME: Add missing clip type handling. We don't know if we're adding an audio clip or not
+    addClip( clip, m["trackId"].toUInt(), m["position"].toLongLong(), uuid, isAudio );
+    auto c = m_clips[uuid];
 
-        EffectHelper::loadFromVariant( m["filters"], clip->input() );
+    auto linkedClipsList = m["linkedClips"].toList();
+    for ( const auto& uuidVar : linkedClipsList )
+    {
+        auto linkedClipUuid = uuidVar.toUuid();
+        c->linkedClips.append( linkedClipUuid );
+        auto it = m_clips.find( linkedClipUuid );
+        if ( it != m_clips.end() )
+            emit clipLinked( uuid.toString(), linkedClipUuid.toString() );
     }
-    EffectHelper::loadFromVariant( variant.toMap()["filters"], m_multitrack.get() );
+
+    EffectHelper::loadFromVariant( m["filters"], clip->input() );
 }
 
 void
@@ -434,6 +505,30 @@ SequenceWorkflow::position( const QUuid& uuid )
     return it.value()->pos;
 }
 
+QList<QSharedPointer<SequenceWorkflow::ClipInstance>>
+SequenceWorkflow::clipsStartingBetween( qint64 from, qint64 to ) const
+{
+    QList<QSharedPointer<ClipInstance>> res;
+    for ( const auto& c : m_clips )
+    {
+        if ( c->pos >= from && c->pos < to )
+            res.append( c );
+    }
+    return res;
+}
+
+QList<QSharedPointer<SequenceWorkflow::ClipInstance>>
+SequenceWorkflow::clipsAt( qint64 position ) const
+{
+    QList<QSharedPointer<ClipInstance>> res;
+    for ( const auto& c : m_clips )
+    {
+        if ( c->pos <= position && position < c->pos + c->clip->length() )
+            res.append( c );
+    }
+    return res;
+}
+
 Backend::IInput*
 SequenceWorkflow::input()
 {
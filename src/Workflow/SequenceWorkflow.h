@@ -126,6 +126,10 @@ class SequenceWorkflow : public QObject
 
         QVariant                toVariant() const;
         void                    loadFromVariant( const QVariant& variant );
+        /// Load one of the "clips" of the variant returned by toVariant()
+        void                    loadClip( const QVariantMap& m );
+        /// Load one of the "transitions" of the variant returned by toVariant()
+        void                    loadTransition( const QVariantMap& m );
         void                    clear();
 
         QSharedPointer<ClipInstance>    clip( const QUuid& uuid );
@@ -133,6 +137,15 @@ class SequenceWorkflow : public QObject
         quint32                 trackId( const QUuid& uuid );
         qint64                  position( const QUuid& uuid );
 
+        /**
+         * @return  The clip instances starting in [from, to[, regardless of their track
+         */
+        QList<QSharedPointer<ClipInstance>>     clipsStartingBetween( qint64 from, qint64 to ) const;
+        /**
+         * @return  The clip instances covering \p position
+         */
+        QList<QSharedPointer<ClipInstance>>     clipsAt( qint64 position ) const;
+
         Backend::IInput*        input();
         Backend::IInput*        trackInput( quint32 trackId );
 
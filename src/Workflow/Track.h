@@ -28,6 +28,10 @@ public:
 
     Backend::IInput&        input();
 
+    /// The lowest internal track on which the clip fits at pos
+    quint32                 insertableTrackIndex( QSharedPointer<SequenceWorkflow::ClipInstance> clip,
+                                                  qint64 pos = -1, qint64 begin = -1, qint64 end = -1 );
+
 private:
     struct ClipInstance {
         ClipInstance() = default;
@@ -42,8 +46,6 @@ private:
 
     QSharedPointer<Backend::ITrack>               track( quint32 trackId );
     inline QSharedPointer<Backend::ITrack>        track( const QUuid& uuid );
-    quint32                 insertableTrackIndex( QSharedPointer<SequenceWorkflow::ClipInstance> clip,
-                                                  qint64 pos = -1, qint64 begin = -1, qint64 end = -1 );
 
     Workflow::TrackType                                                 m_type;
 
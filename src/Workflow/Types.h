@@ -24,6 +24,7 @@
 #define TYPES_H
 
 #include <qglobal.h>
+#include <QString>
 
 namespace   Workflow
 {
@@ -39,6 +40,25 @@ namespace   Workflow
         AudioTrack, ///< Represents an audio track
         NbTrackType, ///< Used to know how many types we have
     };
+
+    /**
+     *  \brief Describes one encoded file produced by an export.
+     *
+     *  Those are the parameters the FFmpeg output accepts. Several of them can be fed
+     *  by a single pass over the timeline, see MainWorkflow::startRenderToFiles()
+     */
+    struct  OutputSettings
+    {
+        QString     fileName;
+        quint32     width;
+        quint32     height;
+        double      fps;
+        QString     aspectRatio; ///< As "num/den"
+        quint32     videoBitrate; ///< In kbps
+        quint32     audioBitrate; ///< In kbps
+        quint32     nbChannels;
+        quint32     sampleRate;
+    };
 }
 
 namespace   Vlmc